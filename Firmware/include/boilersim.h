@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <OpenTherm.h>
+
+/*
+    Simulated OT slave (boiler) for loopback test mode. Replies to a connected
+    master like a boiler with a simple thermal model: the burner heats the water
+    of the CH circuit, which loses heat to the building. Values without a
+    simulation are taken from the loopback test data of OTITEMS, unknown IDs are
+    answered with UNKNOWN_DATA_ID.
+*/
+class BoilerSim {
+private:
+    static constexpr float MAX_POWER = 20.0;        // kW
+    static constexpr float MIN_MODULATION = 5.0;    // %
+    static constexpr float WATER_CAPACITY = 170.0;  // kJ/K, ~40 l water in boiler and CH circuit
+    static constexpr float HEAT_LOSS = 0.4;         // kW/K, CH circuit to room
+    static constexpr float DHW_CAPACITY = 600.0;    // kJ/K, ~150 l storage
+    static constexpr float DHW_LOSS = 0.005;        // kW/K
+    static constexpr float ROOM_TEMP = 20.0;
+    uint32_t lastUpdate {0};
+    uint8_t masterStatus {0};
+    float tSet {0};
+    float tSetCH2 {0};
+    float tdhwSet {50};
+    float flowTemp {ROOM_TEMP};
+    float flowTempCH2 {ROOM_TEMP};
+    float dhwTemp {45};
+    float modulation {0};
+    bool flame {false};
+    bool dhwActive {false};
+    uint16_t burnerStarts {0};
+    uint16_t dhwBurnerStarts {0};
+    float burnerHours {0};
+    float dhwBurnerHours {0};
+    void update(const uint32_t now);
+    void step(const float dt);
+    uint16_t getStatus() const;
+public:
+    uint16_t latency {20}; // ms, delay of replies
+    void setConfig(JsonObject config);
+    unsigned long handleRequest(const unsigned long request);
+};
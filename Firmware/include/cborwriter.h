@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <type_traits>
+
+/*
+    Streaming CBOR (RFC 8949) writer for the compact status, counterpart of JsonWriter.
+    Maps and arrays are written with indefinite length, so nothing has to be counted
+    in advance. Keys are small unsigned integers, see DevStatus::getSchemaJson(),
+    members of the status without a numeric key keep their name as text key.
+*/
+class CborWriter {
+private:
+    static const uint8_t BUF_SIZE = 128;
+    enum Major: uint8_t {
+        CBOR_UINT = 0,
+        CBOR_NEGINT = 1,
+        CBOR_TEXT = 3,
+        CBOR_ARRAY = 4,
+        CBOR_MAP = 5,
+        CBOR_SIMPLE = 7
+    };
+    Print &out;
+    uint8_t buf[BUF_SIZE];
+    uint8_t len {0};
+    void put(const uint8_t b);
+    void putHead(const Major major, const uint32_t val);
+    void putFloat(const float val);
+public:
+    CborWriter(Print &out);
+    ~CborWriter();
+    void beginMap();
+    void beginMap(const uint16_t key);
+    void beginArray();
+    void beginArray(const uint16_t key);
+    void end();
+    void key(const uint16_t key);
+    void key(const char *key);
+    void addNull(const uint16_t key);
+    void add(const uint16_t key, const char *val);
+    template<typename T> requires std::is_arithmetic_v<T>
+    void add(const uint16_t key, const T val) {
+        this->key(key);
+        value(val);
+    }
+    void value(const char *val);
+    void value(JsonVariantConst val); // objects with text keys
+    template<typename T> requires std::is_arithmetic_v<T>
+    void value(const T val) {
+        if constexpr (std::is_same_v<T, bool>)
+            put(val ? 0xF5 : 0xF4);
+        else if constexpr (std::is_floating_point_v<T>)
+            putFloat(val);
+        else if constexpr (std::is_signed_v<T>) {
+            if (val < 0)
+                putHead(CBOR_NEGINT, (uint32_t) (-1 - (int32_t) val));
+            else
+                putHead(CBOR_UINT, val);
+        }
+        else
+            putHead(CBOR_UINT, val);
+    }
+    void flush();
+};
@@ -5,19 +5,82 @@
 #include <ArduinoJson.h>
 #include <ESPAsyncWebServer.h>
 #include <mutex>
+#include <memory>
+#include <vector>
+#include "statustracker.h"
 #ifdef NODO
 inline bool WIRED_ETHERNET_PRESENT, OLED_PRESENT = false;
 #endif
+// keys of the compact (CBOR) status, names in getSchemaJson()
+enum StatusKey: uint8_t {
+    SKEY_DEVICE = 0,
+    SKEY_SLAVE,             // map of OT values, keyed by data ID
+    SKEY_THERMOSTAT,        // same for the values of the room unit
+    SKEY_HEATERCIRCUIT      // array of HeaterCircuitKey maps
+};
+
+enum DeviceKey: uint8_t {
+    DKEY_RUNTIME = 1,
+    DKEY_FREEHEAP,
+    DKEY_FWVERSION,
+    DKEY_RSSI,
+    DKEY_NUMWIFIDISC,
+    DKEY_MQTTCONNECTED,
+    DKEY_OUTSIDETEMP
+};
+
+enum HeaterCircuitKey: uint8_t {
+    HKEY_ROOMSETPOINT = 1,
+    HKEY_ROOMTEMP,
+    HKEY_OVRDFLOW,
+    HKEY_MODE,
+    HKEY_SUSPENDED
+};
+
 extern class DevStatus {
+public:
+    // serialized status, shared by all consumers
+    struct Snapshot {
+        String json;
+        uint32_t hash;      // of the content without volatile fields, used as weak ETag
+        uint32_t epoch;     // incremented whenever that content changes
+        uint32_t built;     // millis
+    };
+    struct CborSnapshot {
+        std::vector<uint8_t> data;
+        uint32_t built;     // millis
+    };
 private:
+    static const uint32_t SNAPSHOT_MAX_AGE = 1000; // ms
     JsonDocument doc;
+    JsonDocument snapDoc;   // content of snapshot, source of the deltas
     std::mutex mutex;
+    std::shared_ptr<const Snapshot> snapshot;
+    std::shared_ptr<const CborSnapshot> cborSnapshot;
+    struct {
+        uint32_t size;
+        uint32_t micros;    // build time
+    } jsonStats {}, cborStats {};
+    StatusTracker tracker;
+    uint32_t numBuilds {0};
+    uint32_t numShared {0};
+    void build(JsonDocument &dst, const bool withValues = true);
+    std::shared_ptr<const Snapshot> currentSnapshot();
 public:
     DevStatus();
     void lock();
     void unlock();
     JsonDocument &buildDoc();
     void getJson(String &str);
+    void writeJson(Print &out);
+    std::shared_ptr<const Snapshot> getSnapshot();
+    std::shared_ptr<const Snapshot> getDelta(const uint32_t since, JsonObject delta, const bool withVolatile = false);
+    void writeCbor(Print &out);
+    std::shared_ptr<const CborSnapshot> getCborSnapshot();
+    void getSchemaJson(JsonObject &obj);
+#ifdef DEBUG
+    void checkParity(JsonObject &obj);
+#endif
     uint32_t numWifiDiscon;
 } devstatus;
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <OpenTherm.h>
+#include "otscheduler.h"
+#include "jsonwriter.h"
+
+/*
+    Reader of the fault history buffer of the slave (OT class 7). The buffer size
+    is read once, then one entry per request (HB: index, LB: value) in the slots
+    the regular polling leaves over. The entries are cached, the buffer is only
+    read again when the ASF flags / OEM code of the slave change.
+*/
+class OTFaultHistory: public OTJob {
+private:
+    static constexpr uint8_t MAX_ENTRIES = 64;      // entries cached, the size reported may be larger
+    static const uint32_t SPACING = 1000;       // ms between two requests
+    static const uint32_t RETRY = 10000;        // ms, request without response
+    enum State: uint8_t {
+        FH_OFF,         // not in master mode or not this slave application
+        FH_SIZE,        // size to be read
+        FH_ENTRIES,     // reading entries
+        FH_DONE,
+        FH_UNSUPPORTED  // slave doesn't know the size ID
+    };
+    const OpenThermMessageID sizeId;
+    const OpenThermMessageID entryId;
+    const OpenThermMessageID keyId[2];  // ASF flags / OEM code, a change triggers a new read
+    const char *name;                   // string id for JSON / MQTT
+    const char *haName;
+    State state {FH_OFF};
+    bool awaiting {false};              // request sent, no response yet
+    uint32_t lastSent {0};
+    uint16_t key[2];
+    bool keyValid[2] {false, false};
+    uint8_t size {0};
+    uint8_t next {0};
+    uint8_t entries[MAX_ENTRIES];
+    uint8_t numRead {0};
+    uint32_t numReads {0};              // complete reads of the buffer
+    bool discFlag {false};
+    uint8_t numCached() const;
+    bool sendDiscovery();
+protected:
+    bool getRelease(const uint32_t now, uint32_t &release) override;
+    bool getRequest(unsigned long &request) override;
+    uint32_t getPeriod() const override;
+    void onSent(const uint32_t now) override;
+public:
+    OTFaultHistory(const OpenThermMessageID sizeId, const OpenThermMessageID entryId, const OpenThermMessageID keyId1,
+                   const OpenThermMessageID keyId2, const char *name, const char *haName);
+    void init(const bool enabled);
+    void onResponse(const unsigned long msg);
+    void getJson(JsonObject &obj) const;
+    void writeJson(JsonWriter &w) const;
+    void loopDiscovery();
+    void refreshDisc();
+};
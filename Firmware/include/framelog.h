@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <atomic>
+
+/*
+    Ring of raw OT frames. Senders and the OT callbacks only copy the frame into a
+    preallocated slot, formatting and distribution to websocket / TCP clients is
+    done later in OtGwCommand::loop().
+    The ring is overwritten when full, so it also holds the last FRAMELOG_SIZE
+    frames, which can be downloaded from /capture:
+
+    header (16 bytes, little endian):
+        char[4]     "OTCP"
+        uint16_t    version (2)
+        uint16_t    record size (12)
+        uint32_t    number of records
+        uint32_t    micros() at time of download
+    records:
+        uint32_t    micros() at time of tx / rx
+        uint32_t    frame
+        char        source ('T', 'B', 'R', 'A', 'P', 'S', 'E', 'X': timeout)
+        uint8_t     OpenThermResponseStatus, 0xFF: record lost (overwritten during download)
+        uint16_t    reserved
+    Since version 2 a frame rewritten by the repeater is recorded twice: the
+    received frame as 'T' / 'B', followed by the forwarded frame as 'R' / 'A'.
+    Version 1 recorded only the received frame, marked 'R' / 'A'.
+*/
+
+/*
+    Each slot takes 16 bytes of RAM. A repeater sees about 4 frames per second
+    (request and response in both directions), so the default of the C3 holds
+    the last ~8 minutes in 32 kB of its 400 kB SRAM, the NODO (S3) ~17 minutes
+    in 64 kB.
+    Can be overridden with -D FRAMELOG_SIZE=<power of 2> in platformio.ini.
+*/
+#ifndef FRAMELOG_SIZE
+#ifdef NODO
+#define FRAMELOG_SIZE 4096
+#else
+#define FRAMELOG_SIZE 2048
+#endif
+#endif
+
+struct OTFrame {
+    uint32_t micros;
+    uint32_t frame;
+    char source;
+    uint8_t status;
+    uint16_t reserved;
+};
+
+class OTFrameLog {
+public:
+    static constexpr uint32_t SIZE = FRAMELOG_SIZE;
+    static constexpr uint8_t STATUS_LOST = 0xFF;
+    static constexpr uint16_t CAPTURE_VERSION = 2;
+    static constexpr size_t CAPTURE_HEADER_SIZE = 16;
+    static constexpr size_t CAPTURE_RECORD_SIZE = 12;
+private:
+    static_assert((SIZE & (SIZE - 1)) == 0, "FRAMELOG_SIZE must be a power of 2");
+    struct Slot {
+        std::atomic<uint32_t> seq {0}; // index + 1 of the frame in this slot, 0: being written
+        OTFrame frame;
+    } ring[SIZE];
+    std::atomic<uint32_t> head {0}; // index of the next frame to be written
+    uint32_t tail {0}; // next frame to be taken by pop()
+    uint32_t numLost {0};
+public:
+    void push(const char source, const uint32_t frame, const OpenThermResponseStatus status);
+    bool read(const uint32_t idx, OTFrame &frame);
+    bool pop(OTFrame &frame);
+    uint32_t getHead() const;
+    uint32_t getLost() const;
+    size_t getCaptureSize(const uint32_t count) const;
+    size_t fillCapture(const uint32_t start, const uint32_t count, const uint32_t now, uint8_t *buf, size_t maxLen, size_t index);
+};
+
+extern OTFrameLog framelog;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+
+/*
+    Flow temperature of the heating curve (incl. offset) over outside temperature.
+    The curve is tabulated in 1 K steps when the room set point or the config
+    changes, getFlow() only interpolates.
+*/
+struct HeatingCurve {
+    static constexpr int8_t T_MIN = -40;
+    static constexpr int8_t T_MAX = 30;
+    static constexpr uint8_t POINTS = T_MAX - T_MIN + 1; // 1 K steps
+    bool valid {false};
+    float roomSet; // room set point the curve was built for
+    float flow[POINTS];
+    void build(const float flowMax, const float exponent, const float gradient, const float offset, const float roomSet);
+    float get(const float outTmp) const;
+};
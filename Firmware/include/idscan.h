@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/*
+    Scan of the data IDs supported by the connected slave. READ_DATA requests for
+    a range of IDs are passed to the /slaverequest queue, a few at a time, so the
+    scheduler serves them between the control traffic. Each result is sent over
+    the websocket as soon as it arrives and collected in a capability map.
+*/
+class OTIdScan {
+public:
+    enum Result: uint8_t {
+        SCAN_NONE = 0,      // not scanned
+        SCAN_SUPPORTED,     // READ_ACK
+        SCAN_UNKNOWN_ID,    // UNKNOWN_DATA_ID
+        SCAN_INVALID,       // DATA_INVALID
+        SCAN_TIMEOUT,       // no or invalid response
+        SCAN_FAILED         // request not possible in this OT mode
+    };
+private:
+    static const uint8_t PIPELINE = 4; // requests queued at a time
+    struct Entry {
+        Result result;
+        uint16_t value;
+    } map[256];
+    struct {
+        uint8_t id;
+        uint32_t ticket; // 0: free
+    } pending[PIPELINE];
+    volatile bool startFlag {false};   // set by the web server task, taken over by loop()
+    volatile bool abortFlag {false};
+    uint8_t reqFirst {0};
+    uint8_t reqLast {0};
+    bool running {false};
+    uint8_t first {0};
+    uint8_t last {0};
+    uint16_t next {0};
+    uint16_t numDone {0};
+    bool isPending(const uint8_t id) const;
+    void cancelPending();
+    void onResult(const uint8_t id, const Result result, const uint16_t value);
+    static void getEntryJson(const uint8_t id, const Entry &entry, JsonObject &obj);
+public:
+    void start(const uint8_t first, const uint8_t last);
+    void abort();
+    void loop();
+    void getJson(JsonObject &obj);
+};
+
+extern OTIdScan idscan;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <type_traits>
+
+/*
+    Streaming JSON writer for the status, the output is collected in a small buffer
+    inside the writer (i.e. on the stack of the caller) and passed to the Print in
+    chunks. Nothing is stored on the heap, nesting is tracked in a bit mask.
+    Keys are plain / PROGMEM strings, nullptr for elements of arrays.
+    The modules contributing to the status have a writeJson(JsonWriter&) next to
+    their getJson(JsonObject&), which add the same members to the current object.
+*/
+class JsonWriter {
+private:
+    static const uint8_t BUF_SIZE = 128;
+    Print &out;
+    char buf[BUF_SIZE];
+    uint8_t len {0};
+    uint8_t depth {0};      // max. 31
+    uint32_t first {1};     // bit n: no member written yet at depth n
+    void put(const char c);
+    void put(const char *str);
+    void putString(const char *str);
+    void putFloat(const float val);
+    void putInt(const int32_t val);
+    void putUInt(const uint32_t val);
+    void key(const char *key);
+    void open(const char *key, const char c);
+    void close(const char c);
+public:
+    JsonWriter(Print &out);
+    ~JsonWriter();
+    void beginObject(const char *key = nullptr);
+    void endObject();
+    void beginArray(const char *key = nullptr);
+    void endArray();
+    void add(const char *key, const char *val); // nullptr: null
+    void add(const char *key, const String &val);
+    template<typename T> requires std::is_arithmetic_v<T>
+    void add(const char *key, const T val) {
+        this->key(key);
+        if constexpr (std::is_same_v<T, bool>)
+            put(val ? "true" : "false");
+        else if constexpr (std::is_floating_point_v<T>)
+            putFloat(val);
+        else if constexpr (std::is_signed_v<T>)
+            putInt(val);
+        else
+            putUInt(val);
+    }
+    void flush();
+};
@@ -11,6 +11,9 @@ struct MqttConfig {
     String user;
     String pass;
     uint16_t keepAlive;
+    bool delta;             // publish changed fields only, full state every fullInterval
+    uint16_t fullInterval;  // s
+    bool cbor;              // additionally publish the compact status to <base>/cbor
 };
 
 class Mqtt {
@@ -22,6 +25,10 @@ private:
     AsyncMqttClient cli;
     uint32_t lastConTry;
     uint32_t lastStatus;
+    uint32_t lastFull {0};
+    bool fullDue {true};
+    uint32_t lastSeq {0};   // epoch of the status published last
+    void publishState();
     MqttConfig config;
     bool configSet;
     String baseTopic;
@@ -50,7 +57,8 @@ public:
         TOPIC_VENTENABLE,
         TOPIC_OPENBYPASS,
         TOPIC_AUTOBYPASS,
-        TOPIC_FREEVENTENABLE
+        TOPIC_FREEVENTENABLE,
+        TOPIC_TSP
     };
     Mqtt();
     void begin();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "jsonwriter.h"
+#include <OpenTherm.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/*
+    Data IDs known to be supported / not supported by the connected slave, kept in
+    NVS together with the slave's member ID (ID 3) and product version (ID 127).
+    At boot IDs the slave didn't support are not polled. If the slave reports
+    a different member ID or product version the stored map is discarded.
+*/
+class OTCapabilities {
+private:
+    static const uint16_t MAGIC = 0x4F43;
+    static const uint32_t SAVE_DELAY = 60000; // ms, wait for further changes before writing to flash
+    struct Data {
+        uint16_t magic;
+        bool memberIdValid;
+        bool versionValid;
+        uint8_t memberId;           // ID 3, LB
+        uint16_t productVersion;    // ID 127
+        uint8_t supported[32];      // bitmap of IDs 0..255
+        uint8_t unsupported[32];
+    } data;
+    bool dirty {false};
+    uint32_t changed {0};
+    SemaphoreHandle_t mutex;
+    static bool getBit(const uint8_t *map, const uint8_t id);
+    static void setBit(uint8_t *map, const uint8_t id, const bool val);
+    void clear();
+    void setSupported(const uint8_t id, const bool supported);
+    void setChanged();
+public:
+    OTCapabilities();
+    void begin();
+    void loop();
+    bool isUnsupported(const OpenThermMessageID id) const;
+    bool onResponse(const unsigned long msg);
+    void getJson(JsonObject &obj) const;
+    void writeJson(JsonWriter &w) const;
+};
+
+extern OTCapabilities otcaps;
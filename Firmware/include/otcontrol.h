@@ -3,19 +3,55 @@
 #include <OpenTherm.h>
 #include "ArduinoJson.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <mutex>
+#include "otscheduler.h"
+#include "faulthistory.h"
+#include "boilersim.h"
+#include "otrules.h"
+#include "jsonwriter.h"
+#include "cborwriter.h"
+#include "heatingcurve.h"
 
-class OTWriteRequest {
+class OTWriteRequest: public OTJob {
+public:
+    // provides the data to be sent, returns false if there is nothing to send
+    typedef std::function<bool(uint16_t &data)> DataSource;
 private:
-    uint32_t nextMillis {0};
-    uint16_t interval;
+    uint32_t lastSent {0};
+    bool forced {true};
+    DataSource source;
+    static constexpr uint32_t MAX_BACKOFF = 3600000; // ms
+    uint16_t sentData {0};
+    uint16_t ackData {0};       // data of the last WRITE_ACK, the slave may have clamped it
+    bool acked {false};         // last request was acknowledged
+    uint8_t numRejected {0};    // UNKNOWN_DATA_ID / DATA_INVALID in a row
+    uint32_t holdUntil {0};     // source was checked unchanged, don't check again before
+    uint32_t holdRelease {0};
+    uint32_t nextAvoid {0};     // a suppressed write counts as avoided from then on
+    uint32_t numAvoided {0};
+    bool isChanged(const uint16_t data) const;
+    uint32_t getRetryInterval() const;
 protected:
     OpenThermMessageID id;
+    OpenThermMessageType msgType;
+    uint32_t interval; // ms, minimum time between two requests
+    uint32_t refresh; // ms, keep-alive if the value didn't change since last WRITE_ACK
+    uint16_t deadband {0}; // raw data units
+    bool getRelease(const uint32_t now, uint32_t &release) override;
+    bool getRequest(unsigned long &request) override;
+    uint32_t getPeriod() const override;
+    void onSent(const uint32_t now) override;
 public:
-    OTWriteRequest(OpenThermMessageID id, uint16_t intervalS);
-    void send(const uint16_t data);
-    void sendTemp(const double temp);
+    OTWriteRequest(OpenThermMessageID id, const uint32_t interval, const uint32_t refresh, const Priority prio,
+        const OpenThermMessageType msgType = OpenThermMessageType::WRITE_DATA);
+    void setSource(DataSource src);
+    void setDeadband(const uint16_t raw);
     void force();
-    operator bool();
+    void onResponse(const unsigned long msg);
+    OpenThermMessageID getId() const;
+    uint32_t getAvoided() const;
+    void resetCounters();
 };
 
 class OTWRSetDhw: public OTWriteRequest {
@@ -53,6 +89,23 @@ public:
     OTWRSetOutsideTemp();
 };
 
+// periodic master status exchange, a READ_DATA request carrying the master's flags
+class OTStatusRequest: public OTWriteRequest {
+public:
+    OTStatusRequest(OpenThermMessageID id);
+};
+
+// distribution of the repeater's forwarding latency, room unit -> boiler -> room unit
+struct LatencyHistogram {
+    static const uint16_t BUCKET = 5; // ms
+    static const uint16_t NUM = 200;  // 0 ... 1 s, last bucket holds everything above
+    uint32_t count[NUM];
+    uint32_t total;
+    void add(const uint32_t ms);
+    uint32_t percentile(const uint8_t p) const;
+    void reset();
+};
+
 class OTControl {
 friend OTWriteRequest;
 public:
@@ -69,6 +122,7 @@ public:
     friend void IRAM_ATTR handleTimerIrqMaster();
     friend void IRAM_ATTR handleTimerIrqSlave();
     friend class OTValue;
+    friend class OTReplay;
 private:
     void OnRxMaster(const unsigned long msg, const OpenThermResponseStatus status);
     void OnRxSlave(const unsigned long msg, const OpenThermResponseStatus status);
@@ -76,10 +130,7 @@ private:
     void sendRequest(const char source, const unsigned long msg);
     void masterPinIrq();
     void slavePinIrq();
-    double getFlow(const uint8_t channel);
-    uint16_t tmpToData(const double tmpf);
-    unsigned long lastBoilerStatus;
-    unsigned long lastVentStatus;
+    float getFlow(const uint8_t channel);
     enum OTMode: int8_t {
         OTMODE_BYPASS = 0,
         OTMODE_MASTER = 1,
@@ -94,32 +145,36 @@ private:
     } slaveApp;
     struct HeatingConfig {
         bool chOn;
-        double roomSet; // default room set point
-        double flowMax;
-        double exponent;
-        double gradient;
-        double offset;
-        double flow; // default flow temperature
-        double roomTempComp; // P K/K
-        double roomTempCompI; // I 1/h
+        float roomSet; // default room set point
+        float flowMax;
+        float exponent;
+        float gradient;
+        float offset;
+        float flow; // default flow temperature
+        float roomTempComp; // P K/K
+        float roomTempCompI; // I 1/h
         bool enableHyst;
-        double hysteresis;
+        float hysteresis;
     } heatingConfig[2];
+    HeatingCurve heatingCurve[2];
     struct HeatingControl {
         bool chOn;
-        double flowTemp;
+        float flowTemp;
         CtrlMode mode {CTRLMODE_AUTO};
         bool overrideFlow;
         struct PiCtrl {
             bool init { false };
-            double roomTempFilt;
-            double integState {0}; // state of integrator / K
-            double deltaT {0};
+            float roomTempFilt;
+            float integState {0}; // state of integrator / K
+            float deltaT {0};
         } piCtrl;
         bool suspended {false};
     } heatingCtrl[2];
-    void loopPiCtrl();
+    void loopPiCtrl(HeatingControl (&ctrl)[2]);
     unsigned long nextPiCtrl { 0 };
+    void reprobe();
+    uint32_t nextReprobe {0};
+    size_t reprobeIndex {0};
     struct {
         bool ventEnable;
         bool openBypass;
@@ -135,7 +190,7 @@ private:
     } boilerConfig;
     struct {
         bool dhwOn;
-        double dhwTemp;
+        float dhwTemp;
         bool overrideDhw;
     } boilerCtrl;
     bool discFlag {true};
@@ -146,6 +201,37 @@ private:
     OTWRSetRoomTemp setRoomTemp[2];
     OTWRSetRoomSetPoint setRoomSetPoint[2];
     OTWRSetOutsideTemp setOutsideTemp;
+    OTStatusRequest boilerStatusRequest;
+    OTStatusRequest ventStatusRequest;
+    // indexed by SlaveApplication
+    OTFaultHistory faultHistory[3] {
+        {OpenThermMessageID::FHBsize, OpenThermMessageID::FHBindexFHBvalue, OpenThermMessageID::ASFflags,
+            OpenThermMessageID::OEMDiagnosticCode, PSTR("fault_history"), PSTR("fault history")},
+        {OpenThermMessageID::FHBsizeVentilationHeatRecovery, OpenThermMessageID::FHBindexFHBvalueVentilationHeatRecovery,
+            OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery, OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery,
+            PSTR("vent_fault_history"), PSTR("fault history ventilation")},
+        {OpenThermMessageID::FHBsizeSolarStorage, OpenThermMessageID::FHBindexFHBvalueSolarStorage,
+            OpenThermMessageID::ASFflagsOEMfaultCodeSolarStorage, OpenThermMessageID::ASFflagsOEMfaultCodeSolarStorage,
+            PSTR("solar_fault_history"), PSTR("fault history solar storage")}
+    };
+    OTScheduler scheduler;
+    OTScheduler cacheScheduler; // refresh of the values cached in hybrid repeater mode
+    struct {
+        bool enable;
+        uint32_t maxAge;        // ms
+        bool refreshPending;    // response to an own request, not to be forwarded
+        uint32_t hits;          // READs answered locally
+        uint32_t misses;
+        uint32_t refreshes;
+    } repeaterCache {};
+    // request of the room unit received while an own request was on the line, sent by loop()
+    bool fwdPending {false};
+    unsigned long pendingFwd;
+    char pendingFwdSource;
+    void initScheduler();
+    OTWriteRequest *writeRequests[10];
+    uint8_t numWriteRequests {0};
+    void addWriteRequest(OTWriteRequest &req);
     uint8_t masterMemberId;
     struct OTInterface {
         OTInterface(const uint8_t inPin, const uint8_t outPin, const bool isSlave);
@@ -158,22 +244,81 @@ private:
         unsigned long lastTx; // millis
         unsigned long lastTxMsg;
         SemaphoreHandle_t mutex;
+        bool divert {false};        // replay: capture outgoing frames instead of sending them
+        bool diverted {false};
+        unsigned long divertedMsg {0};
         void sendRequest(const char source, const unsigned long msg);
         void resetCounters();
-        void onReceive(const char source, const unsigned long msg);
+        void onReceive(const char source, const unsigned long msg, const OpenThermResponseStatus status = OpenThermResponseStatus::SUCCESS);
         void sendResponse(const unsigned long msg, const char source = 0);
+        // response waiting for the line to become free
+        bool respPending {false};
+        unsigned long pendingResp;
+        char pendingSource;
+        uint32_t numLate;       // sent later than 800 ms after the request
+        uint32_t numDropped;    // not sent within 800 ms or superseded
+        uint32_t reqMicros {0}; // repeater: request of the room unit received, 0: not forwarding
+        LatencyHistogram *latency {nullptr}; // slave interface only
+        void processResponse();
+        void onResponseSent(const char source, const unsigned long msg);
     } master, slave;
+    LatencyHistogram repeaterLatency;
     bool slaveEnabled {false};
+    BoilerSim boilerSim; // slave in loopback test mode
+    OTRules rules; // frame rewriting in repeater mode
+    void initRules();
+    unsigned long simReply;
+    uint32_t simReplyDue;
+    bool simReplyPending {false};
     uint16_t statusReqOvl {0}; // will be or'ed to status request as this is needed by some boilers
+    // the OT interfaces are served by a task of their own, other tasks pass their requests through cmdQueue
+    struct Command {
+        enum Type: uint8_t {
+            CMD_DHW_TEMP,
+            CMD_DHW_MODE,
+            CMD_CH_TEMP,
+            CMD_CH_MODE,
+            CMD_OVERRIDE_CH,
+            CMD_OVERRIDE_DHW,
+            CMD_FORCE_FLOW,
+            CMD_VENT_SETPOINT,
+            CMD_VENT_ENABLE,
+            CMD_CONFIG          // data: JsonObject*
+        } type;
+        uint8_t channel;
+        float value;
+        void *data;
+        SemaphoreHandle_t done; // given when executed, nullptr: caller doesn't wait
+    };
+    QueueHandle_t cmdQueue;
+    TaskHandle_t task {nullptr};
+    // held by the OT task while it runs, by other tasks while they read the state
+    std::recursive_mutex stateMutex;
+    Command pendingConfig;      // waiting for the OT line to become idle
+    bool configPending {false};
+    void post(Command cmd, const bool wait = false);
+    void exec(const Command &cmd);
+    static void taskFunc(void *arg);
+    struct {
+        uint32_t lastLoop;      // micros
+        uint32_t numLoops;
+        uint32_t gapMax[2];     // max. loop to loop time in current and previous window
+        uint32_t windowStart;   // millis
+        float gapAvg;
+    } taskStats {};
+    void applyConfig(JsonObject &config);
 public:
     OTControl();
     void begin();
     void loop();
-    unsigned long slaveRequest(OpenThermMessageID id, OpenThermMessageType ty, uint16_t data);
-    void getJson(JsonObject &obj);
+    void loopDiscovery();
+    void getJson(JsonObject &obj, const bool withValues = true);
+    void writeJson(JsonWriter &w);
+    void writeCbor(CborWriter &w, const bool thermostat);
+    void getSchemaJson(JsonObject &obj);
     void setConfig(JsonObject &config);
-    void setDhwTemp(const double temp);
-    void setChTemp(const double temp, const uint8_t channel);
+    void setDhwTemp(const float temp);
+    void setChTemp(const float temp, const uint8_t channel);
     void setChCtrlMode(const CtrlMode mode, const uint8_t channel);
     void setDhwCtrlMode(const CtrlMode mode);
     bool sendDiscovery();
@@ -182,6 +327,10 @@ public:
     void setVentEnable(const bool en);
     void setOverrideCh(const bool ovrd, const uint8_t channel);
     void setOverrideDhw(const bool ovrd);
+    void getCurveJson(JsonArray &arr);
+#ifdef DEBUG
+    void benchmark(JsonObject &obj);
+#endif
 };
 
 
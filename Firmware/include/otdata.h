@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+    Conversion of the f8.8 data fields (signed, 1/256 K). Free of the HAL so they
+    are covered by the host tests (pio test -e native).
+*/
+
+// rounded to 0.1 in integer arithmetic, the C3 has no FPU
+inline float f88ToFloat(const uint16_t data) {
+    const int32_t v = (int16_t) data * 10;
+    const int32_t tenths = (v >= 0) ? (v + 128) / 256 : (v - 128) / 256;
+    return tenths / 10.0f;
+}
+
+// limited to -100 ... 100
+inline uint16_t floatToF88(const float val) {
+    if (val > 100)
+        return 100<<8;
+    if (val < -100)
+        return - (int) (100<<8);
+
+    return (int16_t) (val * 256);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "framelog.h"
+
+/*
+    Replays a recorded frame log through OTControl: the frames received from the
+    room unit and from the boiler are passed to OnRxSlave() / OnRxMaster() as if
+    they came from the OT interfaces, at the recorded timing scaled by speed. The
+    replay runs in the OT task, called by OTControl::loop() which doesn't send own
+    requests meanwhile. The OT interfaces don't transmit while replaying, the
+    frames OTControl sends are captured and checked against the frame recorded as
+    the output of the received one:
+        'T' followed by 'R': forwarded rewritten, R is the expected output
+        'T' alone: forwarded unmodified (master mode: own request, not fed)
+        'B' followed by 'A': forwarded rewritten, A is the expected output
+        'B' alone: forwarded unmodified or not forwarded
+        'S' followed by 'P': answered by OT-Thing, P is the expected answer
+        'S' alone: blocked
+        'E', 'X': invalid response / timeout, fed but not checked
+    The rules, overrides and cache of OTControl's config apply, the decoded values
+    and counters end up in its state, which GET /replay reports after the replay.
+    Logs recorded before 'R' / 'A' followed the original frame carry the original
+    frame as 'R' / 'A', for these any rewrite is accepted.
+    Accepted formats are the text lines of the websocket / TCP log ("B40190000 ...",
+    one frame per line, lines not starting with a frame are ignored) and the binary
+    capture of /capture, both parsed while uploading into the buffer of the Upload,
+    which load() takes over.
+*/
+class OTReplay {
+public:
+    static constexpr size_t MAX_FRAMES = OTFrameLog::SIZE;
+    // incremental parser of an upload, kept in AsyncWebServerRequest::_tempObject
+    // until load() takes it over. Released with free(), so it is trivially destructible
+    class Upload {
+    friend class OTReplay;
+    private:
+        static constexpr size_t LINE_START = 10; // source, 8 hex digits, first char after the frame
+        enum Format: uint8_t {
+            FMT_UNKNOWN,
+            FMT_TEXT,
+            FMT_CAPTURE,
+            FMT_INVALID
+        } format {FMT_UNKNOWN};
+        uint8_t buf[OTFrameLog::CAPTURE_HEADER_SIZE]; // header / start of the current line or record
+        uint8_t bufLen {0};
+        bool lineStart {true}; // text: only blanks so far in the current line
+        uint16_t recSize {0};
+        uint32_t recCount {0};
+        uint32_t recIndex {0}; // capture: records completed
+        uint32_t recPos {0}; // capture: bytes of the current record
+        uint32_t numFrames {0};
+        bool overflow {false};
+        Upload() {}
+        void add(const OTFrame &frame);
+        void putText(const uint8_t c);
+        void endLine();
+        void putCapture(const uint8_t c);
+    public:
+        static Upload *create();
+        OTFrame *getFrames();
+        void write(const uint8_t *data, const size_t len);
+        bool finish();
+        bool isOverflow() const;
+    };
+private:
+    static constexpr uint32_t TEXT_SPACING = 500000; // us, assumed time between two text lines
+    static constexpr uint8_t MAX_MISMATCHES = 8;
+    Upload *current {nullptr}; // frames of the replay
+    Upload *pending {nullptr}; // loaded, started by the next loop()
+    const OTFrame *frames {nullptr};
+    size_t numFrames {0};
+    volatile bool uploadReady {false};
+    const void *uploadOwner {nullptr};
+    float uploadSpeed {1};
+    bool running {false};
+    size_t pos {0};
+    float speed {1}; // 0: as fast as possible
+    uint32_t startMicros {0};
+    uint32_t endMicros {0};
+    uint32_t numFed {0};
+    uint32_t numChecked {0};
+    uint32_t numMismatch {0};
+    uint32_t busyMicros {0}; // time spent in OnRxSlave() / OnRxMaster()
+    struct Mismatch {
+        uint32_t index;
+        uint32_t frame;
+        uint32_t out;       // frame sent by OTControl, 0: none
+        uint32_t expected;  // 0: not recorded
+        char source;
+    } mismatches[MAX_MISMATCHES];
+    String state; // OTControl::getJson() after the last replay
+    void start();
+    void stop();
+    void feed();
+public:
+    bool lockUpload(const void *owner);
+    bool unlockUpload(const void *owner);
+    bool load(Upload *up, const float speed);
+    void loop();
+    bool isRunning() const;
+    void getJson(JsonObject &obj);
+};
+
+extern OTReplay otreplay;
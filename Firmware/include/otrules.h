@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "jsonwriter.h"
+#include <OpenTherm.h>
+#include <functional>
+
+/*
+    Rewrite rules of the repeater. A rule matches a frame by direction, data ID,
+    message type and (data & mask) == match plus a runtime condition (e.g. flow
+    override active), then changes the data / message type, substitutes a computed
+    value, blocks the frame or answers the room unit locally. The built-in rules
+    implement the overrides of OT-Thing and always keep their slots, rules from
+    the config are checked first.
+    The rules are compiled into a table indexed by data ID, at most MAX_PER_ID
+    rules are checked per frame, the first one matching is applied.
+
+    config: [{"dir": "req", "id": 56, "types": ["WRITE_DATA"], "mask": "FF00", "match": "3C00",
+              "cond": "overrideDhw", "action": "replace", "data": "3200", "dataMask": "FFFF",
+              "source": "dhwSet", "msgType": "WRITE_DATA"}, ...]
+*/
+class OTRules {
+public:
+    enum RuleDir: uint8_t {
+        DIR_REQUEST,        // room unit -> boiler
+        DIR_RESPONSE        // boiler -> room unit
+    };
+    enum RuleCond: uint8_t {
+        COND_ALWAYS,
+        COND_OVERRIDE_CH1,
+        COND_OVERRIDE_CH2,
+        COND_OVERRIDE_DHW,
+        COND_OUTSIDE_LOCAL  // outside temperature available from another source than OT
+    };
+    enum RuleAction: uint8_t {
+        ACT_REPLACE,        // data = (data & ~dataMask) | (value & dataMask)
+        ACT_COMPUTE,        // data = computed source
+        ACT_BLOCK,          // frame is not forwarded
+        ACT_ANSWER          // requests only: answer the room unit, the boiler doesn't see the frame
+    };
+    enum RuleSource: uint8_t {
+        SRC_NONE,
+        SRC_FLOW1,          // flow temperature CH1 of OT-Thing
+        SRC_FLOW2,
+        SRC_DHW_SET,
+        SRC_OUTSIDE,
+        SRC_STATUS          // master status with the CH / DHW enable bits of the overrides
+    };
+    enum Result: uint8_t {
+        RES_FORWARD,        // forward msg (maybe rewritten)
+        RES_BLOCK,
+        RES_ANSWER          // msg is the response to the room unit
+    };
+    // runtime state the rules depend on, provided by OTControl
+    typedef std::function<bool(const RuleCond cond)> CondFunc;
+    typedef std::function<bool(const RuleSource src, const uint16_t data, uint16_t &value)> SourceFunc;
+private:
+    static const uint8_t MAX_RULES = 32;
+    static const uint8_t MAX_PER_ID = 4;    // bounds the evaluation per frame
+    static const uint8_t NO_TYPE = 0xFF;
+    struct Rule {
+        RuleDir dir;
+        uint8_t id;
+        uint8_t types;      // bit per OpenThermMessageType
+        uint16_t mask;
+        uint16_t match;
+        RuleCond cond;
+        RuleAction action;
+        RuleSource source;
+        uint16_t value;
+        uint16_t dataMask;
+        uint8_t msgType;    // new message type, NO_TYPE: unchanged
+        bool builtin;
+        uint32_t hits;
+    } rules[MAX_RULES];
+    uint8_t numRules {0};
+    uint8_t numDropped {0};
+    struct {
+        uint8_t first;
+        uint8_t num;
+    } table[2][256];
+    CondFunc condFunc;
+    SourceFunc sourceFunc;
+    uint32_t numFrames {0};
+    float evalAvg {0};  // us
+    uint32_t evalMax {0};
+    bool add(const Rule &rule);
+    bool parseRule(JsonObject jr, Rule &rule);
+    void compile();
+public:
+    OTRules();
+    void setFunctions(CondFunc cond, SourceFunc source);
+    void setConfig(JsonArray config);
+    Result apply(const RuleDir dir, unsigned long &msg);
+    void getJson(JsonObject &obj) const;
+    void writeJson(JsonWriter &w) const;
+};
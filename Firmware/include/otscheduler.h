@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "jsonwriter.h"
+
+/*
+    Anything that wants a slot on the OT master bus (polled values, write requests,
+    status exchange) is an OTJob. Each job is released periodically and has to be
+    sent before release + relative deadline of its priority class. The scheduler
+    always sends the due job with the earliest deadline (EDF).
+*/
+class OTJob {
+friend class OTScheduler;
+public:
+    enum Priority: uint8_t {
+        PRIO_STATUS = 0,    // master / slave status, OT spec: at least every second
+        PRIO_CONTROL,       // control set points (TSet, TsetCH2)
+        PRIO_SETPOINT,      // other set points (TdhwSet, Tr, TrSet, Toutside, ...)
+        PRIO_SENSOR,        // fast changing values (temperatures, modulation)
+        PRIO_INFO,          // slow changing values, flags, configuration
+        PRIO_COUNTER,       // counters and operating hours
+        PRIO_BACKGROUND,    // bulk reads (fault history), fill the slots left over
+        PRIO_NUM
+    };
+    OTJob(const Priority prio);
+protected:
+    // millis() at which the job becomes due. false: nothing to send
+    virtual bool getRelease(const uint32_t now, uint32_t &release) = 0;
+    // builds the frame to be sent. false: no data available (yet)
+    virtual bool getRequest(unsigned long &request) = 0;
+    // period in ms, 0 for one-shot jobs
+    virtual uint32_t getPeriod() const = 0;
+    virtual void onSent(const uint32_t now) = 0;
+    Priority prio;
+private:
+    uint32_t numSent {0};
+    uint32_t numMissed {0};
+};
+
+class OTScheduler {
+private:
+    static const uint8_t MAX_JOBS = 80;
+    static const uint32_t LOAD_WINDOW = 10000; // ms
+    OTJob *jobs[MAX_JOBS];
+    uint8_t numJobs {0};
+    uint32_t numSent {0};
+    uint32_t numMissed {0};
+    uint32_t maxLateness {0};
+    uint32_t maxLatenessPrio[OTJob::PRIO_NUM];
+    uint32_t txMicros {0};
+    bool busy {false};
+    uint32_t busyMicros {0};
+    uint32_t windowStart {0};
+    uint32_t windowFrames {0};
+    float load {0};
+    float frameRate {0};
+    float avgSlot {0}; // average bus time of one frame incl. response / ms
+public:
+    static const uint32_t DEADLINE[OTJob::PRIO_NUM];
+    OTScheduler();
+    void add(OTJob *job);
+    bool next(unsigned long &request);
+    void onTx();
+    void onRx();
+    void resetCounters();
+    float getDemand();
+    void getJson(JsonObject &obj);
+    void writeJson(JsonWriter &w);
+};
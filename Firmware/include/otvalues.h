@@ -3,6 +3,9 @@
 #include <ArduinoJson.h>
 #include <OpenTherm.h>
 #include "HADiscLocal.h"
+#include "otscheduler.h"
+#include "jsonwriter.h"
+#include "cborwriter.h"
 
 
 /*
@@ -134,67 +137,140 @@ ID	Msg	Name
 100	R-	*   -   *   Remote Override Room Setpoint function
 */
 
-class OTValue {
+enum OTDecoder: uint8_t {
+    OTDEC_U16,
+    OTDEC_I16,
+    OTDEC_FLOAT,
+    OTDEC_PRODUCT_VERSION,
+    OTDEC_STATUS,
+    OTDEC_MASTER_STATUS,
+    OTDEC_VENT_STATUS,
+    OTDEC_VENT_MASTER_STATUS,
+    OTDEC_SLAVE_CONFIG,
+    OTDEC_MASTER_CONFIG,
+    OTDEC_FAULT_FLAGS,
+    OTDEC_VENT_FAULT_FLAGS,
+    OTDEC_REMOTE_PARAMETER,
+    OTDEC_REMOTE_OVERRIDE_FUNCTION,
+    OTDEC_CAPACITY_MODULATION,
+    OTDEC_DHW_BOUNDS,
+    OTDEC_CH_BOUNDS,
+    OTDEC_DAY_TIME,
+    OTDEC_DATE,
+    OTDEC_BOILER_FAN_SPEED
+};
+
+enum OTDirection: uint8_t {
+    OTDIR_SLAVE,        // reply data collected (read) from slave (boiler / ventilation / solar)
+    OTDIR_THERMOSTAT    // request data sent (written) from roomunit
+};
+
+enum OTHAType: uint8_t {
+    HATYPE_NONE,        // no generic discovery, the value class may send its own
+    HATYPE_SENSOR,
+    HATYPE_TEMP,
+    HATYPE_POWERFACTOR,
+    HATYPE_PRESSURE,
+    HATYPE_HOURS
+};
+
+// one row of the message catalogue OTITEMS (otvalues.cpp)
+struct OTItem {
+    OpenThermMessageID id;
+    OTDecoder decoder;
+    OTDirection dir;
+    int16_t interval;           // -1: never query. 0: only query once. >0: query every interval seconds
+    OTJob::Priority prio;
+    const char *name;           // string id for JSON / MQTT
+    int32_t loopback {-1};      // reply of local slave in loopback test mode, -1: UNKNOWN_DATA_ID
+    OTHAType haType {HATYPE_NONE};
+    const char *haName {nullptr};
+    const char *haUnit {nullptr};
+    const char *haDevClass {nullptr};
+};
+
+class OTValue: public OTJob {
 private:
     const OpenThermMessageID id;
-    unsigned long lastTransfer;
+    unsigned long lastTransfer {0};
+    uint32_t cachedAt {0};  // millis of the last value received in repeater mode
+    bool cached {false};
+    bool queried {false};
     const int interval;
+    uint16_t curInterval;   // s, effective polling interval
+    uint16_t minInterval;   // s, bounds of curInterval in adaptive polling mode
+    uint16_t maxInterval;
+    static bool adaptivePolling;
+    void adaptInterval(const uint16_t newVal);
     virtual void getValue(JsonObject &stat) const = 0;
+    virtual void writeValue(JsonWriter &w) const = 0;
 protected:
+    virtual bool isChanged(const uint16_t newVal) const;
+    const OTItem &item;
     uint16_t value;
     bool enabled;
     virtual bool sendDiscovery();
     bool sendDiscovery(String field, const bool addBaseName = false);
     const char* getName() const;
     bool discFlag;
+    bool getRelease(const uint32_t now, uint32_t &release) override;
+    bool getRequest(unsigned long &request) override;
+    uint32_t getPeriod() const override;
+    void onSent(const uint32_t now) override;
 public:
-    OTValue(const OpenThermMessageID id, const int interval);
-    bool process();
+    OTValue(const OTItem &item);
     OpenThermMessageID getId() const;
     void setValue(uint16_t val);
     uint16_t getValue();
+    void setCached();
+    bool getCached(const uint32_t maxAge, uint16_t &val) const;
+    bool isCacheable() const;
     void setStatus(const OpenThermMessageType mt);
     void getJson(JsonObject &obj) const;
+    void writeJson(JsonWriter &w) const;
+    void writeCbor(CborWriter &w) const;
+    virtual void getSchemaJson(JsonObject &obj) const;
     void disable();
     void init(const bool enabled);
+    bool isEnabled() const;
     void setTimeout();
     static OTValue* getSlaveValue(const OpenThermMessageID id);
     static OTValue* getThermostatValue(const OpenThermMessageID id);
     void refreshDisc();
+    void setPollLimits(JsonVariant limits);
+    void getPollJson(JsonObject &obj) const;
+    void writePollJson(JsonWriter &w) const;
+    static void setPollConfig(JsonObject config);
     bool isSet;
 };
 
 class OTValueu16: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
 public:
-    OTValueu16(const OpenThermMessageID id, const int interval);
+    OTValueu16(const OTItem &item);
     uint16_t getValue() const;
 };
 
 class OTValuei16: public OTValue {
 private:
     void getValue(JsonObject &stat) const;
+    void writeValue(JsonWriter &w) const;
 public:
-    OTValuei16(const OpenThermMessageID id, const int interval);
+    OTValuei16(const OTItem &item);
     int16_t getValue() const;
 };
 
 class OTValueFloat: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
+protected:
+    bool isChanged(const uint16_t newVal) const;
 public:
-    OTValueFloat(const OpenThermMessageID id, const int interval);
-    double getValue() const;
-};
-
-
-class OTValueFloatTemp: public OTValueFloat {
-private:
-    bool sendDiscovery();
-    const char *haName;
-public:
-    OTValueFloatTemp(const OpenThermMessageID id, const char *haName);
+    OTValueFloat(const OTItem &item);
+    float getValue() const;
 };
 
 class OTValueFlags: public OTValue {
@@ -207,11 +283,13 @@ protected:
     };
     uint8_t numFlags;
     const Flag *flagTable;
-    bool slave;
-    OTValueFlags(const OpenThermMessageID id, const int interval, const Flag *flagtable, const uint8_t numFlags, const bool slave);
+    OTValueFlags(const OTItem &item, const Flag *flagtable, const uint8_t numFlags);
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     bool sendDiscFlag(String name, const char *field, const char *devClass);
     bool sendDiscovery();
+public:
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 class OTValueStatus: public OTValueFlags {
@@ -226,7 +304,7 @@ private:
         {6, "diagnostic",   "diagnostic",   HA_DEVICE_CLASS_PROBLEM}
     };
 public:    
-    OTValueStatus();
+    OTValueStatus(const OTItem &item);
     bool getMode(const uint8_t channel);
 };
 
@@ -240,7 +318,7 @@ private:
         {12, "ch2_enable",  "CH2 enable",   nullptr}
     };
 public:    
-    OTValueMasterStatus();
+    OTValueMasterStatus(const OTItem &item);
 };
 
 class OTValueVentStatus: public OTValueFlags {
@@ -254,7 +332,7 @@ private:
         {6, "diagnostic",   "diagnostic",           HA_DEVICE_CLASS_PROBLEM}
     };
 public:    
-    OTValueVentStatus();
+    OTValueVentStatus(const OTItem &item);
 };
 
 class OTValueVentMasterStatus: public OTValueFlags {
@@ -268,12 +346,13 @@ private:
 protected:
     bool sendDiscovery();
 public:    
-    OTValueVentMasterStatus();
+    OTValueVentMasterStatus(const OTItem &item);
 };
 
 class OTValueSlaveConfigMember: public OTValueFlags {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const Flag flags[6] PROGMEM = {
         {8, "dhw_present",              "DHW presemt",              nullptr},
         {9, "ctrl_type",                "Control type on/off",      nullptr},
@@ -283,13 +362,14 @@ private:
         {13, "ch2_present",             "CH2 present",              nullptr}
     };
 public:    
-    OTValueSlaveConfigMember();
+    OTValueSlaveConfigMember(const OTItem &item);
 };
 
 
 class OTValueFaultFlags: public OTValueFlags {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const Flag flags[6] PROGMEM = {
         {8, "service_request",      "service request",      HA_DEVICE_CLASS_PROBLEM},
         {9, "lockout_reset",        "lockout reset",        HA_DEVICE_CLASS_PROBLEM},
@@ -299,13 +379,14 @@ private:
         {13, "water_over_temp",     "water over temp",      HA_DEVICE_CLASS_PROBLEM}
     };
 public:
-    OTValueFaultFlags(const int interval);
+    OTValueFaultFlags(const OTItem &item);
 };
 
 
 class OTValueVentFaultFlags: public OTValueFlags {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const Flag flags[4] PROGMEM = {
         {8, "service_request",      "vent. service request",    HA_DEVICE_CLASS_PROBLEM},
         {9, "exhaust_fan_fault",    "exhaust fan fault",        HA_DEVICE_CLASS_PROBLEM},
@@ -313,49 +394,55 @@ private:
         {11, "frost_protection",    "frost protection",         HA_DEVICE_CLASS_PROBLEM}
     };
 public:
-    OTValueVentFaultFlags(const int interval);
+    OTValueVentFaultFlags(const OTItem &item);
 };
 
 class OTValueProductVersion: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     bool sendDiscovery();
-    const char *haName;
 public:    
-    OTValueProductVersion(const OpenThermMessageID id, const int interval, const char *haName);
+    OTValueProductVersion(const OTItem &item);
 };
 
 class OTValueCapacityModulation: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const char *MAX_CAPACITY = "max_capacity" PROGMEM;
     const char *MIN_MODULATION = "min_modulation" PROGMEM;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueCapacityModulation();
+    OTValueCapacityModulation(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 class OTValueDHWBounds: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const char *DHW_MAX = "dhwMax" PROGMEM;
     const char *DHW_MIN = "dhwMin" PROGMEM;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueDHWBounds();
+    OTValueDHWBounds(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 class OTValueCHBounds: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const char *CH_MAX = "chMax" PROGMEM;
     const char *CH_MIN = "chMin" PROGMEM;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueCHBounds();
+    OTValueCHBounds(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 class OTValueMasterConfig: public OTValueFlags {
@@ -364,10 +451,11 @@ private:
         {0, "smartPowerImplemented"},
     };
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueMasterConfig();
+    OTValueMasterConfig(const OTItem &item);
 };
 
 class OTValueRemoteParameter: public OTValueFlags {
@@ -379,7 +467,7 @@ private:
         {9, "max_ch_setpoint_trans", "Max. CH setpoint transfer", nullptr}
     };
 public:    
-    OTValueRemoteParameter();
+    OTValueRemoteParameter(const OTItem &item);
 };
 
 
@@ -392,57 +480,56 @@ private:
 protected:
     bool sendDiscovery();
 public:
-    OTValueRemoteOverrideFunction();
+    OTValueRemoteOverrideFunction(const OTItem &item);
 };
 
 
 class OTValueDayTime: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueDayTime();
+    OTValueDayTime(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 class OTValueDate: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
 protected:
     bool sendDiscovery();
 public:    
-    OTValueDate();
-};
-
-
-class OTValueHeatExchangerTemp: public OTValueFloat {
-protected:
-    bool sendDiscovery();
-public:
-    OTValueHeatExchangerTemp();
+    OTValueDate(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 
 class OTValueBoilerFanSpeed: public OTValue {
 private:
     void getValue(JsonObject &obj) const;
+    void writeValue(JsonWriter &w) const;
     const char *SETPOINT = "setpoint" PROGMEM;
     const char *ACTUAL = "actual" PROGMEM;
 protected:
     bool sendDiscovery();
 public:
-    OTValueBoilerFanSpeed();
+    OTValueBoilerFanSpeed(const OTItem &item);
+    void getSchemaJson(JsonObject &obj) const override;
 };
 
 
-class OTValueFlameCurrent: public OTValueFloat {
-protected:
-    bool sendDiscovery();
-public:
-    OTValueFlameCurrent();
+// range of value objects, to be used in range based for loops
+struct OTValueList {
+    OTValue * const *first;
+    size_t num;
+    OTValue * const *begin() const { return first; }
+    OTValue * const *end() const { return first + num; }
 };
 
-
-extern OTValue *slaveValues[45];
-extern OTValue *thermostatValues[17];
-extern const char* getOTname(OpenThermMessageID id);
\ No newline at end of file
+extern const OTValueList slaveValues;
+extern const OTValueList thermostatValues;
+extern const char* getOTname(OpenThermMessageID id);
+extern bool getOTloopback(OpenThermMessageID id, uint16_t &value);
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define _portal_h
 
 #include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 class Portal {
 private:
@@ -10,11 +13,27 @@ private:
     bool updateEnable;
     bool checkUpdate {false};
     bool doUpdate {false};
+    // status push on /wsstatus
+    static const uint8_t MAX_STATUS_CLIENTS = 4;
+    static const uint32_t STATUS_RESYNC = 60000; // ms, full snapshot to all clients
+    struct StatusClient {
+        uint32_t id;    // 0: free
+        bool full;      // next push is a full snapshot
+        uint32_t seq;   // epoch of the status pushed last
+        uint32_t built; // snapshot of the volatile fields pushed last
+    } statusClients[MAX_STATUS_CLIENTS];
+    SemaphoreHandle_t statusMutex;
+    uint8_t statusRate {1}; // pushes per second, 0: off
+    uint32_t lastStatusPush {0};
+    uint32_t lastStatusResync {0};
+    void onStatusEvent(AsyncWebSocketClient *client, const AwsEventType type);
+    void loopStatus();
 public:
     Portal();
     void begin(bool configMode);
     void loop();
     void textAll(String text);
+    void setStatusRate(const uint8_t rate);
 };
 
 extern Portal portal;
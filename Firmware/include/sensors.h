@@ -2,19 +2,45 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include "jsonwriter.h"
 #include <AsyncTCP.h>
 
+/*
+    Temperature conversion of all 1-Wire sensors without blocking the main loop:
+    the conversion is started for all sensors at once, after the conversion time
+    of the highest resolution the scratchpads are read, one sensor per call of loop().
+*/
 class OneWireNode {
 private:
     String getAdr() const;
     OneWireNode *next;
     uint8_t addr[8];
-    double temp;
+    float temp;
+    uint8_t resolution {0}; // configured resolution in bits, 0: keep sensor setting
+    uint8_t curResolution {12};
+    bool converted {false}; // a valid temperature was read, 85 °C before is the power-on value
+    uint32_t numReads {0};
+    uint32_t numCrcErrors {0};
+    uint32_t numErrors {0}; // no response
+    void read();
+    void publish();
+    static enum ConvState {
+        CONV_IDLE,
+        CONV_WAIT,
+        CONV_READ
+    } convState;
+    static uint32_t convStart;
+    static uint16_t convTime;
+    static OneWireNode *readNode;
 public:
     OneWireNode(uint8_t *addr);
     static void begin();
     static void loop();
+    static void setConfig(JsonObject obj);
     static void writeJson(JsonObject &status);
+    static void writeJson(JsonWriter &w);
+    static void writeStatsJson(JsonObject &status);
+    static void writeStatsJson(JsonWriter &w);
     static OneWireNode* find(String adr);
     static bool sendDiscovery();
 };
@@ -32,15 +58,15 @@ public:
     };
     OneWireNode *own; // points to a OneWireNode if configured
     Sensor();
-    virtual void set(const double val, const Source src);
-    bool get(double &val);
+    virtual void set(const float val, const Source src);
+    bool get(float &val);
     virtual void setConfig(JsonObject &obj);
     bool isMqttSource();
     bool isOtSource();
     static void loopAll();
 protected:
     Source src;
-    double value;
+    float value;
     bool setFlag;
     virtual void loop() {}
 private:
@@ -51,9 +77,9 @@ private:
 class AutoSensor: public Sensor {
 public:
     AutoSensor();
-    void set(const double val, const Source src);
+    void set(const float val, const Source src);
 private:
-    double values[SOURCE_AUTO + 1];
+    float values[SOURCE_AUTO + 1];
 };
 
 class OutsideTemp: public Sensor {
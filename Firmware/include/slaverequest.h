@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <OpenTherm.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "otscheduler.h"
+
+/*
+    Raw requests to the OT slave issued via /slaverequest. add() returns a ticket
+    immediately, the request is sent by the scheduler between the regular frames
+    (in repeater mode between two frames of the room unit). The result is kept
+    until the slot is reused and announced once over the websocket.
+*/
+class OTSlaveRequests: public OTJob {
+public:
+    enum State: uint8_t {
+        REQ_FREE = 0,
+        REQ_QUEUED,
+        REQ_SENT,
+        REQ_DONE,
+        REQ_TIMEOUT,
+        REQ_INVALID,
+        REQ_UNAVAILABLE
+    };
+    struct Ticket {
+        uint32_t id;
+        unsigned long request;
+        unsigned long response;
+        uint32_t time; // millis, queued or sent
+        State state;
+        bool notified; // announced over the websocket
+        bool announce;
+    };
+private:
+    static const uint8_t SIZE = 16; // queued requests and kept results
+    static const uint32_t RESPONSE_TIMEOUT = 1500; // ms
+    Ticket tickets[SIZE];
+    uint32_t nextId {1};
+    uint32_t sendId {1}; // oldest ticket not sent yet
+    uint32_t sentId {0}; // ticket waiting for the response, 0: none
+    SemaphoreHandle_t mutex;
+    Ticket &slot(const uint32_t id);
+    void finish(Ticket &t, const State state, const unsigned long response);
+protected:
+    bool getRelease(const uint32_t now, uint32_t &release) override;
+    bool getRequest(unsigned long &request) override;
+    uint32_t getPeriod() const override;
+    void onSent(const uint32_t now) override;
+public:
+    OTSlaveRequests();
+    uint32_t add(const unsigned long request, const bool announce = true);
+    bool get(const uint32_t id, Ticket &ticket);
+    bool take(const uint32_t now, unsigned long &request);
+    bool onResponse(const unsigned long msg, const OpenThermResponseStatus status);
+    bool cancel(const uint32_t id);
+    void cancelAll();
+    bool popResult(Ticket &ticket);
+    static void getJson(const Ticket &ticket, JsonObject &obj);
+};
+
+extern OTSlaveRequests slaveRequests;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "jsonwriter.h"
+
+/*
+    Change tracking of a status document. Every field (object members are
+    followed, arrays and scalars are fields) is kept as hash of its path, hash
+    of its value and the epoch of its last change. update() compares a new
+    document against the table, getDelta() copies the fields changed after a
+    given epoch into a delta document of the same structure, so one tracker
+    serves consumers of any rate. Removed fields are not reported, consumers
+    resync with a full snapshot now and then.
+    Volatile fields (counters, measurements of the firmware itself) given as
+    paths like "wifi/rssi" are neither tracked nor part of the content hash,
+    getDelta() adds them on request.
+    There are no dirty flags at the producers of the status (OT values, sensors,
+    scheduler, ...): a delta still needs a full build of the document, only the
+    serialization and the traffic are saved, not the build.
+*/
+class StatusTracker {
+private:
+    static const uint16_t SIZE = 512; // open addressing, power of 2
+    static const uint8_t MAX_VOLATILE = 24;
+    struct Field {
+        uint32_t path;      // 0: free slot
+        uint32_t value;
+        uint32_t changed;   // epoch
+    } fields[SIZE];
+    uint32_t volatilePaths[MAX_VOLATILE];
+    uint8_t numVolatile {0};
+    uint32_t epoch {0};     // incremented by each update() with changes
+    uint32_t hash {0};      // of all tracked fields, set by update()
+    uint16_t numFields {0};
+    bool full {false};      // fields beyond SIZE are part of every delta
+    Field *find(const uint32_t path);
+    bool isVolatile(const uint32_t path) const;
+    uint16_t updateObject(JsonObjectConst src, const uint32_t parent);
+    uint16_t deltaObject(JsonObjectConst src, const uint32_t since, JsonObject dst, const uint32_t parent, const bool withVolatile);
+public:
+    StatusTracker(const char *const volatileFields[] = nullptr, const uint8_t num = 0);
+    uint16_t update(JsonObjectConst src);
+    uint16_t getDelta(JsonObjectConst src, const uint32_t since, JsonObject delta, const bool withVolatile = false);
+    uint32_t getEpoch() const;
+    uint32_t getHash() const;
+    void getJson(JsonObject &obj) const;
+    void writeJson(JsonWriter &w) const;
+};
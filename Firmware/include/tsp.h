@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <OpenTherm.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "otscheduler.h"
+
+/*
+    Cache of the transparent slave parameters (OT class 6) of the slave
+    application in use (boiler: ID 10/11, ventilation: 88/89, solar: 105/106).
+    The number of TSPs is read once, the index/value pairs are walked in the
+    slots the regular polling leaves over. Writes are queued in the cache (dirty)
+    and verified by reading the TSP back. Finished writes are announced over the
+    websocket.
+*/
+class OTTsp: public OTJob {
+public:
+    enum EntryState: uint8_t {
+        TSP_UNKNOWN = 0,    // not read yet
+        TSP_VALID,
+        TSP_INVALID,        // DATA_INVALID, index not readable
+        TSP_DIRTY,          // write pending
+        TSP_VERIFY,         // write acknowledged, read back pending
+        TSP_FAILED          // write rejected or read back differs
+    };
+    struct Entry {
+        uint8_t value;
+        uint8_t newValue;   // value to be written
+        EntryState state;
+        bool notify;        // write finished, not announced yet
+    };
+private:
+    static constexpr uint8_t MAX_TSP = 128;
+    static const uint32_t SPACING = 1000;   // ms between two requests
+    static const uint32_t RETRY = 10000;    // ms, request without response
+    enum State: uint8_t {
+        TSPS_OFF,           // not in master mode
+        TSPS_COUNT,         // number of TSPs to be read
+        TSPS_WALK,          // reading index/value pairs
+        TSPS_DONE,
+        TSPS_UNSUPPORTED
+    };
+    State state {TSPS_OFF};
+    uint8_t app {0};
+    OpenThermMessageID countId;
+    OpenThermMessageID valueId;
+    uint8_t count {0};
+    uint8_t walkNext {0};
+    bool awaiting {false};
+    bool sentWrite {false};
+    uint8_t sentIndex {0};
+    uint32_t lastSent {0};
+    Entry entries[MAX_TSP];
+    SemaphoreHandle_t mutex;
+    uint8_t numCached() const;
+    bool findPending(EntryState st, uint8_t &index) const;
+    void finishWrite(Entry &e, const EntryState st);
+protected:
+    bool getRelease(const uint32_t now, uint32_t &release) override;
+    bool getRequest(unsigned long &request) override;
+    uint32_t getPeriod() const override;
+    void onSent(const uint32_t now) override;
+public:
+    OTTsp();
+    void init(const bool enabled, const uint8_t slaveApp);
+    void onResponse(const unsigned long msg);
+    bool write(const uint8_t index, const uint8_t value);
+    void reload();
+    bool popResult(uint8_t &index, Entry &entry);
+    void getJson(JsonObject &obj);
+    static void getEntryJson(const uint8_t index, const Entry &entry, JsonObject &obj);
+};
+
+extern OTTsp tsp;
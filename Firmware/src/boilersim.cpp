@@ -0,0 +1,176 @@
+#include "boilersim.h"
+#include "otvalues.h"
+
+static const float DHW_FLOW_TEMP = 70.0; // flow temp. while heating DHW storage
+static const float DHW_EXCHANGE = 1.0; // kW/K, heat exchanger of DHW storage
+
+/**
+ * config: {"latency": 20}
+ */
+void BoilerSim::setConfig(JsonObject config) {
+    latency = constrain(config[F("latency")] | 20, 0, 750);
+}
+
+void BoilerSim::update(const uint32_t now) {
+    if (lastUpdate == 0) {
+        lastUpdate = now;
+        return;
+    }
+
+    float dt = (now - lastUpdate) / 1000.0f;
+    lastUpdate = now;
+    if (dt > 3600)
+        dt = 3600;
+
+    while (dt > 0) {
+        const float h = min(dt, 1.0f);
+        step(h);
+        dt -= h;
+    }
+}
+
+void BoilerSim::step(const float dt) {
+    const bool chEnable = (masterStatus & (1<<0)) != 0;
+    const bool dhwEnable = (masterStatus & (1<<1)) != 0;
+    const bool ch2Enable = (masterStatus & (1<<4)) != 0;
+
+    // DHW storage has priority, it is reheated when 5 K below set point
+    if (dhwEnable && (dhwTemp < tdhwSet - 5))
+        dhwActive = true;
+    if (!dhwEnable || (dhwTemp >= tdhwSet))
+        dhwActive = false;
+
+    float target = 0;
+    if (dhwActive)
+        target = DHW_FLOW_TEMP;
+    else if (chEnable || ch2Enable)
+        target = max(chEnable ? tSet : 0, ch2Enable ? tSetCH2 : 0);
+
+    // burner with on/off hysteresis and proportional modulation
+    if (!flame && (target > 0) && (flowTemp < target - 2)) {
+        flame = true;
+        if (dhwActive)
+            dhwBurnerStarts++;
+        else
+            burnerStarts++;
+    }
+    if ( flame && ((target <= 0) || (flowTemp > target + 3)) )
+        flame = false;
+
+    modulation = flame ? constrain(30 + (target - flowTemp) * 10, MIN_MODULATION, 100.0f) : 0;
+    if (flame) {
+        burnerHours += dt / 3600;
+        if (dhwActive)
+            dhwBurnerHours += dt / 3600;
+    }
+
+    const float power = MAX_POWER * modulation / 100;
+    float loss;
+    if (dhwActive) {
+        loss = DHW_EXCHANGE * (flowTemp - dhwTemp);
+        dhwTemp += loss * dt / DHW_CAPACITY;
+    }
+    else if (chEnable || ch2Enable)
+        loss = HEAT_LOSS * (flowTemp - ROOM_TEMP);
+    else
+        loss = 0.05 * (flowTemp - ROOM_TEMP); // pump off
+
+    flowTemp += (power - loss) * dt / WATER_CAPACITY;
+    dhwTemp -= DHW_LOSS * (dhwTemp - ROOM_TEMP) * dt / DHW_CAPACITY;
+
+    // CH2 is a mixed circuit fed by the boiler
+    const float ch2Target = ch2Enable ? min(tSetCH2, flowTemp) : ROOM_TEMP;
+    flowTempCH2 += (ch2Target - flowTempCH2) * dt / 120;
+}
+
+uint16_t BoilerSim::getStatus() const {
+    uint16_t status = 0;
+    const bool chEnable = (masterStatus & (1<<0)) != 0;
+    const bool ch2Enable = (masterStatus & (1<<4)) != 0;
+
+    if (flame && !dhwActive && chEnable)
+        status |= 1<<1; // CH mode
+    if (dhwActive)
+        status |= 1<<2; // DHW mode
+    if (flame)
+        status |= 1<<3;
+    if (ch2Enable)
+        status |= 1<<5; // CH2 mode
+    return status;
+}
+
+unsigned long BoilerSim::handleRequest(const unsigned long request) {
+    update(millis());
+
+    const auto id = OpenTherm::getDataID(request);
+    const auto mt = OpenTherm::getMessageType(request);
+    const uint16_t data = request & 0xFFFF;
+
+    if (mt == OpenThermMessageType::WRITE_DATA) {
+        const float f = OpenTherm::getFloat(request);
+        switch (id) {
+        case OpenThermMessageID::TSet:
+            tSet = f;
+            break;
+        case OpenThermMessageID::TsetCH2:
+            tSetCH2 = f;
+            break;
+        case OpenThermMessageID::TdhwSet:
+            tdhwSet = f;
+            break;
+        case OpenThermMessageID::Toutside:
+            break;
+        default:
+            if (OTValue::getThermostatValue(id) == nullptr)
+                return OpenTherm::buildResponse(OpenThermMessageType::UNKNOWN_DATA_ID, id, data);
+            break;
+        }
+        return OpenTherm::buildResponse(OpenThermMessageType::WRITE_ACK, id, data);
+    }
+
+    if (mt != OpenThermMessageType::READ_DATA)
+        return OpenTherm::buildResponse(OpenThermMessageType::DATA_INVALID, id, data);
+
+    uint16_t value;
+    switch (id) {
+    case OpenThermMessageID::Status:
+        masterStatus = data >> 8;
+        value = (data & 0xFF00) | getStatus();
+        break;
+    case OpenThermMessageID::Tboiler:
+        value = OpenTherm::temperatureToData(flowTemp);
+        break;
+    case OpenThermMessageID::TflowCH2:
+        value = OpenTherm::temperatureToData(flowTempCH2);
+        break;
+    case OpenThermMessageID::Tret:
+        value = OpenTherm::temperatureToData(ROOM_TEMP + (flowTemp - ROOM_TEMP) * 0.75f);
+        break;
+    case OpenThermMessageID::TboilerHeatExchanger:
+        value = OpenTherm::temperatureToData(flowTemp + (flame ? 5 : 0));
+        break;
+    case OpenThermMessageID::Tdhw:
+        value = OpenTherm::temperatureToData(dhwTemp);
+        break;
+    case OpenThermMessageID::TdhwSet:
+        value = OpenTherm::temperatureToData(tdhwSet);
+        break;
+    case OpenThermMessageID::RelModLevel:
+        value = OpenTherm::temperatureToData(modulation);
+        break;
+    case OpenThermMessageID::SuccessfulBurnerStarts:
+        value = burnerStarts + dhwBurnerStarts;
+        break;
+    case OpenThermMessageID::BurnerOperationHours:
+        value = burnerHours;
+        break;
+    case OpenThermMessageID::DHWBurnerOperationHours:
+        value = dhwBurnerHours;
+        break;
+    default:
+        if (!getOTloopback(id, value))
+            return OpenTherm::buildResponse(OpenThermMessageType::UNKNOWN_DATA_ID, id, data);
+        break;
+    }
+    return OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, value);
+}
@@ -0,0 +1,137 @@
+#include "cborwriter.h"
+#include <cmath>
+
+CborWriter::CborWriter(Print &out):
+        out(out) {
+}
+
+CborWriter::~CborWriter() {
+    flush();
+}
+
+void CborWriter::flush() {
+    if (len > 0)
+        out.write(buf, len);
+    len = 0;
+}
+
+void CborWriter::put(const uint8_t b) {
+    if (len >= BUF_SIZE)
+        flush();
+    buf[len++] = b;
+}
+
+/**
+ * Initial byte and argument in the shortest form.
+ */
+void CborWriter::putHead(const Major major, const uint32_t val) {
+    const uint8_t mt = major << 5;
+    if (val < 24)
+        put(mt | val);
+    else if (val <= 0xFF) {
+        put(mt | 24);
+        put(val);
+    }
+    else if (val <= 0xFFFF) {
+        put(mt | 25);
+        put(val >> 8);
+        put(val);
+    }
+    else {
+        put(mt | 26);
+        put(val >> 24);
+        put(val >> 16);
+        put(val >> 8);
+        put(val);
+    }
+}
+
+void CborWriter::putFloat(const float val) {
+    if (!std::isfinite(val)) {
+        put(0xF6); // null, as in the JSON status
+        return;
+    }
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    put(0xFA);
+    put(bits >> 24);
+    put(bits >> 16);
+    put(bits >> 8);
+    put(bits);
+}
+
+void CborWriter::key(const uint16_t key) {
+    putHead(CBOR_UINT, key);
+}
+
+void CborWriter::beginMap() {
+    put((CBOR_MAP << 5) | 31);
+}
+
+void CborWriter::beginMap(const uint16_t key) {
+    this->key(key);
+    beginMap();
+}
+
+void CborWriter::beginArray() {
+    put((CBOR_ARRAY << 5) | 31);
+}
+
+void CborWriter::beginArray(const uint16_t key) {
+    this->key(key);
+    beginArray();
+}
+
+void CborWriter::end() {
+    put(0xFF); // break
+}
+
+void CborWriter::addNull(const uint16_t key) {
+    this->key(key);
+    put(0xF6);
+}
+
+void CborWriter::key(const char *key) {
+    value(key);
+}
+
+void CborWriter::add(const uint16_t key, const char *val) {
+    this->key(key);
+    value(val);
+}
+
+void CborWriter::value(const char *val) {
+    const size_t n = strlen(val);
+    putHead(CBOR_TEXT, n);
+    for (size_t i=0; i<n; i++)
+        put(val[i]);
+}
+
+void CborWriter::value(JsonVariantConst val) {
+    if (val.is<JsonObjectConst>()) {
+        beginMap();
+        for (JsonPairConst kv: val.as<JsonObjectConst>()) {
+            key(kv.key().c_str());
+            value(kv.value());
+        }
+        end();
+    }
+    else if (val.is<JsonArrayConst>()) {
+        beginArray();
+        for (JsonVariantConst v: val.as<JsonArrayConst>())
+            value(v);
+        end();
+    }
+    else if (val.is<bool>())
+        value(val.as<bool>());
+    else if (val.is<int32_t>())
+        value(val.as<int32_t>());
+    else if (val.is<uint32_t>())
+        value(val.as<uint32_t>());
+    else if (val.is<float>())
+        value(val.as<float>());
+    else if (val.is<const char*>())
+        value(val.as<const char*>());
+    else
+        put(0xF6); // null
+}
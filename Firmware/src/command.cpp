@@ -1,6 +1,7 @@
 #include "command.h"
 #include "portal.h"
 #include "otvalues.h"
+#include "framelog.h"
 
 OtGwCommand command;
 
@@ -106,4 +107,12 @@ void OtGwCommand::sendOtEvent(const char source, const uint32_t data) {
 }
 
 void OtGwCommand::loop() {
+    OTFrame frame;
+    uint8_t n = 0;
+
+    // format and distribute the frames logged since last loop, limited to keep the loop responsive
+    while ( (n++ < 16) && framelog.pop(frame) ) {
+        if (frame.status != (uint8_t) OpenThermResponseStatus::TIMEOUT)
+            sendOtEvent(frame.source, frame.frame);
+    }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "mqtt.h"
 #include "otcontrol.h"
 #include "sensors.h"
+#include "portal.h"
 #include <HADiscovery.h>
 
 const char CFG_FILENAME[] PROGMEM = "/config.json";
@@ -55,6 +56,7 @@ void DevConfig::update() {
             HADiscovery::devName = doc[F("haName")].as<String>();
 
         timezone = doc[F("timezone")] | 3600;
+        portal.setStatusRate(doc[F("statusRate")] | 1);
 
         if (hostname.isEmpty())
             hostname = F(HOSTNAME);
@@ -73,6 +75,9 @@ void DevConfig::update() {
             mc.user = jobj["user"].as<String>();
             mc.pass = jobj["pass"].as<String>();
             mc.keepAlive = jobj["keepAlive"] | 15;
+            mc.delta = jobj["delta"] | false;
+            mc.fullInterval = jobj["fullInterval"] | 60;
+            mc.cbor = jobj["cbor"] | false;
             mqtt.setConfig(mc);
         }
 
@@ -84,6 +89,8 @@ void DevConfig::update() {
             outsideTemp.setConfig(obj);
         }
 
+        OneWireNode::setConfig(doc[F("oneWire")]);
+
         for (int i=0; i<2; i++) {
             JsonObject obj = doc[F("heating")][i][F("roomtemp")];
             roomTemp[i].setConfig(obj);
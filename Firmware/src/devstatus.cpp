@@ -1,14 +1,53 @@
 #include "devstatus.h"
 #include <WiFi.h>
 #include <rom/rtc.h>
+#include <StreamString.h>
 #include "mqtt.h"
 #include "otcontrol.h"
 #include "sensors.h"
 #include "httpUpdate.h"
+#include "framelog.h"
 
 DevStatus devstatus;
 
+namespace {
+class VectorPrint: public Print {
+private:
+    std::vector<uint8_t> &buf;
+public:
+    VectorPrint(std::vector<uint8_t> &buf): buf(buf) {}
+    size_t write(uint8_t c) override {
+        buf.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t *data, size_t len) override {
+        buf.insert(buf.end(), data, data + len);
+        return len;
+    }
+};
+}
+
+// fields of the device map of the compact status, not repeated with their name
+static const char *const DEVICE_FIELDS[] PROGMEM = {
+    "runtime", "freeHeap", "fw_version", "numWifiDisc", "outsideTemp", "wifi/rssi", "mqtt/connected"
+};
+
+// names of the heater circuit keys, other members of a heater circuit keep their name
+static const char *const HEATERCIRCUIT_KEYS[] PROGMEM = {
+    nullptr, "roomsetpoint", "roomtemp", "ovrdFlow", "mode", "suspended"
+};
+static_assert(sizeof(HEATERCIRCUIT_KEYS) / sizeof(HEATERCIRCUIT_KEYS[0]) == HKEY_SUSPENDED + 1);
+
+// fields changing with every build, ignored for the ETag and the epoch
+static const char *const VOLATILE_FIELDS[] PROGMEM = {
+    "runtime", "freeHeap", "dateTime", "snapshot", "framelog", "otTask", "scheduler", "repeaterCache",
+    "wifi/rssi", "slave/txCount", "slave/rxCount", "slave/timeouts",
+    "thermostat/txCount", "thermostat/rxCount", "thermostat/invalidCount", "thermostat/lateResponses",
+    "thermostat/droppedResponses", "thermostat/latency", "1wireStats"
+};
+
 DevStatus::DevStatus():
+        tracker(VOLATILE_FIELDS, sizeof(VOLATILE_FIELDS) / sizeof(VOLATILE_FIELDS[0])),
         numWifiDiscon(0) {
 }
 
@@ -21,29 +60,34 @@ void DevStatus::unlock() {
 }
 
 JsonDocument &DevStatus::buildDoc() {
-    doc.clear();
+    build(doc);
+    return doc;
+}
+
+void DevStatus::build(JsonDocument &dst, const bool withValues) {
+    dst.clear();
 
-    doc[F("runtime")] = millis() / 1000UL;
-    doc[F("freeHeap")] = ESP.getFreeHeap();
-    doc[F("resetInfo")] = rtc_get_reset_reason(0);
-    doc[F("fw_version")] = F(BUILD_VERSION);
-    doc[F("USB_connected")] = Serial.isConnected();
-    doc[F("reset_reason0")] = rtc_get_reset_reason(0);
-    doc[F("reset_reason1")] = rtc_get_reset_reason(1);
-    doc[F("numWifiDisc")] = numWifiDiscon;
+    dst[F("runtime")] = millis() / 1000UL;
+    dst[F("freeHeap")] = ESP.getFreeHeap();
+    dst[F("resetInfo")] = rtc_get_reset_reason(0);
+    dst[F("fw_version")] = F(BUILD_VERSION);
+    dst[F("USB_connected")] = Serial.isConnected();
+    dst[F("reset_reason0")] = rtc_get_reset_reason(0);
+    dst[F("reset_reason1")] = rtc_get_reset_reason(1);
+    dst[F("numWifiDisc")] = numWifiDiscon;
 
     String newFw;
     if (httpupdate.getNewFw(newFw))
-        doc[F("new_fw")] = newFw;
+        dst[F("new_fw")] = newFw;
 
     struct tm timeinfo;
     if (getLocalTime(&timeinfo, 0)) {
         char buffer[64];
         strftime(buffer, sizeof(buffer), "%d.%m.%Y %H:%M:%S", &timeinfo);
-        doc[F("dateTime")] = buffer;
+        dst[F("dateTime")] = buffer;
     }
 
-    JsonObject jwifi = doc[F("wifi")].to<JsonObject>();
+    JsonObject jwifi = dst[F("wifi")].to<JsonObject>();
     jwifi[F("status")] =  WiFi.status();
     jwifi[F("mode")] = WiFi.getMode();
     jwifi[F("ipsta")] = WiFi.localIP().toString();
@@ -55,30 +99,375 @@ JsonDocument &DevStatus::buildDoc() {
         jwifi[F("sta_ssid")] = WiFi.SSID();
         jwifi[F("rssi")] = WiFi.RSSI();
     }
-    JsonObject jmqtt = doc[F("mqtt")].to<JsonObject>();
+    JsonObject jmqtt = dst[F("mqtt")].to<JsonObject>();
     jmqtt[F("connected")] = mqtt.connected();
     jmqtt[F("basetopic")] = mqtt.getBaseTopic();
     jmqtt[F("numDisc")] = mqtt.getNumDisc();
 
-    JsonObject jot = doc.as<JsonObject>();
-    otcontrol.getJson(jot);
+    JsonObject jlog = dst[F("framelog")].to<JsonObject>();
+    jlog[F("frames")] = framelog.getHead();
+    jlog[F("lost")] = framelog.getLost();
 
-    double outT;
+    JsonObject jsnap = dst[F("snapshot")].to<JsonObject>();
+    jsnap[F("builds")] = numBuilds;
+    jsnap[F("shared")] = numShared;
+    JsonObject jjson = jsnap[F("json")].to<JsonObject>();
+    jjson[F("size")] = jsonStats.size;
+    jjson[F("us")] = jsonStats.micros;
+    if (cborStats.size > 0) {
+        JsonObject jcbor = jsnap[F("cbor")].to<JsonObject>();
+        jcbor[F("size")] = cborStats.size;
+        jcbor[F("us")] = cborStats.micros;
+    }
+    JsonObject jtracker = jsnap[F("tracker")].to<JsonObject>();
+    tracker.getJson(jtracker);
+
+    JsonObject jot = dst.as<JsonObject>();
+    otcontrol.getJson(jot, withValues);
+
+    float outT;
     if (outsideTemp.get(outT))
-        doc[F("outsideTemp")] = outT;
+        dst[F("outsideTemp")] = outT;
 
     if (!outsideTemp.owResult.isEmpty())
-        doc[F("owResult")] = outsideTemp.owResult;
+        dst[F("owResult")] = outsideTemp.owResult;
 
     if (oneWireNode) {
-        JsonObject jo = doc[F("1wire")].to<JsonObject>();
+        JsonObject jo = dst[F("1wire")].to<JsonObject>();
         OneWireNode::writeJson(jo);
+        JsonObject jstats = dst[F("1wireStats")].to<JsonObject>();
+        OneWireNode::writeStatsJson(jstats);
     }
-
-    return doc;
 }
 
 void DevStatus::getJson(String &str) {
     buildDoc();
     serializeJson(doc, str);
 }
+
+/**
+ * Same content as buildDoc(), streamed to out with a JsonWriter.
+ */
+void DevStatus::writeJson(Print &out) {
+    JsonWriter w(out);
+    w.beginObject();
+    w.add(PSTR("runtime"), millis() / 1000UL);
+    w.add(PSTR("freeHeap"), ESP.getFreeHeap());
+    w.add(PSTR("resetInfo"), (int) rtc_get_reset_reason(0));
+    w.add(PSTR("fw_version"), BUILD_VERSION);
+    w.add(PSTR("USB_connected"), (bool) Serial.isConnected());
+    w.add(PSTR("reset_reason0"), (int) rtc_get_reset_reason(0));
+    w.add(PSTR("reset_reason1"), (int) rtc_get_reset_reason(1));
+    w.add(PSTR("numWifiDisc"), numWifiDiscon);
+
+    String newFw;
+    if (httpupdate.getNewFw(newFw))
+        w.add(PSTR("new_fw"), newFw);
+
+    struct tm timeinfo;
+    if (getLocalTime(&timeinfo, 0)) {
+        char buffer[64];
+        strftime(buffer, sizeof(buffer), "%d.%m.%Y %H:%M:%S", &timeinfo);
+        w.add(PSTR("dateTime"), buffer);
+    }
+
+    w.beginObject(PSTR("wifi"));
+    w.add(PSTR("status"), (int) WiFi.status());
+    w.add(PSTR("mode"), (int) WiFi.getMode());
+    w.add(PSTR("ipsta"), WiFi.localIP().toString());
+    w.add(PSTR("mac"), WiFi.macAddress());
+    w.add(PSTR("hostname"), WiFi.getHostname());
+    if (WIRED_ETHERNET_PRESENT)
+        w.add(PSTR("sta_ssid"), "WIRED");
+    else {
+        w.add(PSTR("sta_ssid"), WiFi.SSID());
+        w.add(PSTR("rssi"), WiFi.RSSI());
+    }
+    w.endObject();
+
+    w.beginObject(PSTR("mqtt"));
+    w.add(PSTR("connected"), mqtt.connected());
+    w.add(PSTR("basetopic"), mqtt.getBaseTopic());
+    w.add(PSTR("numDisc"), mqtt.getNumDisc());
+    w.endObject();
+
+    w.beginObject(PSTR("framelog"));
+    w.add(PSTR("frames"), framelog.getHead());
+    w.add(PSTR("lost"), framelog.getLost());
+    w.endObject();
+
+    w.beginObject(PSTR("snapshot"));
+    w.add(PSTR("builds"), numBuilds);
+    w.add(PSTR("shared"), numShared);
+    w.beginObject(PSTR("json"));
+    w.add(PSTR("size"), jsonStats.size);
+    w.add(PSTR("us"), jsonStats.micros);
+    w.endObject();
+    if (cborStats.size > 0) {
+        w.beginObject(PSTR("cbor"));
+        w.add(PSTR("size"), cborStats.size);
+        w.add(PSTR("us"), cborStats.micros);
+        w.endObject();
+    }
+    w.beginObject(PSTR("tracker"));
+    tracker.writeJson(w);
+    w.endObject();
+    w.endObject();
+
+    otcontrol.writeJson(w);
+
+    float outT;
+    if (outsideTemp.get(outT))
+        w.add(PSTR("outsideTemp"), outT);
+
+    if (!outsideTemp.owResult.isEmpty())
+        w.add(PSTR("owResult"), outsideTemp.owResult);
+
+    if (oneWireNode) {
+        w.beginObject(PSTR("1wire"));
+        OneWireNode::writeJson(w);
+        w.endObject();
+        w.beginObject(PSTR("1wireStats"));
+        OneWireNode::writeStatsJson(w);
+        w.endObject();
+    }
+    w.endObject();
+}
+
+#ifdef DEBUG
+static void removeVolatile(JsonObject obj) {
+    for (const char *field: VOLATILE_FIELDS) {
+        String path = FPSTR(field);
+        JsonObject parent = obj;
+        int start = 0;
+        int end;
+        while ((end = path.indexOf('/', start)) >= 0) {
+            parent = parent[path.substring(start, end)].as<JsonObject>();
+            start = end + 1;
+        }
+        parent.remove(path.substring(start));
+    }
+}
+
+/**
+ * Compares the document of buildDoc() with the output of writeJson(), volatile fields
+ * aside. Values updated by the OT task in between show up as differences as well.
+ */
+void DevStatus::checkParity(JsonObject &obj) {
+    lock();
+    StreamString str;
+    writeJson(str);
+    JsonDocument streamDoc;
+    deserializeJson(streamDoc, str);
+    buildDoc();
+
+    JsonObject jdoc = doc.as<JsonObject>();
+    JsonObject jstream = streamDoc.as<JsonObject>();
+    removeVolatile(jdoc);
+    removeVolatile(jstream);
+    obj[F("equal")] = (jdoc == jstream);
+    JsonArray jdiff = obj[F("differences")].to<JsonArray>();
+    for (JsonPair kv: jdoc)
+        if (kv.value() != jstream[kv.key()])
+            jdiff.add(kv.key());
+    for (JsonPair kv: jstream)
+        if (jdoc[kv.key()].isNull() && !kv.value().isNull())
+            jdiff.add(kv.key());
+    unlock();
+}
+#endif
+
+/**
+ * Status serialized at most once per SNAPSHOT_MAX_AGE, all consumers within that
+ * time get the same buffer. Must not be called while locked.
+ */
+std::shared_ptr<const DevStatus::Snapshot> DevStatus::getSnapshot() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return currentSnapshot();
+}
+
+/**
+ * Same snapshot as getSnapshot(), delta receives the fields changed after the epoch
+ * since, i.e. nothing if since is the epoch of the snapshot. Volatile fields are
+ * only part of a delta withVolatile, then always. One tracker for all consumers
+ * (websocket, MQTT). The changes are found in the document of the snapshot, so a
+ * delta costs a full build of the status once per SNAPSHOT_MAX_AGE.
+ */
+std::shared_ptr<const DevStatus::Snapshot> DevStatus::getDelta(const uint32_t since, JsonObject delta, const bool withVolatile) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto snap = currentSnapshot();
+    if ( (snap->epoch != since) || withVolatile )
+        tracker.getDelta(snapDoc.as<JsonObjectConst>(), since, delta, withVolatile);
+    return snap;
+}
+
+/**
+ * Called with the mutex taken. The document of the snapshot is kept for getDelta(),
+ * the tracker runs over it instead of parsing the serialized status again.
+ */
+std::shared_ptr<const DevStatus::Snapshot> DevStatus::currentSnapshot() {
+    if ( snapshot && (millis() - snapshot->built < SNAPSHOT_MAX_AGE) ) {
+        numShared++;
+        return snapshot;
+    }
+
+    numBuilds++;
+    auto snap = std::make_shared<Snapshot>();
+    const uint32_t t = micros();
+    build(snapDoc);
+    StreamString str;
+    str.reserve(snapshot ? snapshot->json.length() + 256 : 4096);
+    serializeJson(snapDoc, str);
+    snap->json = std::move(str);
+    jsonStats.micros = micros() - t;
+    jsonStats.size = snap->json.length();
+
+    tracker.update(snapDoc.as<JsonObjectConst>());
+    snap->hash = tracker.getHash();
+    snap->epoch = tracker.getEpoch();
+    snap->built = millis();
+    snapshot = snap;
+    return snapshot;
+}
+
+static bool isDeviceField(const char *parent, const char *name) {
+    for (const char *field: DEVICE_FIELDS) {
+        const char *slash = strchr(field, '/');
+        if (slash == nullptr) {
+            if ( (parent == nullptr) && (strcmp(field, name) == 0) )
+                return true;
+        }
+        else if ( (parent != nullptr) && (strncmp(field, parent, slash - field) == 0) &&
+                (parent[slash - field] == 0) && (strcmp(slash + 1, name) == 0) )
+            return true;
+    }
+    return false;
+}
+
+// members of obj with their name, device fields left out
+static void writeCborMembers(CborWriter &w, JsonObjectConst obj, const char *parent) {
+    for (JsonPairConst kv: obj) {
+        const char *name = kv.key().c_str();
+        if (isDeviceField(parent, name))
+            continue;
+        w.key(name);
+        w.value(kv.value());
+    }
+}
+
+static void writeCborHeaterCircuit(CborWriter &w, JsonObjectConst hc) {
+    w.beginMap();
+    for (JsonPairConst kv: hc) {
+        uint8_t key = HKEY_ROOMSETPOINT;
+        while ( (key <= HKEY_SUSPENDED) && (strcmp(HEATERCIRCUIT_KEYS[key], kv.key().c_str()) != 0) )
+            key++;
+        if (key <= HKEY_SUSPENDED)
+            w.key(key);
+        else
+            w.key(kv.key().c_str());
+        w.value(kv.value());
+    }
+    w.end();
+}
+
+/**
+ * Compact status for high frequency pollers, the same model as /status: OT values
+ * keyed by data ID, the heater circuits and the basic device info with numeric keys,
+ * all other members with their name. See getSchemaJson() for the key names.
+ * Built from a status document without the OT values.
+ */
+void DevStatus::writeCbor(Print &out) {
+    JsonDocument rest;
+    build(rest, false);
+
+    CborWriter w(out);
+    w.beginMap();
+
+    w.beginMap(SKEY_DEVICE);
+    w.add(DKEY_RUNTIME, rest[F("runtime")].as<uint32_t>());
+    w.add(DKEY_FREEHEAP, rest[F("freeHeap")].as<uint32_t>());
+    w.add(DKEY_FWVERSION, BUILD_VERSION);
+    if (!rest[F("wifi")][F("rssi")].isNull())
+        w.add(DKEY_RSSI, rest[F("wifi")][F("rssi")].as<int>());
+    w.add(DKEY_NUMWIFIDISC, numWifiDiscon);
+    w.add(DKEY_MQTTCONNECTED, rest[F("mqtt")][F("connected")].as<bool>());
+    if (!rest[F("outsideTemp")].isNull())
+        w.add(DKEY_OUTSIDETEMP, rest[F("outsideTemp")].as<float>());
+    w.end();
+
+    for (JsonPairConst kv: rest.as<JsonObjectConst>()) {
+        const char *name = kv.key().c_str();
+        const bool thermostat = (strcmp(name, "thermostat") == 0);
+        if ( thermostat || (strcmp(name, "slave") == 0) ) {
+            w.beginMap(thermostat ? SKEY_THERMOSTAT : SKEY_SLAVE);
+            otcontrol.writeCbor(w, thermostat);
+            writeCborMembers(w, kv.value().as<JsonObjectConst>(), name);
+            w.end();
+        }
+        else if (strcmp(name, "heatercircuit") == 0) {
+            w.beginArray(SKEY_HEATERCIRCUIT);
+            for (JsonObjectConst hc: kv.value().as<JsonArrayConst>())
+                writeCborHeaterCircuit(w, hc);
+            w.end();
+        }
+        else if (!isDeviceField(nullptr, name)) {
+            w.key(name);
+            if (kv.value().is<JsonObjectConst>()) {
+                w.beginMap();
+                writeCborMembers(w, kv.value().as<JsonObjectConst>(), name);
+                w.end();
+            }
+            else
+                w.value(kv.value());
+        }
+    }
+    w.end();
+}
+
+/**
+ * Like getSnapshot(), serialized at most once per SNAPSHOT_MAX_AGE.
+ */
+std::shared_ptr<const DevStatus::CborSnapshot> DevStatus::getCborSnapshot() {
+    std::lock_guard<std::mutex> guard(mutex);
+    if ( cborSnapshot && (millis() - cborSnapshot->built < SNAPSHOT_MAX_AGE) )
+        return cborSnapshot;
+
+    const uint32_t t = micros();
+    auto snap = std::make_shared<CborSnapshot>();
+    snap->data.reserve(cborSnapshot ? cborSnapshot->data.size() + 32 : 512);
+    VectorPrint out(snap->data);
+    writeCbor(out);
+    snap->built = millis();
+    cborStats.micros = micros() - t;
+    cborStats.size = snap->data.size();
+    cborSnapshot = snap;
+    return cborSnapshot;
+}
+
+/**
+ * Names of the numeric keys of the compact status.
+ */
+void DevStatus::getSchemaJson(JsonObject &obj) {
+    obj[F("encoding")] = F("cbor");
+    obj[F("model")] = F("/status, members without a numeric key keep their name");
+    JsonObject jkeys = obj[F("keys")].to<JsonObject>();
+    jkeys[String(SKEY_DEVICE)] = F("device");
+    jkeys[String(SKEY_SLAVE)] = F("slave");
+    jkeys[String(SKEY_THERMOSTAT)] = F("thermostat");
+    jkeys[String(SKEY_HEATERCIRCUIT)] = F("heatercircuit");
+
+    JsonObject jdev = obj[F("device")].to<JsonObject>();
+    jdev[String(DKEY_RUNTIME)] = F("runtime");
+    jdev[String(DKEY_FREEHEAP)] = F("freeHeap");
+    jdev[String(DKEY_FWVERSION)] = F("fw_version");
+    jdev[String(DKEY_RSSI)] = F("rssi");
+    jdev[String(DKEY_NUMWIFIDISC)] = F("numWifiDisc");
+    jdev[String(DKEY_MQTTCONNECTED)] = F("mqttConnected");
+    jdev[String(DKEY_OUTSIDETEMP)] = F("outsideTemp");
+
+    otcontrol.getSchemaJson(obj);
+
+    JsonObject jhc = obj[F("heatercircuit")].to<JsonObject>();
+    for (uint8_t key=HKEY_ROOMSETPOINT; key<=HKEY_SUSPENDED; key++)
+        jhc[String(key)] = FPSTR(HEATERCIRCUIT_KEYS[key]);
+}
@@ -0,0 +1,173 @@
+#include "faulthistory.h"
+#include "otcaps.h"
+#include "HADiscLocal.h"
+
+OTFaultHistory::OTFaultHistory(const OpenThermMessageID sizeId, const OpenThermMessageID entryId, const OpenThermMessageID keyId1,
+                               const OpenThermMessageID keyId2, const char *name, const char *haName):
+        OTJob(PRIO_BACKGROUND),
+        sizeId(sizeId),
+        entryId(entryId),
+        keyId {keyId1, keyId2},
+        name(name),
+        haName(haName) {
+}
+
+/**
+ * Called from OTControl::setOTMode(), the cached entries are kept.
+ * @param enabled master mode and slave application matching
+ */
+void OTFaultHistory::init(const bool enabled) {
+    awaiting = false;
+    if (!enabled)
+        state = FH_OFF;
+    else if (otcaps.isUnsupported(sizeId))
+        state = FH_UNSUPPORTED;
+    else
+        state = FH_SIZE;
+    discFlag = false;
+}
+
+uint8_t OTFaultHistory::numCached() const {
+    return min(size, MAX_ENTRIES);
+}
+
+bool OTFaultHistory::getRelease(const uint32_t now, uint32_t &release) {
+    if ( (state != FH_SIZE) && (state != FH_ENTRIES) )
+        return false;
+
+    release = lastSent + (awaiting ? RETRY : SPACING);
+    return true;
+}
+
+bool OTFaultHistory::getRequest(unsigned long &request) {
+    if (state == FH_SIZE)
+        request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, sizeId, 0);
+    else
+        request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, entryId, next << 8);
+    return true;
+}
+
+uint32_t OTFaultHistory::getPeriod() const {
+    return 0;
+}
+
+void OTFaultHistory::onSent(const uint32_t now) {
+    lastSent = now;
+    awaiting = true;
+}
+
+/**
+ * Called for every response of the slave, also in repeater mode where the room
+ * unit may read the buffer itself.
+ */
+void OTFaultHistory::onResponse(const unsigned long msg) {
+    const auto id = OpenTherm::getDataID(msg);
+    const auto mt = OpenTherm::getMessageType(msg);
+    const uint16_t data = msg & 0xFFFF;
+
+    for (uint8_t i=0; i<2; i++) {
+        if ( (id != keyId[i]) || (mt != OpenThermMessageType::READ_ACK) )
+            continue;
+
+        if (keyValid[i] && (key[i] != data) && (state == FH_DONE))
+            state = FH_SIZE;
+        key[i] = data;
+        keyValid[i] = true;
+        return; // both key IDs may be the same
+    }
+
+    if (id == sizeId) {
+        switch (mt) {
+        case OpenThermMessageType::READ_ACK:
+            size = data >> 8;
+            next = 0;
+            numRead = 0;
+            if (state == FH_SIZE)
+                state = (size > 0) ? FH_ENTRIES : FH_DONE;
+            discFlag = false;
+            break;
+        case OpenThermMessageType::UNKNOWN_DATA_ID:
+            state = FH_UNSUPPORTED;
+            discFlag = false;
+            break;
+        default:
+            return;
+        }
+        awaiting = false;
+    }
+    else if (id == entryId) {
+        const uint8_t index = data >> 8;
+        switch (mt) {
+        case OpenThermMessageType::READ_ACK:
+            if (index < numCached()) {
+                entries[index] = data & 0xFF;
+                if (index >= numRead)
+                    numRead = index + 1;
+            }
+            break;
+        case OpenThermMessageType::DATA_INVALID:
+            break;
+        case OpenThermMessageType::UNKNOWN_DATA_ID:
+            state = FH_UNSUPPORTED;
+            awaiting = false;
+            return;
+        default:
+            return;
+        }
+
+        if ( (state == FH_ENTRIES) && (index == next) ) {
+            awaiting = false;
+            if (++next >= numCached()) {
+                state = FH_DONE;
+                numReads++;
+            }
+        }
+    }
+}
+
+void OTFaultHistory::getJson(JsonObject &obj) const {
+    if ( (state == FH_OFF) || (state == FH_UNSUPPORTED) || ((state == FH_SIZE) && (numReads == 0)) )
+        return;
+
+    JsonObject jfh = obj[FPSTR(name)].to<JsonObject>();
+    jfh[F("size")] = size;
+    jfh[F("complete")] = (state == FH_DONE);
+    jfh[F("reads")] = numReads;
+    JsonArray jentries = jfh[F("entries")].to<JsonArray>();
+    for (uint8_t i=0; i<numRead; i++)
+        jentries.add(entries[i]);
+}
+
+void OTFaultHistory::writeJson(JsonWriter &w) const {
+    if ( (state == FH_OFF) || (state == FH_UNSUPPORTED) || ((state == FH_SIZE) && (numReads == 0)) )
+        return;
+
+    w.beginObject(name);
+    w.add(PSTR("size"), size);
+    w.add(PSTR("complete"), (state == FH_DONE));
+    w.add(PSTR("reads"), numReads);
+    w.beginArray(PSTR("entries"));
+    for (uint8_t i=0; i<numRead; i++)
+        w.add(nullptr, entries[i]);
+    w.endArray();
+    w.endObject();
+}
+
+bool OTFaultHistory::sendDiscovery() {
+    haDisc.createSensor(FPSTR(haName), FPSTR(name));
+    haDisc.setStateClass("");
+    haDisc.setIcon(F("mdi:history"));
+    String valTmpl = F("{{ value_json.slave.#0.entries | join(' ') | truncate(255) if value_json.slave.#0 is defined else '' }}");
+    valTmpl.replace("#0", FPSTR(name));
+    haDisc.setValueTemplate(valTmpl);
+    return haDisc.publish( (state != FH_OFF) && (state != FH_UNSUPPORTED) );
+}
+
+void OTFaultHistory::loopDiscovery() {
+    if (!discFlag)
+        discFlag = sendDiscovery();
+}
+
+void OTFaultHistory::refreshDisc() {
+    discFlag = false;
+}
@@ -0,0 +1,129 @@
+#include "framelog.h"
+
+OTFrameLog framelog;
+
+/**
+ * May be called from several tasks, a slot is reserved by incrementing head.
+ */
+void OTFrameLog::push(const char source, const uint32_t frame, const OpenThermResponseStatus status) {
+    const uint32_t idx = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = ring[idx & (SIZE - 1)];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frame.micros = micros();
+    slot.frame.frame = frame;
+    slot.frame.source = source;
+    slot.frame.status = (uint8_t) status;
+    slot.frame.reserved = 0;
+    slot.seq.store(idx + 1, std::memory_order_release);
+}
+
+/**
+ * @returns false if frame idx is not complete yet or already overwritten
+ */
+bool OTFrameLog::read(const uint32_t idx, OTFrame &frame) {
+    const Slot &slot = ring[idx & (SIZE - 1)];
+
+    if (slot.seq.load(std::memory_order_acquire) != idx + 1)
+        return false;
+
+    frame = slot.frame;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == idx + 1;
+}
+
+/**
+ * Takes the next frame, single consumer only (OtGwCommand::loop)
+ */
+bool OTFrameLog::pop(OTFrame &frame) {
+    while (true) {
+        const uint32_t h = head.load(std::memory_order_acquire);
+        if (tail == h)
+            return false;
+
+        if (h - tail > SIZE) {
+            // consumer was too slow
+            numLost += h - tail - SIZE;
+            tail = h - SIZE;
+        }
+
+        if (read(tail, frame)) {
+            tail++;
+            return true;
+        }
+
+        if (head.load(std::memory_order_acquire) - tail < SIZE)
+            return false; // still being written, try again later
+
+        numLost++;
+        tail++;
+    }
+}
+
+uint32_t OTFrameLog::getHead() const {
+    return head.load(std::memory_order_acquire);
+}
+
+uint32_t OTFrameLog::getLost() const {
+    return numLost;
+}
+
+size_t OTFrameLog::getCaptureSize(const uint32_t count) const {
+    return CAPTURE_HEADER_SIZE + count * CAPTURE_RECORD_SIZE;
+}
+
+static void putU16(uint8_t *p, const uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void putU32(uint8_t *p, const uint32_t v) {
+    putU16(p, v);
+    putU16(p + 2, v >> 16);
+}
+
+/**
+ * Response filler for the binary capture of frames start ... start + count - 1
+ */
+size_t OTFrameLog::fillCapture(const uint32_t start, const uint32_t count, const uint32_t now, uint8_t *buf, size_t maxLen, size_t index) {
+    const size_t total = getCaptureSize(count);
+    size_t len = 0;
+
+    while ( (len < maxLen) && (index + len < total) ) {
+        const size_t pos = index + len;
+        uint8_t rec[CAPTURE_HEADER_SIZE];
+        size_t recSize;
+        size_t offs;
+
+        if (pos < CAPTURE_HEADER_SIZE) {
+            memcpy(rec, "OTCP", 4);
+            putU16(rec + 4, CAPTURE_VERSION);
+            putU16(rec + 6, CAPTURE_RECORD_SIZE);
+            putU32(rec + 8, count);
+            putU32(rec + 12, now);
+            recSize = CAPTURE_HEADER_SIZE;
+            offs = pos;
+        }
+        else {
+            const uint32_t n = (pos - CAPTURE_HEADER_SIZE) / CAPTURE_RECORD_SIZE;
+            OTFrame frame;
+            if (!read(start + n, frame)) {
+                memset(&frame, 0, sizeof(frame));
+                frame.status = STATUS_LOST;
+            }
+            putU32(rec, frame.micros);
+            putU32(rec + 4, frame.frame);
+            rec[8] = frame.source;
+            rec[9] = frame.status;
+            putU16(rec + 10, 0);
+            recSize = CAPTURE_RECORD_SIZE;
+            offs = (pos - CAPTURE_HEADER_SIZE) % CAPTURE_RECORD_SIZE;
+        }
+
+        const size_t n = min(recSize - offs, maxLen - len);
+        memcpy(buf + len, rec + offs, n);
+        len += n;
+    }
+    return len;
+}
@@ -0,0 +1,24 @@
+#include "heatingcurve.h"
+
+void HeatingCurve::build(const float flowMax, const float exponent, const float gradient, const float offset, const float roomSet) {
+    const float minOutside = roomSet - (flowMax - roomSet) / gradient;
+    const float c1 = (flowMax - roomSet) / powf(roomSet - minOutside, 1.0f / exponent);
+
+    valid = false;
+    for (uint8_t i=0; i<POINTS; i++) {
+        // no heating demand above room set point
+        const float dt = max(roomSet - (T_MIN + i), 0.0f);
+        flow[i] = roomSet + c1 * powf(dt, 1.0f / exponent) + offset;
+    }
+    this->roomSet = roomSet;
+    valid = true;
+}
+
+/**
+ * linear interpolation of the table, constant outside of T_MIN ... T_MAX
+ */
+float HeatingCurve::get(const float outTmp) const {
+    const float x = constrain(outTmp, (float) T_MIN, (float) T_MAX) - T_MIN;
+    const uint8_t i = min((int) x, POINTS - 2);
+    return flow[i] + (flow[i + 1] - flow[i]) * (x - i);
+}
@@ -0,0 +1,156 @@
+#include "idscan.h"
+#include "slaverequest.h"
+#include "otvalues.h"
+#include "portal.h"
+
+OTIdScan idscan;
+
+/**
+ * Called from the web server task, the scan starts with the next loop().
+ */
+void OTIdScan::start(const uint8_t first, const uint8_t last) {
+    reqFirst = min(first, last);
+    reqLast = max(first, last);
+    startFlag = true;
+}
+
+void OTIdScan::abort() {
+    abortFlag = true;
+}
+
+void OTIdScan::loop() {
+    if (abortFlag) {
+        abortFlag = false;
+        running = false;
+        cancelPending();
+    }
+
+    if (startFlag) {
+        startFlag = false;
+        cancelPending();
+        first = reqFirst;
+        last = reqLast;
+        next = first;
+        numDone = 0;
+        memset(map, 0, sizeof(map));
+        running = true;
+    }
+
+    if (!running)
+        return;
+
+    for (auto &p: pending) {
+        if (p.ticket) {
+            OTSlaveRequests::Ticket ticket;
+            if (!slaveRequests.get(p.ticket, ticket)) {
+                // slot was reused by other requests, ask again
+                next = min(next, (uint16_t) p.id);
+                p.ticket = 0;
+                continue;
+            }
+
+            switch (ticket.state) {
+            case OTSlaveRequests::REQ_DONE:
+                switch (OpenTherm::getMessageType(ticket.response)) {
+                case OpenThermMessageType::READ_ACK:
+                    onResult(p.id, SCAN_SUPPORTED, ticket.response & 0xFFFF);
+                    break;
+                case OpenThermMessageType::UNKNOWN_DATA_ID:
+                    onResult(p.id, SCAN_UNKNOWN_ID, ticket.response & 0xFFFF);
+                    break;
+                default:
+                    onResult(p.id, SCAN_INVALID, ticket.response & 0xFFFF);
+                    break;
+                }
+                break;
+            case OTSlaveRequests::REQ_TIMEOUT:
+            case OTSlaveRequests::REQ_INVALID:
+                onResult(p.id, SCAN_TIMEOUT, 0);
+                break;
+            case OTSlaveRequests::REQ_UNAVAILABLE:
+                onResult(p.id, SCAN_FAILED, 0);
+                break;
+            default:
+                continue; // still queued
+            }
+            p.ticket = 0;
+        }
+
+        // IDs before next may be in the pipeline or done already after a rewind
+        while ( (next <= last) && ((map[next].result != SCAN_NONE) || isPending(next)) )
+            next++;
+
+        if (!p.ticket && (next <= last)) {
+            const unsigned long req = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, (OpenThermMessageID) next, 0x0000);
+            p.ticket = slaveRequests.add(req, false);
+            if (p.ticket)
+                p.id = next++;
+        }
+    }
+
+    if (numDone > last - first) {
+        running = false;
+        portal.textAll(F("{\"idscan\":{\"done\":true}}"));
+    }
+}
+
+bool OTIdScan::isPending(const uint8_t id) const {
+    for (auto &p: pending)
+        if (p.ticket && (p.id == id))
+            return true;
+    return false;
+}
+
+/**
+ * Withdraws the queued requests of the scan, a new scan must not receive their results.
+ */
+void OTIdScan::cancelPending() {
+    for (auto &p: pending)
+        if (p.ticket)
+            slaveRequests.cancel(p.ticket);
+    memset(pending, 0, sizeof(pending));
+}
+
+void OTIdScan::onResult(const uint8_t id, const Result result, const uint16_t value) {
+    if (map[id].result == SCAN_NONE)
+        numDone++;
+    map[id].result = result;
+    map[id].value = value;
+
+    JsonDocument doc;
+    JsonObject jobj = doc[F("idscan")].to<JsonObject>();
+    getEntryJson(id, map[id], jobj);
+    String str;
+    serializeJson(doc, str);
+    portal.textAll(str);
+}
+
+void OTIdScan::getEntryJson(const uint8_t id, const Entry &entry, JsonObject &obj) {
+    static const char *RESULTS[] = {"none", "supported", "unknown", "invalid", "timeout", "failed"};
+
+    obj[F("id")] = id;
+    const char *name = getOTname((OpenThermMessageID) id);
+    if (name)
+        obj[F("name")] = FPSTR(name);
+    obj[F("result")] = RESULTS[entry.result];
+    if ( (entry.result == SCAN_SUPPORTED) || (entry.result == SCAN_INVALID) )
+        obj[F("data")] = String(entry.value, 16);
+}
+
+/**
+ * {"running": true, "first": 0, "last": 127, "done": 12, "map": [{"id": 0, "result": "supported", ...}, ...]}
+ */
+void OTIdScan::getJson(JsonObject &obj) {
+    obj[F("running")] = running;
+    obj[F("first")] = first;
+    obj[F("last")] = last;
+    obj[F("done")] = numDone;
+
+    JsonArray jmap = obj[F("map")].to<JsonArray>();
+    for (uint16_t id=first; id<=last; id++) {
+        if (map[id].result == SCAN_NONE)
+            continue;
+        JsonObject jentry = jmap.add<JsonObject>();
+        getEntryJson(id, map[id], jentry);
+    }
+}
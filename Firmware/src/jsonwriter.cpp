@@ -0,0 +1,148 @@
+#include "jsonwriter.h"
+#include <cmath>
+
+JsonWriter::JsonWriter(Print &out):
+        out(out) {
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+void JsonWriter::flush() {
+    if (len > 0)
+        out.write((const uint8_t*) buf, len);
+    len = 0;
+}
+
+void JsonWriter::put(const char c) {
+    if (len >= BUF_SIZE)
+        flush();
+    buf[len++] = c;
+}
+
+void JsonWriter::put(const char *str) {
+    while (*str)
+        put(*str++);
+}
+
+void JsonWriter::putString(const char *str) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    put('"');
+    for (; *str; str++) {
+        const uint8_t c = *str;
+        switch (c) {
+        case '"':
+        case '\\':
+            put('\\');
+            put(c);
+            break;
+        case '\n':
+            put("\\n");
+            break;
+        case '\r':
+            put("\\r");
+            break;
+        case '\t':
+            put("\\t");
+            break;
+        default:
+            if (c < 0x20) {
+                put("\\u00");
+                put(HEX_DIGITS[c >> 4]);
+                put(HEX_DIGITS[c & 0x0F]);
+            }
+            else
+                put(c);
+            break;
+        }
+    }
+    put('"');
+}
+
+void JsonWriter::putFloat(const float val) {
+    if (!std::isfinite(val)) {
+        put("null");
+        return;
+    }
+    char str[16];
+    snprintf(str, sizeof(str), "%.7g", val);
+    put(str);
+}
+
+void JsonWriter::putInt(const int32_t val) {
+    if (val < 0) {
+        put('-');
+        putUInt(-(int64_t) val);
+    }
+    else
+        putUInt(val);
+}
+
+void JsonWriter::putUInt(uint32_t val) {
+    char str[11];
+    uint8_t i = sizeof(str);
+    do {
+        str[--i] = '0' + val % 10;
+        val /= 10;
+    } while (val);
+    while (i < sizeof(str))
+        put(str[i++]);
+}
+
+/**
+ * Separator and key of the next member, only the separator for array elements.
+ */
+void JsonWriter::key(const char *key) {
+    if (first & (1UL << depth))
+        first &= ~(1UL << depth);
+    else
+        put(',');
+
+    if (key) {
+        putString(key);
+        put(':');
+    }
+}
+
+void JsonWriter::open(const char *key, const char c) {
+    this->key(key);
+    put(c);
+    depth++;
+    first |= 1UL << depth;
+}
+
+void JsonWriter::close(const char c) {
+    put(c);
+    first &= ~(1UL << depth);
+    depth--;
+}
+
+void JsonWriter::beginObject(const char *key) {
+    open(key, '{');
+}
+
+void JsonWriter::endObject() {
+    close('}');
+}
+
+void JsonWriter::beginArray(const char *key) {
+    open(key, '[');
+}
+
+void JsonWriter::endArray() {
+    close(']');
+}
+
+void JsonWriter::add(const char *key, const char *val) {
+    this->key(key);
+    if (val)
+        putString(val);
+    else
+        put("null");
+}
+
+void JsonWriter::add(const char *key, const String &val) {
+    add(key, val.c_str());
+}
@@ -10,6 +10,7 @@
 #include "devstatus.h"
 #include "devconfig.h"
 #include "command.h"
+#include "otcaps.h"
 #include "sensors.h"
 #include "HADiscLocal.h"
 #include <esp_wifi.h>
@@ -194,6 +195,7 @@ void setup() {
     }
   }
 #endif
+  otcaps.begin();
   otcontrol.begin();
 
   statusLedTicker.attach(0.2, statusLedLoop);
@@ -263,10 +265,12 @@ void loop() {
 #endif
     portal.loop();
     mqtt.loop();
-    otcontrol.loop();
+    otcontrol.loopDiscovery();
+    command.loop();
     Sensor::loopAll();
     devconfig.loop();
     OneWireNode::loop();
+    otcaps.loop();
 #ifdef NODO
     static unsigned long lastDisplayUpdate = 0;
     if (now - lastDisplayUpdate > 1000) { 
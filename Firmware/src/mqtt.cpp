@@ -6,6 +6,7 @@
 #include "sensors.h"
 #include "HADiscLocal.h"
 #include "hwdef.h"
+#include "tsp.h"
 
 static struct {
     Mqtt::MqttTopic topic;
@@ -29,7 +30,8 @@ static struct {
     {Mqtt::TOPIC_VENTENABLE, "ventEnable"},
     {Mqtt::TOPIC_OPENBYPASS, "openBypass"},
     {Mqtt::TOPIC_AUTOBYPASS, "autoBypass"},
-    {Mqtt::TOPIC_FREEVENTENABLE, "freeVentEnable"}
+    {Mqtt::TOPIC_FREEVENTENABLE, "freeVentEnable"},
+    {Mqtt::TOPIC_TSP, "tsp"}
 };
 
 Mqtt mqtt;
@@ -80,6 +82,7 @@ void Mqtt::onConnect() {
 
     discFlag = false;
     conFlag = true;
+    fullDue = true;
 }
 
 void Mqtt::onDisconnect(AsyncMqttClientDisconnectReason reason) {
@@ -138,16 +141,51 @@ void Mqtt::loop() {
 
         if ((millis() - lastStatus) > 5000) {
             lastStatus = millis();
-            String payload;
-            devstatus.lock();
-            devstatus.getJson(payload);
-            devstatus.unlock();
-            cli.publish(haDisc.defaultStateTopic.c_str(), 0, false, payload.c_str());
+            publishState();
             cli.publish(statusTopic.c_str(), 0, false, "online");
         }
     }
 }
 
+/**
+ * Full state document to <base>/state. In delta mode only the fields changed since
+ * the last publish go to <base>/delta, the full state (also carrying the volatile
+ * counters) follows every fullInterval and after a reconnect. The compact status optionally goes to <base>/cbor.
+ */
+void Mqtt::publishState() {
+    if (config.cbor) {
+        auto snap = devstatus.getCborSnapshot();
+        const String topic = baseTopic + F("/cbor");
+        cli.publish(topic.c_str(), 0, false, (const char*) snap->data.data(), snap->data.size());
+    }
+
+    if (!config.delta) {
+        auto snap = devstatus.getSnapshot();
+        cli.publish(haDisc.defaultStateTopic.c_str(), 0, false, snap->json.c_str());
+        return;
+    }
+
+    if (fullDue || (millis() - lastFull >= config.fullInterval * 1000UL)) {
+        auto snap = devstatus.getSnapshot();
+        cli.publish(haDisc.defaultStateTopic.c_str(), 0, false, snap->json.c_str());
+        lastSeq = snap->epoch; // base line for the next delta
+        lastFull = millis();
+        fullDue = false;
+    }
+    else {
+        JsonDocument delta;
+        auto snap = devstatus.getDelta(lastSeq, delta.to<JsonObject>());
+        if (snap->epoch != lastSeq) {
+            delta[F("seq")] = snap->epoch;
+            String payload;
+            serializeJson(delta, payload);
+            const String topic = baseTopic + F("/delta");
+            cli.publish(topic.c_str(), 0, false, payload.c_str());
+            lastSeq = snap->epoch;
+        }
+    }
+}
+
 OTControl::CtrlMode Mqtt::strToCtrlMode(String &str) {
     if (str.compareTo("heat") == 0)
         return OTControl::CTRLMODE_ON;
@@ -190,13 +228,13 @@ void Mqtt::onMessage(const char *topic, String &payload) {
 
     switch (etop) {
     case TOPIC_OUTSIDETEMP: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         outsideTemp.set(d, Sensor::SOURCE_MQTT);
         break;
     }
 
     case TOPIC_DHWSETTEMP: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         otcontrol.setDhwTemp(d);
         break;
     }   
@@ -209,13 +247,13 @@ void Mqtt::onMessage(const char *topic, String &payload) {
     }
 
     case TOPIC_CHSETTEMP1: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         otcontrol.setChTemp(d, 0);
         break;
     }
 
     case TOPIC_CHSETTEMP2: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         otcontrol.setChTemp(d, 1);
         break;
     }
@@ -235,28 +273,28 @@ void Mqtt::onMessage(const char *topic, String &payload) {
     }
 
     case TOPIC_ROOMTEMP1: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         roomTemp[0].set(d, Sensor::SOURCE_MQTT);
         otcontrol.forceFlowCalc(0);
         break;
     }
 
     case TOPIC_ROOMTEMP2: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         roomTemp[1].set(d, Sensor::SOURCE_MQTT);
         otcontrol.forceFlowCalc(1);
         break;
     }
 
     case TOPIC_ROOMSETPOINT1: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         roomSetPoint[0].set(d, Sensor::SOURCE_MQTT);
         otcontrol.forceFlowCalc(0);
         break;
     }
 
     case TOPIC_ROOMSETPOINT2: {
-        double d = payload.toFloat();
+        float d = payload.toFloat();
         roomSetPoint[1].set(d, Sensor::SOURCE_MQTT);
         otcontrol.forceFlowCalc(1);
         break;
@@ -293,6 +331,20 @@ void Mqtt::onMessage(const char *topic, String &payload) {
     case TOPIC_FREEVENTENABLE:
         break;
 
+    case TOPIC_TSP: {
+        // "<index>=<value>" writes a TSP, the result is published to <base>/tsp. "reload" reads all TSPs again
+        const int sep = payload.indexOf('=');
+        if (payload == F("reload"))
+            tsp.reload();
+        else if (sep > 0) {
+            const int index = payload.substring(0, sep).toInt();
+            const int value = payload.substring(sep + 1).toInt();
+            if ( (index >= 0) && (index <= 255) && (value >= 0) && (value <= 255) )
+                tsp.write(index, value);
+        }
+        break;
+    }
+
     default:
         break;
     }
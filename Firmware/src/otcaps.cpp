@@ -0,0 +1,171 @@
+#include "otcaps.h"
+#include <Preferences.h>
+
+OTCapabilities otcaps;
+static const char PREFS_NAMESPACE[] PROGMEM = "otcaps";
+static const char PREFS_KEY[] PROGMEM = "caps";
+
+OTCapabilities::OTCapabilities() {
+    clear();
+    mutex = xSemaphoreCreateMutex();
+}
+
+bool OTCapabilities::getBit(const uint8_t *map, const uint8_t id) {
+    return (map[id >> 3] & (1 << (id & 7))) != 0;
+}
+
+void OTCapabilities::setBit(uint8_t *map, const uint8_t id, const bool val) {
+    if (val)
+        map[id >> 3] |= 1 << (id & 7);
+    else
+        map[id >> 3] &= ~(1 << (id & 7));
+}
+
+void OTCapabilities::clear() {
+    memset(&data, 0, sizeof(data));
+    data.magic = MAGIC;
+}
+
+void OTCapabilities::begin() {
+    Preferences prefs;
+    if (!prefs.begin(PREFS_NAMESPACE, true))
+        return;
+
+    Data tmp;
+    if ( (prefs.getBytesLength(PREFS_KEY) == sizeof(tmp)) &&
+         (prefs.getBytes(PREFS_KEY, &tmp, sizeof(tmp)) == sizeof(tmp)) &&
+         (tmp.magic == MAGIC) )
+        data = tmp;
+    prefs.end();
+}
+
+/**
+ * Writes changes to NVS, called from the main loop.
+ */
+void OTCapabilities::loop() {
+    if (!dirty || (millis() - changed < SAVE_DELAY))
+        return;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    const Data tmp = data;
+    dirty = false;
+    xSemaphoreGive(mutex);
+
+    Preferences prefs;
+    if (prefs.begin(PREFS_NAMESPACE, false)) {
+        prefs.putBytes(PREFS_KEY, &tmp, sizeof(tmp));
+        prefs.end();
+    }
+}
+
+bool OTCapabilities::isUnsupported(const OpenThermMessageID id) const {
+    return getBit(data.unsupported, (uint8_t) id);
+}
+
+void OTCapabilities::setChanged() {
+    dirty = true;
+    changed = millis();
+}
+
+void OTCapabilities::setSupported(const uint8_t id, const bool supported) {
+    if ( (getBit(data.supported, id) == supported) && (getBit(data.unsupported, id) == !supported) )
+        return;
+
+    setBit(data.supported, id, supported);
+    setBit(data.unsupported, id, !supported);
+    setChanged();
+}
+
+/**
+ * Learns from a response of the slave.
+ * @returns true if this is another slave than the stored one, the map was cleared
+ */
+bool OTCapabilities::onResponse(const unsigned long msg) {
+    const uint8_t id = (uint8_t) OpenTherm::getDataID(msg);
+    const auto mt = OpenTherm::getMessageType(msg);
+    bool other = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    switch (mt) {
+    case OpenThermMessageType::READ_ACK:
+        switch ((OpenThermMessageID) id) {
+        case OpenThermMessageID::SConfigSMemberIDcode: {
+            const uint8_t memberId = msg & 0xFF;
+            if (data.memberIdValid && (data.memberId != memberId)) {
+                clear();
+                other = true;
+            }
+            if (!data.memberIdValid || other) {
+                data.memberIdValid = true;
+                data.memberId = memberId;
+                setChanged();
+            }
+            break;
+        }
+        case OpenThermMessageID::SlaveVersion: {
+            const uint16_t version = msg & 0xFFFF;
+            if (data.versionValid && (data.productVersion != version)) {
+                clear();
+                other = true;
+            }
+            if (!data.versionValid || other) {
+                data.versionValid = true;
+                data.productVersion = version;
+                setChanged();
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        setSupported(id, true);
+        break;
+
+    case OpenThermMessageType::WRITE_ACK:
+    case OpenThermMessageType::DATA_INVALID:
+        setSupported(id, true);
+        break;
+
+    case OpenThermMessageType::UNKNOWN_DATA_ID:
+        setSupported(id, false);
+        break;
+
+    default:
+        break;
+    }
+    xSemaphoreGive(mutex);
+    return other;
+}
+
+void OTCapabilities::getJson(JsonObject &obj) const {
+    if (data.memberIdValid)
+        obj[F("memberId")] = data.memberId;
+    if (data.versionValid)
+        obj[F("productVersion")] = String(data.productVersion, 16);
+
+    JsonArray jsup = obj[F("supported")].to<JsonArray>();
+    JsonArray junsup = obj[F("unsupported")].to<JsonArray>();
+    for (uint16_t id=0; id<256; id++) {
+        if (getBit(data.supported, id))
+            jsup.add(id);
+        if (getBit(data.unsupported, id))
+            junsup.add(id);
+    }
+}
+
+void OTCapabilities::writeJson(JsonWriter &w) const {
+    if (data.memberIdValid)
+        w.add(PSTR("memberId"), data.memberId);
+    if (data.versionValid)
+        w.add(PSTR("productVersion"), String(data.productVersion, 16));
+
+    const uint8_t *sets[] = {data.supported, data.unsupported};
+    const char *names[] = {PSTR("supported"), PSTR("unsupported")};
+    for (uint8_t s=0; s<2; s++) {
+        w.beginArray(names[s]);
+        for (uint16_t id=0; id<256; id++)
+            if (getBit(sets[s], id))
+                w.add(nullptr, id);
+        w.endArray();
+    }
+}
@@ -1,82 +1,39 @@
 #include "otcontrol.h"
 #include "otvalues.h"
-#include "command.h"
+#include "framelog.h"
+#include "otreplay.h"
+#include "slaverequest.h"
+#include "otcaps.h"
+#include "tsp.h"
 #include "HADiscLocal.h"
 #include "mqtt.h"
 #include "hwdef.h"
 #include "portal.h"
 #include "sensors.h"
+#include "otdata.h"
+#ifdef DEBUG
+#include <esp_cpu.h>
+#endif
 
 OTControl otcontrol;
 
 const int PI_INTERVAL = 60;
-
-constexpr uint16_t floatToOT(double f) {
-    return (((int) f) << 8) | (int) ((f - (int) f) * 256);
-}
-
-constexpr uint16_t nib(uint8_t hb, uint8_t lb) {
-    return (hb << 8) | lb;
-}
-
-void clip(double &d, const double min, const double max) {
+static const UBaseType_t OT_TASK_PRIO = 5; // above loop (1) and async_tcp (3), below WiFi
+static const uint32_t TASK_STATS_WINDOW = 10000; // ms
+static const uint32_t REPROBE_INTERVAL = 600000; // ms, retry of one disabled slave value
+#ifdef NODO
+static const BaseType_t OT_TASK_CORE = 1; // WiFi and lwIP run on core 0
+#else
+static const BaseType_t OT_TASK_CORE = tskNO_AFFINITY;
+#endif
+
+void clip(float &d, const float min, const float max) {
     if (d < min)
         d = min;
     if (d > max)
         d = max;
 }
 
-// Testdata for local OT slave, can be read by a connected master
-const struct {
-    OpenThermMessageID id;
-    uint16_t value;
-} loopbackTestData[] PROGMEM = {
-    {OpenThermMessageID::Status,                    0x000E},
-    {OpenThermMessageID::SConfigSMemberIDcode,      0x2501}, // DHW present, cooling present, CH2 present
-    {OpenThermMessageID::ASFflags,                  0x0000}, // no error flags, oem error code 0
-    {OpenThermMessageID::RBPflags,                  0x0101},
-    {OpenThermMessageID::TrOverride,                0},
-    {OpenThermMessageID::MaxCapacityMinModLevel,    nib(20, 5)}, // 20 kW / 5 %
-    {OpenThermMessageID::RelModLevel,               floatToOT(33.3)},
-    {OpenThermMessageID::CHPressure,                floatToOT(1.25)},
-    {OpenThermMessageID::DHWFlowRate,               floatToOT(2.4)},
-    {OpenThermMessageID::Tboiler,                   floatToOT(48.5)},
-    {OpenThermMessageID::Tdhw,                      floatToOT(37.5)},
-    {OpenThermMessageID::Toutside,                  floatToOT(3.5)},
-    {OpenThermMessageID::Tret,                      floatToOT(41.7)},
-    {OpenThermMessageID::TflowCH2,                  floatToOT(48.6)},
-    {OpenThermMessageID::Tdhw2,                     floatToOT(37.6)},
-    {OpenThermMessageID::Texhaust,                  90},
-    {OpenThermMessageID::TrOverride2,               0},
-    {OpenThermMessageID::TdhwSetUBTdhwSetLB,        nib(60, 40)}, // 60 °C upper bound, 40 C° lower bound
-    {OpenThermMessageID::MaxTSetUBMaxTSetLB,        nib(60, 25)}, // 60 °C upper bound, 20 C° lower bound
-    {OpenThermMessageID::SuccessfulBurnerStarts,    9999},
-    {OpenThermMessageID::CHPumpStarts,              7777},
-    {OpenThermMessageID::BurnerOperationHours,      8888},
-    {OpenThermMessageID::OpenThermVersionSlave,     nib(2, 2)},
-    {OpenThermMessageID::SlaveVersion,              nib(4, 4)},
-    {OpenThermMessageID::StatusVentilationHeatRecovery, 0x001E},
-    {OpenThermMessageID::RelVentLevel,              55}, // relative ventilation 0..100 %
-    {OpenThermMessageID::RHexhaust,                 45},
-    {OpenThermMessageID::CO2exhaust,                1450}, // PPM
-    {OpenThermMessageID::Tsi,                       floatToOT(22.1)},
-    {OpenThermMessageID::Tso,                       floatToOT(22.2)},
-    {OpenThermMessageID::Tei,                       floatToOT(22.3)},
-    {OpenThermMessageID::Teo,                       floatToOT(22.1)},
-    {OpenThermMessageID::RPMexhaust,                2300},
-    {OpenThermMessageID::RPMsupply,                 2400},
-    {OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery,   0x0F33},
-    {OpenThermMessageID::OpenThermVersionVentilationHeatRecovery,       0x0105},
-    {OpenThermMessageID::VentilationHeatRecoveryVersion,                0x0107},
-    {OpenThermMessageID::RemoteOverrideFunction,    0x0000},
-    {OpenThermMessageID::UnsuccessfulBurnerStarts,  19},
-    {OpenThermMessageID::FlameSignalTooLowNumber,   4},
-    {OpenThermMessageID::OEMDiagnosticCode,         123},
-    {OpenThermMessageID::DHWBurnerOperationHours,   196},
-    {OpenThermMessageID::TboilerHeatExchanger,      floatToOT(48.5)},
-    {OpenThermMessageID::BoilerFanSpeedSetpointAndActual, nib(20, 21)},
-    {OpenThermMessageID::FlameCurrent,              floatToOT(96.8)},
-};
 
 void IRAM_ATTR handleIrqMaster() {
     otcontrol.masterPinIrq();
@@ -103,10 +60,15 @@ OTControl::OTInterface::OTInterface(const uint8_t inPin, const uint8_t outPin, c
 }
 
 void OTControl::OTInterface::sendRequest(const char source, const unsigned long msg) {
-    hal.sendRequestAsync(msg);
+    if (divert) {
+        divertedMsg = msg;
+        diverted = true;
+    }
+    else
+        hal.sendRequestAsync(msg);
     
     if (source)
-        command.sendOtEvent(source, msg);
+        framelog.push(source, msg, OpenThermResponseStatus::NONE);
     
     txCount++;
     lastTx = millis();
@@ -118,47 +80,110 @@ void OTControl::OTInterface::resetCounters() {
     rxCount = 0;
     timeoutCount = 0;
     invalidCount = 0;
+    numLate = 0;
+    numDropped = 0;
+    if (latency)
+        latency->reset();
 }
 
-void OTControl::OTInterface::onReceive(const char source, const unsigned long msg) {
+void OTControl::OTInterface::onReceive(const char source, const unsigned long msg, const OpenThermResponseStatus status) {
     if (source)
-        command.sendOtEvent(source, msg);
+        framelog.push(source, msg, status);
     rxCount++;
     lastRx = millis();
 }
 
+/**
+ * Sends the response if the line is free, otherwise it is staged and sent by processResponse().
+ */
 void OTControl::OTInterface::sendResponse(const unsigned long msg, const char source) {
-    uint32_t temp = millis();
+    if (divert) {
+        divertedMsg = msg;
+        diverted = true;
+    }
+    if (divert || hal.sendResponse(msg)) {
+        onResponseSent(source, msg);
+        return;
+    }
 
-    while (true) {
-        if (hal.sendResponse(msg)) {
-            if (source)
-                command.sendOtEvent(source, msg);
-        
-            txCount++;
-            lastTx = millis();
-            lastTxMsg = msg;
-            break;
+    if (respPending)
+        numDropped++; // superseded
+    pendingResp = msg;
+    pendingSource = source;
+    respPending = true;
+}
+
+void OTControl::OTInterface::processResponse() {
+    if (!respPending)
+        return;
+
+    if (hal.sendResponse(pendingResp)) {
+        respPending = false;
+        if (millis() - lastRx > 800)
+            numLate++;
+        onResponseSent(pendingSource, pendingResp);
+    }
+    else
+        if (millis() - lastRx > 800) {
+            // the master has given up waiting
+            respPending = false;
+            reqMicros = 0;
+            numDropped++;
         }
-        if (millis() - temp > 300)
-            break;
+}
 
-        hal.process();
-        yield();
+void OTControl::OTInterface::onResponseSent(const char source, const unsigned long msg) {
+    if (source)
+        framelog.push(source, msg, OpenThermResponseStatus::NONE);
+
+    txCount++;
+    lastTx = millis();
+    lastTxMsg = msg;
+
+    if (reqMicros) {
+        if (latency)
+            latency->add((micros() - reqMicros) / 1000);
+        reqMicros = 0;
     }
 }
 
 
+void LatencyHistogram::add(const uint32_t ms) {
+    count[min(ms / BUCKET, (uint32_t) NUM - 1)]++;
+    total++;
+}
+
+/**
+ * @returns upper bound in ms of the bucket holding the p-th percentile
+ */
+uint32_t LatencyHistogram::percentile(const uint8_t p) const {
+    const uint32_t rank = ((uint64_t) total * p + 99) / 100;
+    uint32_t sum = 0;
+    for (uint16_t i=0; i<NUM; i++) {
+        sum += count[i];
+        if ((sum >= rank) && (sum > 0))
+            return (i + 1) * BUCKET;
+    }
+    return 0;
+}
+
+void LatencyHistogram::reset() {
+    memset(count, 0, sizeof(count));
+    total = 0;
+}
+
+
 OTControl::OTControl():
-        lastBoilerStatus(0),
-        lastVentStatus(0),
         otMode(OTMODE_LOOPBACKTEST),
-        master(GPIO_OTMASTER_IN, GPIO_OTMASTER_OUT, false),
-        slave(GPIO_OTSLAVE_IN, GPIO_OTSLAVE_OUT, true),
+        slaveApp(SLAVEAPP_HEATCOOL),
         setBoilerRequest{OTWRSetBoilerTemp(0), OTWRSetBoilerTemp(1)},
         setRoomTemp{OTWRSetRoomTemp(0), OTWRSetRoomTemp(1)},
         setRoomSetPoint{OTWRSetRoomSetPoint(0), OTWRSetRoomSetPoint(1)},
-        slaveApp(SLAVEAPP_HEATCOOL) {
+        boilerStatusRequest(OpenThermMessageID::Status),
+        ventStatusRequest(OpenThermMessageID::StatusVentilationHeatRecovery),
+        master(GPIO_OTMASTER_IN, GPIO_OTMASTER_OUT, false),
+        slave(GPIO_OTSLAVE_IN, GPIO_OTSLAVE_OUT, true) {
+    slave.latency = &repeaterLatency;
 }
 
 void OTControl::begin() {
@@ -173,7 +198,343 @@ void OTControl::begin() {
     master.hal.begin(handleIrqMaster, otCbMaster);
     slave.hal.begin(handleIrqSlave, otCbSlave);
 
+    initScheduler();
+    initRules();
     setOTMode(otMode);
+
+    cmdQueue = xQueueCreate(16, sizeof(Command));
+    xTaskCreatePinnedToCore(taskFunc, "ot", 8192, this, OT_TASK_PRIO, &task, OT_TASK_CORE);
+}
+
+void OTControl::taskFunc(void *arg) {
+    OTControl *ctrl = (OTControl*) arg;
+
+    while (true) {
+        Command cmd;
+        bool received = false;
+        // wait for a command or at most one tick, a pending config keeps the following commands queued
+        if (ctrl->configPending)
+            vTaskDelay(1);
+        else
+            received = (xQueueReceive(ctrl->cmdQueue, &cmd, 1) == pdTRUE);
+
+        std::lock_guard<std::recursive_mutex> guard(ctrl->stateMutex);
+        if (ctrl->configPending)
+            ctrl->exec(ctrl->pendingConfig);
+        if (received)
+            ctrl->exec(cmd);
+
+        auto &st = ctrl->taskStats;
+        const uint32_t now = micros();
+        if (st.numLoops > 0) {
+            const uint32_t gap = now - st.lastLoop;
+            st.gapMax[0] = max(st.gapMax[0], gap);
+            st.gapAvg += (gap - st.gapAvg) * 0.01f;
+        }
+        else
+            st.gapAvg = 1000;
+        st.lastLoop = now;
+        st.numLoops++;
+
+        if (millis() - st.windowStart >= TASK_STATS_WINDOW) {
+            st.windowStart = millis();
+            st.gapMax[1] = st.gapMax[0];
+            st.gapMax[0] = 0;
+        }
+
+        ctrl->loop();
+    }
+}
+
+/**
+ * Passes a command to the OT task.
+ * @param wait block until the command is executed
+ */
+void OTControl::post(Command cmd, const bool wait) {
+    if (xTaskGetCurrentTaskHandle() == task) {
+        exec(cmd);
+        return;
+    }
+
+    StaticSemaphore_t doneBuf;
+    cmd.done = wait ? xSemaphoreCreateBinaryStatic(&doneBuf) : nullptr;
+
+    if (xQueueSend(cmdQueue, &cmd, wait ? portMAX_DELAY : pdMS_TO_TICKS(100)) != pdTRUE)
+        return; // OT task is stuck, drop the command
+
+    if (wait) {
+        xSemaphoreTake(cmd.done, portMAX_DELAY);
+        vSemaphoreDelete(cmd.done);
+    }
+}
+
+void OTControl::exec(const Command &cmd) {
+    const uint8_t ch = cmd.channel;
+
+    switch (cmd.type) {
+    case Command::CMD_DHW_TEMP:
+        boilerCtrl.dhwTemp = cmd.value;
+        setDhwRequest.force();
+        break;
+
+    case Command::CMD_DHW_MODE:
+        boilerCtrl.dhwOn = ((CtrlMode) cmd.value != CtrlMode::CTRLMODE_OFF);
+        setDhwRequest.force();
+        break;
+
+    case Command::CMD_CH_TEMP:
+        if (cmd.value == 0)
+            heatingCtrl[ch].mode = CTRLMODE_AUTO;
+        else
+            heatingCtrl[ch].flowTemp = cmd.value;
+        setBoilerRequest[ch].force();
+        break;
+
+    case Command::CMD_CH_MODE: {
+        const CtrlMode mode = (CtrlMode) cmd.value;
+        heatingCtrl[ch].mode = mode;
+        switch (mode) {
+        case CTRLMODE_AUTO:
+            heatingCtrl[ch].chOn = heatingConfig[ch].chOn;
+            break;
+        case CTRLMODE_OFF:
+            heatingCtrl[ch].chOn = false;
+            break;
+        case CTRLMODE_ON:
+            heatingCtrl[ch].chOn = true;
+        }
+        setBoilerRequest[ch].force();
+        break;
+    }
+
+    case Command::CMD_OVERRIDE_CH:
+        heatingCtrl[ch].overrideFlow = (cmd.value != 0);
+        setBoilerRequest[ch].force();
+        break;
+
+    case Command::CMD_OVERRIDE_DHW:
+        boilerCtrl.overrideDhw = (cmd.value != 0);
+        setDhwRequest.force();
+        break;
+
+    case Command::CMD_FORCE_FLOW:
+        setBoilerRequest[ch].force();
+        break;
+
+    case Command::CMD_VENT_SETPOINT:
+        ventCtrl.setpoint = cmd.value;
+        setVentSetpointRequest.force();
+        break;
+
+    case Command::CMD_VENT_ENABLE:
+        ventCtrl.ventEnable = (cmd.value != 0);
+        break;
+
+    case Command::CMD_CONFIG:
+        if ( cmd.done && (!master.hal.isReady() || !slave.hal.isReady()) ) {
+            // frame on the line: retried by taskFunc() after each loop(), the caller keeps waiting
+            pendingConfig = cmd;
+            configPending = true;
+            return;
+        }
+        configPending = false;
+        applyConfig(*(JsonObject*) cmd.data);
+        break;
+    }
+
+    if (cmd.done)
+        xSemaphoreGive(cmd.done);
+}
+
+void OTControl::addWriteRequest(OTWriteRequest &req) {
+    if (numWriteRequests < sizeof(writeRequests) / sizeof(writeRequests[0]))
+        writeRequests[numWriteRequests++] = &req;
+    scheduler.add(&req);
+}
+
+void OTControl::initRules() {
+    rules.setFunctions(
+        [this](const OTRules::RuleCond cond) {
+            float t;
+            switch (cond) {
+            case OTRules::COND_OVERRIDE_CH1:
+                return heatingCtrl[0].overrideFlow;
+            case OTRules::COND_OVERRIDE_CH2:
+                return heatingCtrl[1].overrideFlow;
+            case OTRules::COND_OVERRIDE_DHW:
+                return boilerCtrl.overrideDhw;
+            case OTRules::COND_OUTSIDE_LOCAL:
+                return !outsideTemp.isOtSource() && outsideTemp.get(t);
+            default:
+                return true;
+            }
+        },
+        [this](const OTRules::RuleSource src, const uint16_t data, uint16_t &value) {
+            float t;
+            switch (src) {
+            case OTRules::SRC_FLOW1:
+                value = OpenTherm::temperatureToData(getFlow(0));
+                return true;
+            case OTRules::SRC_FLOW2:
+                value = OpenTherm::temperatureToData(getFlow(1));
+                return true;
+            case OTRules::SRC_DHW_SET:
+                value = OpenTherm::temperatureToData(boilerCtrl.dhwTemp);
+                return true;
+            case OTRules::SRC_OUTSIDE:
+                if (!outsideTemp.get(t))
+                    return false;
+                value = floatToF88(t);
+                return true;
+            case OTRules::SRC_STATUS:
+                value = data;
+                if (heatingCtrl[0].overrideFlow) {
+                    if (heatingCtrl[0].mode == CtrlMode::CTRLMODE_OFF)
+                        value &= ~(1<<8); // CH1 disable
+                    else
+                        value |= 1<<8; // CH1 enable
+                }
+                if (heatingCtrl[1].overrideFlow) {
+                    if (heatingCtrl[1].mode == CtrlMode::CTRLMODE_OFF)
+                        value &= ~(1<<12); // CH2 disable
+                    else
+                        value |= 1<<12; // CH2 enable
+                }
+                if (boilerCtrl.overrideDhw) {
+                    if (boilerCtrl.dhwOn)
+                        value |= 1<<9; // DHW enable
+                    else
+                        value &= ~(1<<9); // DHW disable
+                }
+                return true;
+            default:
+                return false;
+            }
+        });
+}
+
+void OTControl::initScheduler() {
+    for (auto *valobj: slaveValues)
+        scheduler.add(valobj);
+
+    for (auto &fh: faultHistory)
+        scheduler.add(&fh);
+    scheduler.add(&tsp);
+
+    for (auto *valobj: slaveValues)
+        if (valobj->isCacheable())
+            cacheScheduler.add(valobj);
+
+    boilerStatusRequest.setSource([this](uint16_t &data) {
+        if ( (slaveApp != SLAVEAPP_HEATCOOL) && (otMode != OTMODE_LOOPBACKTEST) )
+            return false;
+
+        unsigned long req = OpenTherm::buildSetBoilerStatusRequest(
+            heatingCtrl[0].chOn && !(heatingConfig[0].enableHyst && heatingCtrl[0].suspended), 
+            boilerCtrl.dhwOn,
+            boilerConfig.coolOn,
+            boilerConfig.otc, 
+            heatingCtrl[1].chOn && !(heatingConfig[1].enableHyst && heatingCtrl[1].suspended),
+            boilerConfig.summerMode,
+            boilerConfig.dhwBlocking);
+        data = (req | statusReqOvl) & 0xFFFF;
+        return true;
+    });
+    scheduler.add(&boilerStatusRequest);
+
+    ventStatusRequest.setSource([this](uint16_t &data) {
+        if ( (slaveApp != SLAVEAPP_VENT) && (otMode != OTMODE_LOOPBACKTEST) )
+            return false;
+
+        uint8_t hb = 0;
+        if (ventCtrl.ventEnable)
+            hb |= 1<<0;
+        if (ventCtrl.openBypass)
+            hb |= 1<<1;
+        if (ventCtrl.autoBypass)
+            hb |= 1<<2;
+        if (ventCtrl.freeVentEnable)
+            hb |= 1<<3;
+        data = hb << 8;
+        return true;
+    });
+    scheduler.add(&ventStatusRequest);
+
+    scheduler.add(&slaveRequests);
+
+    for (int ch=0; ch<2; ch++) {
+        setBoilerRequest[ch].setSource([this, ch](uint16_t &data) {
+            if ( (slaveApp != SLAVEAPP_HEATCOOL) && (otMode != OTMODE_LOOPBACKTEST) )
+                return false;
+            if (!heatingCtrl[ch].chOn)
+                return false;
+
+            float flow = getFlow(ch);
+            if (flow <= 0)
+                return false;
+
+            data = floatToF88(flow);
+            return true;
+        });
+        addWriteRequest(setBoilerRequest[ch]);
+
+        setRoomTemp[ch].setSource([this, ch](uint16_t &data) {
+            float temp = 20.1f;
+            if ( (otMode != OTMODE_LOOPBACKTEST) && !roomTemp[ch].get(temp) )
+                return false;
+
+            data = floatToF88(temp);
+            return true;
+        });
+        addWriteRequest(setRoomTemp[ch]);
+
+        setRoomSetPoint[ch].setSource([this, ch](uint16_t &data) {
+            float temp = 21.3f;
+            if ( (otMode != OTMODE_LOOPBACKTEST) && !roomSetPoint[ch].get(temp) )
+                return false;
+
+            data = floatToF88(temp);
+            return true;
+        });
+        addWriteRequest(setRoomSetPoint[ch]);
+    }
+
+    setDhwRequest.setSource([this](uint16_t &data) {
+        if ( (slaveApp != SLAVEAPP_HEATCOOL) && (otMode != OTMODE_LOOPBACKTEST) )
+            return false;
+
+        data = floatToF88(boilerCtrl.dhwTemp);
+        return true;
+    });
+    addWriteRequest(setDhwRequest);
+
+    setOutsideTemp.setSource([this](uint16_t &data) {
+        if ( (slaveApp != SLAVEAPP_HEATCOOL) && (otMode != OTMODE_LOOPBACKTEST) )
+            return false;
+
+        float t;
+        if (outsideTemp.isOtSource() || !outsideTemp.get(t))
+            return false;
+
+        data = floatToF88(t);
+        return true;
+    });
+    addWriteRequest(setOutsideTemp);
+
+    setVentSetpointRequest.setSource([this](uint16_t &data) {
+        if ( (slaveApp != SLAVEAPP_VENT) && (otMode != OTMODE_LOOPBACKTEST) )
+            return false;
+
+        data = ventCtrl.setpoint;
+        return true;
+    });
+    addWriteRequest(setVentSetpointRequest);
+
+    setMasterConfigMember.setSource([this](uint16_t &data) {
+        data = (1<<8) | masterMemberId;
+        return true;
+    });
+    addWriteRequest(setMasterConfigMember);
 }
 
 void OTControl::masterPinIrq() {
@@ -193,15 +554,6 @@ void OTControl::slavePinIrq() {
     slave.hal.handleInterrupt();
 }
 
-uint16_t OTControl::tmpToData(const double tmpf) {
-    if (tmpf > 100)
-        return 100<<8;
-    if (tmpf < -100)
-        return - (int) (100<<8);
-    
-    return (int16_t) (tmpf * 256);
-}
-
 void OTControl::setOTMode(const OTMode mode, const bool enableSlave) {
     otMode = mode;
 
@@ -212,19 +564,27 @@ void OTControl::setOTMode(const OTMode mode, const bool enableSlave) {
     slaveEnabled = (mode == OTMODE_REPEATER) || (mode == OTMODE_LOOPBACKTEST) || enableSlave;
     digitalWrite(GPIO_STEPUP_ENABLE, slaveEnabled);
 
+    // IDs the slave didn't support last time are not polled, see reprobe(). The
+    // capability map is of the real slave, not of the simulated boiler in loopback mode.
+    const bool ownRequests = (mode == OTMODE_MASTER) || (mode == OTMODE_LOOPBACKTEST);
     for (auto *valobj: slaveValues)
-        valobj->init((mode == OTMODE_MASTER) || (mode == OTMODE_LOOPBACKTEST));
+        valobj->init(ownRequests && ((mode == OTMODE_LOOPBACKTEST) || !otcaps.isUnsupported(valobj->getId())));
+    nextReprobe = millis() + REPROBE_INTERVAL;
 
     for (auto *valobj: thermostatValues)
         valobj->init(false);
 
+    for (uint8_t i=0; i<3; i++)
+        faultHistory[i].init(ownRequests && (slaveApp == i));
+    tsp.init(ownRequests, slaveApp);
+
     master.hal.setAlwaysReceive(mode == OTMODE_REPEATER);
     discFlag = false;
 }
 
-double OTControl::getFlow(const uint8_t channel) {
+float OTControl::getFlow(const uint8_t channel) {
     HeatingConfig &hc = heatingConfig[channel];
-    double flow = hc.flow;
+    float flow = hc.flow;
 
     switch (heatingCtrl[channel].mode) {
     case CTRLMODE_ON:
@@ -232,14 +592,15 @@ double OTControl::getFlow(const uint8_t channel) {
         break;
 
     case CTRLMODE_AUTO: {
-        double outTmp;
+        float outTmp;
         if (outsideTemp.get(outTmp)) {
-            double roomSet = hc.roomSet; // default room set point
+            float roomSet = hc.roomSet; // default room set point
             roomSetPoint[channel].get(roomSet);
 
-            double minOutside = roomSet - (hc.flowMax - roomSet) / hc.gradient;
-            double c1 = (hc.flowMax - roomSet) / pow(roomSet - minOutside, 1.0 / hc.exponent);
-            flow = roomSet + c1 * pow(roomSet - outTmp, 1.0 / hc.exponent) + hc.offset;
+            HeatingCurve &curve = heatingCurve[channel];
+            if (!curve.valid || (curve.roomSet != roomSet))
+                curve.build(hc.flowMax, hc.exponent, hc.gradient, hc.offset, roomSet);
+            flow = curve.get(outTmp);
         }
         break;
     }
@@ -258,21 +619,28 @@ double OTControl::getFlow(const uint8_t channel) {
 void OTControl::loop() {
     master.hal.process();
     slave.hal.process();
+    slave.processResponse();
+
+    if (simReplyPending && ((int32_t) (millis() - simReplyDue) >= 0)) {
+        simReplyPending = false;
+        slave.sendResponse(simReply, 'P');
+    }
 
     if (millis() > nextPiCtrl) {
-        loopPiCtrl();
+        loopPiCtrl(heatingCtrl);
         nextPiCtrl = millis() + PI_INTERVAL * 1000;
     }
 
-    if (!discFlag)
-        discFlag = sendDiscovery();
-
     if (otMode == OTMODE_MASTER) {
         // in OTMASTER mode use OT LEDs as master TX & RX
         if (millis() > master.lastTx + 50)
             setLedOTRed(false);
     }
 
+    otreplay.loop();
+    if (otreplay.isRunning())
+        return;
+
     if (!master.hal.isReady()) {
         return;
     }
@@ -280,132 +648,142 @@ void OTControl::loop() {
     if (xSemaphoreTake(master.mutex, (TickType_t) 50 / portTICK_PERIOD_MS) != pdTRUE)
         return;
 
+    unsigned long req;
     switch (otMode) {
-    case OTMODE_LOOPBACKTEST: {
-        for (int ch=0; ch<2; ch++) {
-            if (setRoomTemp[ch]) {
-                setRoomTemp[ch].sendTemp(20.1);
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-            if (setRoomSetPoint[ch]) {
-                setRoomSetPoint[ch].sendTemp(21.3);
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-        }
-        // no break!!
-    }
-
     case OTMODE_MASTER:
-        for (auto *valobj: slaveValues) {
-            if (valobj->process()) {
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-        }
+    case OTMODE_LOOPBACKTEST:
+        reprobe();
+        if (scheduler.next(req))
+            sendRequest('T', req);
+        break;
 
-        for (int ch=0; ch<2; ch++) {
-            double temp;
-            if (setRoomTemp[ch] && roomTemp[ch].get(temp)) {
-                setRoomTemp[ch].sendTemp(temp);
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-            if (setRoomSetPoint[ch] && roomSetPoint[ch].get(temp)) {
-                setRoomSetPoint[ch].sendTemp(temp);
-                xSemaphoreGive(master.mutex);
-                return;
+    case OTMODE_REPEATER: {
+        const uint32_t now = millis();
+        if (fwdPending) {
+            fwdPending = false;
+            if (now - slave.lastRx < 800)
+                master.sendRequest(pendingFwdSource, pendingFwd);
+            else {
+                // the room unit has given up waiting
+                slave.reqMicros = 0;
+                slave.numDropped++;
             }
+            break;
         }
-
-        if ( (slaveApp == SLAVEAPP_HEATCOOL) || (otMode == OTMODE_LOOPBACKTEST) ) {
-            for (int ch=0; ch<2; ch++) {
-                if (heatingCtrl[ch].chOn && setBoilerRequest[ch]) {
-                    double flow = getFlow(ch);
-                    if (flow > 0) {
-                        setBoilerRequest[ch].sendTemp(flow);
-                        xSemaphoreGive(master.mutex);
-                        return;
-                    }
-                }
-            }
-
-            if (setDhwRequest) {
-                setDhwRequest.sendTemp(boilerCtrl.dhwTemp);
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-
-            if (!outsideTemp.isOtSource() && setOutsideTemp) {
-                double t;
-                if (outsideTemp.get(t)) {
-                    setOutsideTemp.sendTemp(t);
-                    xSemaphoreGive(master.mutex);
-                    return;
-                }
-            }
-
-            if (millis() > lastBoilerStatus + 800) {
-                lastBoilerStatus = millis();
-
-                unsigned long req = OpenTherm::buildSetBoilerStatusRequest(
-                    heatingCtrl[0].chOn && !(heatingConfig[0].enableHyst && heatingCtrl[0].suspended), 
-                    boilerCtrl.dhwOn,
-                    boilerConfig.coolOn,
-                    boilerConfig.otc, 
-                    heatingCtrl[1].chOn && !(heatingConfig[1].enableHyst && heatingCtrl[1].suspended),
-                    boilerConfig.summerMode,
-                    boilerConfig.dhwBlocking);
-                req |= statusReqOvl;
+        // own requests (diagnostics, cache refresh) right after a response to the room unit,
+        // at most one per cycle of the room unit, or if it is silent
+        const bool gap = !slave.respPending && (now - slave.lastTx < 200) && ((int32_t) (master.lastTx - slave.lastTx) < 0);
+        if ( gap || (now - slave.lastRx > 2000) ) {
+            if (slaveRequests.take(now, req))
                 sendRequest('T', req);
-                xSemaphoreGive(master.mutex);
-                return;
-            }  
-        }
-
-        if ( (slaveApp == SLAVEAPP_VENT) || (otMode == OTMODE_LOOPBACKTEST) ) {
-            if (setVentSetpointRequest) {
-                setVentSetpointRequest.send(ventCtrl.setpoint);
-                xSemaphoreGive(master.mutex);
-                return;
-            }
-
-            if (millis() > lastVentStatus + 800) {
-                lastVentStatus = millis();
-                uint8_t hb = 0;
-                if (ventCtrl.ventEnable)
-                    hb |= 1<<0;
-                if (ventCtrl.openBypass)
-                    hb |= 1<<1;
-                if (ventCtrl.autoBypass)
-                    hb |= 1<<2;
-                if (ventCtrl.freeVentEnable)
-                    hb |= 1<<3;
-                unsigned long req = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::StatusVentilationHeatRecovery, hb << 8);
+            else if (repeaterCache.enable && cacheScheduler.next(req)) {
+                repeaterCache.refreshPending = true;
+                repeaterCache.refreshes++;
                 sendRequest('T', req);
-                xSemaphoreGive(master.mutex);
-                return;
+                cacheScheduler.onTx();
             }
         }
+        break;
+    }
 
-        if (setMasterConfigMember) {
-            setMasterConfigMember.send((1<<8) | masterMemberId);
-            xSemaphoreGive(master.mutex);
-            return;
-        }
+    default:
+        slaveRequests.cancelAll();
+        fwdPending = false;
         break;
     }
     xSemaphoreGive(master.mutex);
 }
 
-void OTControl::loopPiCtrl() {
+/**
+ * Enables one disabled slave value every REPROBE_INTERVAL, round robin. The slave
+ * may support an ID after a firmware update or the capability map is outdated.
+ */
+void OTControl::reprobe() {
+    const uint32_t now = millis();
+    if ((int32_t) (now - nextReprobe) < 0)
+        return;
+    nextReprobe = now + REPROBE_INTERVAL;
+
+    for (size_t n=0; n<slaveValues.num; n++) {
+        OTValue *valobj = slaveValues.first[reprobeIndex];
+        reprobeIndex = (reprobeIndex + 1) % slaveValues.num;
+        if (!valobj->isEnabled()) {
+            valobj->init(true);
+            break;
+        }
+    }
+}
+
+/**
+ * Heating curves as used by getFlow(), stale tables are rebuilt in a copy only
+ * as the cache belongs to the OT loop.
+ */
+void OTControl::getCurveJson(JsonArray &arr) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
+    for (uint8_t ch=0; ch<2; ch++) {
+        const HeatingConfig &hc = heatingConfig[ch];
+        float roomSet = hc.roomSet;
+        roomSetPoint[ch].get(roomSet);
+
+        HeatingCurve curve = heatingCurve[ch];
+        if (!curve.valid || (curve.roomSet != roomSet))
+            curve.build(hc.flowMax, hc.exponent, hc.gradient, hc.offset, roomSet);
+
+        JsonObject jc = arr.add<JsonObject>();
+        jc[F("roomSet")] = roomSet;
+        jc[F("flowMax")] = hc.flowMax;
+        jc[F("tMin")] = HeatingCurve::T_MIN;
+        jc[F("step")] = 1;
+        JsonArray jflow = jc[F("flow")].to<JsonArray>();
+        for (uint8_t i=0; i<HeatingCurve::POINTS; i++)
+            jflow.add(roundf(curve.flow[i] * 10) / 10);
+    }
+}
+
+#ifdef DEBUG
+/**
+ * CPU cycles per call of the control math, results depend on the sensor values available.
+ * The PI controllers run on a copy, the state of the OT task isn't touched.
+ */
+void OTControl::benchmark(JsonObject &obj) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
+    const int N = 100;
+    HeatingControl ctrl[2] = {heatingCtrl[0], heatingCtrl[1]};
+    volatile float flow;
+
+    uint32_t t = esp_cpu_get_cycle_count();
+    for (int i=0; i<N; i++)
+        flow = getFlow(i & 1);
+    obj[F("getFlow")] = (esp_cpu_get_cycle_count() - t) / N;
+
+    t = esp_cpu_get_cycle_count();
+    for (int i=0; i<N; i++)
+        loopPiCtrl(ctrl);
+    obj[F("loopPiCtrl")] = (esp_cpu_get_cycle_count() - t) / N;
+}
+#endif
+
+/**
+ * Called from the main loop, the OT task doesn't publish to MQTT.
+ */
+void OTControl::loopDiscovery() {
+    if (!discFlag)
+        discFlag = sendDiscovery();
+
+    for (auto &fh: faultHistory)
+        fh.loopDiscovery();
+}
+
+/**
+ * @param ctrl PI controllers of both channels, heatingCtrl except for benchmark()
+ */
+void OTControl::loopPiCtrl(HeatingControl (&ctrl)[2]) {
     for (int i=0; i<2; i++) {
-        HeatingControl::PiCtrl &pictrl = heatingCtrl[i].piCtrl;
-        double rt, rsp;
+        HeatingControl::PiCtrl &pictrl = ctrl[i].piCtrl;
+        float rt, rsp;
 
         if (!heatingConfig[i].enableHyst)
-            heatingCtrl[i].suspended = false;
+            ctrl[i].suspended = false;
 
         pictrl.deltaT = 0;
 
@@ -413,7 +791,7 @@ void OTControl::loopPiCtrl() {
             continue;
 
         if (pictrl.init)
-            pictrl.roomTempFilt = 0.1 * rt + 0.9 * pictrl.roomTempFilt;
+            pictrl.roomTempFilt = 0.1f * rt + 0.9f * pictrl.roomTempFilt;
         else
             pictrl.roomTempFilt = rt;
 
@@ -423,29 +801,29 @@ void OTControl::loopPiCtrl() {
             continue;
 
         if (heatingConfig[i].enableHyst) {
-            if (heatingCtrl[i].suspended) {
+            if (ctrl[i].suspended) {
                 if (rt < rsp - heatingConfig[i].hysteresis)
-                    heatingCtrl[i].suspended = false;
+                    ctrl[i].suspended = false;
             }
             else {
                 if (rt > rsp + heatingConfig[i].hysteresis)
-                    heatingCtrl[i].suspended = true;
+                    ctrl[i].suspended = true;
             }
         }
 
-        double e = rsp - rt; // error
-        if ((e > -0.2) && (e < 0.2)) // deadband
+        float e = rsp - rt; // error
+        if ((e > -0.2f) && (e < 0.2f)) // deadband
             e = 0;
 
         // proportional part of PI controller
-        double p = heatingConfig[i].roomTempComp * e; // Kp * e
+        float p = heatingConfig[i].roomTempComp * e; // Kp * e
         
         // integral part of PI controller
         OTValueStatus *ots = static_cast<OTValueStatus*>(OTValue::getSlaveValue(OpenThermMessageID::Status));
         if ( (ots != nullptr) && (ots->getMode(i)) )
-            pictrl.integState += heatingConfig[i].roomTempCompI * e * PI_INTERVAL / 3600.0; // Ki * e * ts, ts = 60 s
+            pictrl.integState += heatingConfig[i].roomTempCompI * e * PI_INTERVAL / 3600.0f; // Ki * e * ts, ts = 60 s
         else
-            pictrl.integState = pictrl.integState * 0.95; // decay
+            pictrl.integState = pictrl.integState * 0.95f; // decay
 
         // anti windup
         clip(pictrl.integState, -5, 5);
@@ -458,6 +836,7 @@ void OTControl::loopPiCtrl() {
 
 void OTControl::sendRequest(const char source, const unsigned long msg) {
     master.sendRequest(source, msg);
+    scheduler.onTx();
     if (otMode == OTMODE_MASTER) {
         setThermostatVal(msg);
         setLedOTRed(true); // when we're OTMASTER use red LED as TX LED
@@ -465,14 +844,21 @@ void OTControl::sendRequest(const char source, const unsigned long msg) {
 }
 
 void OTControl::OnRxMaster(const unsigned long msg, const OpenThermResponseStatus status) {
+    scheduler.onRx();
+    cacheScheduler.onRx();
+    // response to /slaverequest, not to be forwarded to the room unit
+    const bool diagResponse = slaveRequests.onResponse(msg, status);
+
     switch (status) {
     case OpenThermResponseStatus::TIMEOUT:
         master.timeoutCount++;
+        framelog.push('X', master.lastTxMsg, status);
+        repeaterCache.refreshPending = false;
         return;
 
     case OpenThermResponseStatus::INVALID:
         if (otMode != OTMODE_REPEATER) {
-            master.onReceive('E', msg);
+            master.onReceive('E', msg, OpenThermResponseStatus::INVALID);
             return;
         }
         break;
@@ -490,42 +876,46 @@ void OTControl::OnRxMaster(const unsigned long msg, const OpenThermResponseStatu
     auto *otval = OTValue::getSlaveValue(id);
 
     unsigned long newMsg = msg;
+    master.onReceive('B', msg);
 
     switch (otMode) {
     case OTMODE_LOOPBACKTEST:
         break;
 
     case OTMODE_REPEATER:
-        // forward reply from boiler to room unit
-        // READ replies can be modified here
-        switch (id) {
-        case OpenThermMessageID::Toutside: {
-            double ost;
-            if ( !outsideTemp.isOtSource() && outsideTemp.get(ost))
-                newMsg = OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, tmpToData(ost));
-            break;
-        }
-        case OpenThermMessageID::TdhwSet: {
-            if (boilerCtrl.overrideDhw) {
-                if (mt == OpenThermMessageType::READ_ACK)
-                    // roomunit tried to read dhw set temp. Catch it in order to force writing DHW setpoint by roomunit.
-                    newMsg = OpenTherm::buildResponse(OpenThermMessageType::DATA_INVALID, id, 0x0000);
-            }
-            break;
-        }
-        default:
-            break;
-        }
-        slave.sendResponse(newMsg);
+        // forward reply from boiler to room unit, rewritten by the repeater rules
+        if ( !diagResponse && !repeaterCache.refreshPending && (rules.apply(OTRules::DIR_RESPONSE, newMsg) != OTRules::RES_BLOCK) )
+            slave.sendResponse(newMsg, (newMsg != msg) ? 'A' : 0);
+        repeaterCache.refreshPending = false;
         break;
     }
 
-    master.onReceive((newMsg == msg) ? 'B' : 'A', msg);
+    // learn the capabilities of the slave, not of the simulated boiler in loopback mode
+    if ( ((otMode == OTMODE_MASTER) || (otMode == OTMODE_REPEATER)) &&
+            (status == OpenThermResponseStatus::SUCCESS) && otcaps.onResponse(msg) ) {
+        // another slave, poll all values again
+        if (otMode == OTMODE_MASTER)
+            for (auto *valobj: slaveValues)
+                if (valobj != otval)
+                    valobj->init(true);
+    }
+
+    for (auto &fh: faultHistory)
+        fh.onResponse(msg);
+    tsp.onResponse(msg);
+
+    if ( (otMode == OTMODE_MASTER) || (otMode == OTMODE_LOOPBACKTEST) ) {
+        for (uint8_t i=0; i<numWriteRequests; i++)
+            if (writeRequests[i]->getId() == id)
+                writeRequests[i]->onResponse(msg);
+    }
 
     if (otval) {
         switch (mt) {
         case OpenThermMessageType::READ_ACK:
             otval->setValue(newMsg & 0xFFFF);
+            if (otMode == OTMODE_REPEATER)
+                otval->setCached();
             switch (id) {
             case OpenThermMessageID::Toutside:
                 outsideTemp.set(OpenTherm::getFloat(msg), OutsideTemp::SOURCE_OT);
@@ -580,9 +970,9 @@ void OTControl::OnRxSlave(const unsigned long msg, const OpenThermResponseStatus
             OTValue *otval = OTValue::getSlaveValue(id);
             switch (id) {
             case OpenThermMessageID::Toutside: {
-                double t;
+                float t;
                 if (outsideTemp.get(t))
-                    resp = OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, tmpToData(t));
+                    resp = OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, floatToF88(t));
                 break;
             }
 
@@ -644,79 +1034,60 @@ void OTControl::OnRxSlave(const unsigned long msg, const OpenThermResponseStatus
     }
 
     case OTMODE_REPEATER: {
-        // forward received request to boiler
-        // WRITE commands to boiler can be modified here
-
-        switch (id) {
-        case OpenThermMessageID::TSet:
-            if ( (heatingCtrl[0].overrideFlow) && (mt == OpenThermMessageType::WRITE_DATA) )
-                newMsg = OpenTherm::buildRequest(mt, id, OpenTherm::temperatureToData(getFlow(0)));
-            break;
-
-        case OpenThermMessageID::TsetCH2:
-            if ( (heatingCtrl[1].overrideFlow) && (mt == OpenThermMessageType::WRITE_DATA) )
-                newMsg = OpenTherm::buildRequest(mt, id, OpenTherm::temperatureToData(getFlow(1)));
+        // forward received request to boiler, rewritten by the repeater rules
+        switch (rules.apply(OTRules::DIR_REQUEST, newMsg)) {
+        case OTRules::RES_BLOCK:
+            slave.onReceive('S', msg);
             break;
 
-        case OpenThermMessageID::TdhwSet:
-            if ( boilerCtrl.overrideDhw && (mt == OpenThermMessageType::WRITE_DATA) )
-                newMsg = OpenTherm::buildRequest(mt, id, OpenTherm::temperatureToData(boilerCtrl.dhwTemp));
+        case OTRules::RES_ANSWER:
+            slave.onReceive('S', msg);
+            slave.sendResponse(newMsg, 'P');
             break;
 
-        case OpenThermMessageID::Status:
-            if (heatingCtrl[0].overrideFlow) {
-                if (heatingCtrl[0].mode == CtrlMode::CTRLMODE_OFF)
-                    newMsg &= ~(1<<8); // CH1 disable
-                else
-                    newMsg |= 1<<8; // CH1 enable
+        default: {
+            // hybrid mode: READs of polled values are answered from the cache if not older than maxAge,
+            // otherwise forwarded, after the response to an own request on the line
+            const bool busy = !master.hal.isReady();
+            uint16_t data;
+            OTValue *otval = OTValue::getSlaveValue(id);
+            if ( repeaterCache.enable && (mt == OpenThermMessageType::READ_DATA) && (otval != nullptr) && otval->isCacheable() ) {
+                if (otval->getCached(repeaterCache.maxAge, data)) {
+                    repeaterCache.hits++;
+                    unsigned long resp = OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, data);
+                    slave.onReceive('S', msg);
+                    if (rules.apply(OTRules::DIR_RESPONSE, resp) != OTRules::RES_BLOCK)
+                        slave.sendResponse(resp, 'P');
+                    break;
+                }
+                repeaterCache.misses++;
             }
-            if (heatingCtrl[1].overrideFlow) {
-                if (heatingCtrl[1].mode == CtrlMode::CTRLMODE_OFF)
-                    newMsg &= ~(1<<12); // CH2 disable
-                else
-                    newMsg |= 1<<12; // CH2 enable
+
+            slave.onReceive('T', msg);
+            slave.reqMicros = micros();
+            if (busy) {
+                // forwarded by loop() after the response to the own request
+                pendingFwd = newMsg;
+                pendingFwdSource = (newMsg != msg) ? 'R' : 0;
+                fwdPending = true;
+                break;
             }
-            if (boilerCtrl.overrideDhw) {
-                if (boilerCtrl.dhwOn)
-                    newMsg |= 1<<9; // DHW enable
-                else
-                    newMsg &= ~(1<<9); // DHW disable
-            }                            
-            
-            newMsg = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, id, newMsg & 0xFFFF);
+            master.sendRequest((newMsg != msg) ? 'R' : 0, newMsg);
             break;
         }
-        master.sendRequest(0, newMsg);
-        slave.onReceive((msg == newMsg) ? 'T' : 'R', msg);
+        }
         break;
     }
 
     case OTMODE_LOOPBACKTEST: {
         slave.onReceive('S', msg);
-        // we received a request from OT master
-        switch (mt) {
-        case OpenThermMessageType::WRITE_DATA: {
-            uint32_t reply = OpenTherm::buildResponse(OpenThermMessageType::WRITE_ACK, id, msg & 0xFFFF);
-            slave.sendResponse(reply, 'P');
-            break;
-        }
-
-        case OpenThermMessageType::READ_DATA: {
-            uint32_t reply = OpenTherm::buildResponse(OpenThermMessageType::UNKNOWN_DATA_ID, id, msg & 0xFFFF);
-
-            for (unsigned int i = 0; i< sizeof(loopbackTestData) / sizeof(loopbackTestData[0]); i++) {
-                if (loopbackTestData[i].id == id) {
-                    reply = OpenTherm::buildResponse(OpenThermMessageType::READ_ACK, id, loopbackTestData[i].value);
-                    break;
-                }
-            }
-
-            slave.sendResponse(reply, 'P');
-            break;
-        }
-
-        default:
-            break;
+        // we received a request from OT master, answered by the simulated boiler
+        simReply = boilerSim.handleRequest(msg);
+        if (boilerSim.latency == 0)
+            slave.sendResponse(simReply, 'P');
+        else {
+            simReplyDue = millis() + boilerSim.latency;
+            simReplyPending = true;
         }
         break;
     }
@@ -730,7 +1101,7 @@ void OTControl::OnRxSlave(const unsigned long msg, const OpenThermResponseStatus
          (id == OpenThermMessageID::StatusVentilationHeatRecovery) ||
          (id == OpenThermMessageID::TrSet) // roomunit RAM 786 sends TrSet as READ command (out of spec!)
        ) {
-        double d = OpenTherm::getFloat(newMsg);
+        float d = OpenTherm::getFloat(newMsg);
         switch (id) {
         case OpenThermMessageID::Tr:
             roomTemp[0].set(d, Sensor::SOURCE_OT);
@@ -752,21 +1123,23 @@ void OTControl::OnRxSlave(const unsigned long msg, const OpenThermResponseStatus
 }
 
 bool OTControl::setThermostatVal(const unsigned long msg) {
-    auto id = OpenTherm::getDataID(msg);
+    OTValue *valobj = OTValue::getThermostatValue(OpenTherm::getDataID(msg));
+    if (valobj == nullptr)
+        return false;
 
-    for (auto *valobj: thermostatValues) {
-        if (valobj->getId() == id) {
-            valobj->setValue(msg & 0xFFFF);
-            return true;
-        }
-    }
-    return false;
+    valobj->setValue(msg & 0xFFFF);
+    return true;
 }
 
-void OTControl::getJson(JsonObject &obj) {
+/**
+ * @param withValues false: without the OT values, which the compact status encodes by data ID
+ */
+void OTControl::getJson(JsonObject &obj, const bool withValues) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
     JsonObject jSlave = obj[F("slave")].to<JsonObject>();
-    for (auto *valobj: slaveValues)
-        valobj->getJson(jSlave);
+    if (withValues)
+        for (auto *valobj: slaveValues)
+            valobj->getJson(jSlave);
 
     static bool slaveConnected = false;
     switch (master.hal.getLastResponseStatus()) {
@@ -779,21 +1152,56 @@ void OTControl::getJson(JsonObject &obj) {
     default:
         break;
     }
+    for (auto &fh: faultHistory)
+        fh.getJson(jSlave);
+
     jSlave[F("connected")] = slaveConnected;
     jSlave[F("txCount")] = master.txCount;
     jSlave[F("rxCount")] = master.rxCount;
-    if ( (otMode == OTMODE_MASTER) || (otMode == OTMODE_LOOPBACKTEST) )
+    if ( (otMode == OTMODE_MASTER) || (otMode == OTMODE_LOOPBACKTEST) ) {
         jSlave[F("timeouts")] = master.timeoutCount;
+        JsonObject jsched = obj[F("scheduler")].to<JsonObject>();
+        scheduler.getJson(jsched);
+        JsonObject jpoll = jsched[F("polling")].to<JsonObject>();
+        for (auto *valobj: slaveValues)
+            valobj->getPollJson(jpoll);
+        JsonObject javoid = jsched[F("writesAvoided")].to<JsonObject>();
+        for (uint8_t i=0; i<numWriteRequests; i++)
+            javoid[FPSTR(getOTname(writeRequests[i]->getId()))] = writeRequests[i]->getAvoided();
+    }
+
+    JsonObject jcaps = jSlave[F("capabilities")].to<JsonObject>();
+    otcaps.getJson(jcaps);
+
+    if (otMode == OTMODE_REPEATER) {
+        JsonObject jrules = obj[F("repeaterRules")].to<JsonObject>();
+        rules.getJson(jrules);
+
+        if (repeaterCache.enable) {
+            JsonObject jcache = obj[F("repeaterCache")].to<JsonObject>();
+            jcache[F("hits")] = repeaterCache.hits;
+            jcache[F("misses")] = repeaterCache.misses;
+            jcache[F("refreshes")] = repeaterCache.refreshes;
+            JsonObject jsched = jcache[F("scheduler")].to<JsonObject>();
+            cacheScheduler.getJson(jsched);
+        }
+    }
+
+    JsonObject jtask = obj[F("otTask")].to<JsonObject>();
+    jtask[F("loops")] = taskStats.numLoops;
+    jtask[F("loopAvg")] = (uint32_t) taskStats.gapAvg; // us
+    jtask[F("loopMax")] = max(taskStats.gapMax[0], taskStats.gapMax[1]); // us, last 10..20 s
 
     JsonObject thermostat = obj[F("thermostat")].to<JsonObject>();
-    for (auto *valobj: thermostatValues)
-        valobj->getJson(thermostat);
+    if (withValues)
+        for (auto *valobj: thermostatValues)
+            valobj->getJson(thermostat);
 
     
     JsonArray hcarr = obj[F("heatercircuit")].to<JsonArray>();
     for (int i=0; i<2; i++) {
         JsonObject hc = hcarr.add<JsonObject>();
-        double d;
+        float d;
         if (roomSetPoint[i].get(d))
             hc[F("roomsetpoint")] = d;
         if (roomTemp[i].get(d))
@@ -811,6 +1219,15 @@ void OTControl::getJson(JsonObject &obj) {
         thermostat[F("txCount")] = slave.txCount;
         thermostat[F("rxCount")] = slave.rxCount;
         thermostat[F("invalidCount")] = slave.invalidCount;
+        thermostat[F("lateResponses")] = slave.numLate;
+        thermostat[F("droppedResponses")] = slave.numDropped;
+        if ( (otMode == OTMODE_REPEATER) && (repeaterLatency.total > 0) ) {
+            JsonObject jlat = thermostat[F("latency")].to<JsonObject>(); // ms
+            jlat[F("p50")] = repeaterLatency.percentile(50);
+            jlat[F("p90")] = repeaterLatency.percentile(90);
+            jlat[F("p99")] = repeaterLatency.percentile(99);
+            jlat[F("count")] = repeaterLatency.total;
+        }
 
         String sp;
         switch (slave.hal.getSmartPowerState()) {
@@ -828,6 +1245,156 @@ void OTControl::getJson(JsonObject &obj) {
     }
 }
 
+/**
+ * Same content as getJson(), streamed without building the document.
+ */
+void OTControl::writeJson(JsonWriter &w) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
+    w.beginObject(PSTR("slave"));
+    for (auto *valobj: slaveValues)
+        valobj->writeJson(w);
+
+    static bool slaveConnected = false;
+    switch (master.hal.getLastResponseStatus()) {
+    case OpenThermResponseStatus::SUCCESS:
+    case OpenThermResponseStatus::INVALID:
+        slaveConnected = true;
+        break;
+    case OpenThermResponseStatus::TIMEOUT:
+        slaveConnected = false;
+    default:
+        break;
+    }
+    for (auto &fh: faultHistory)
+        fh.writeJson(w);
+
+    w.add(PSTR("connected"), slaveConnected);
+    w.add(PSTR("txCount"), master.txCount);
+    w.add(PSTR("rxCount"), master.rxCount);
+    const bool ownRequests = (otMode == OTMODE_MASTER) || (otMode == OTMODE_LOOPBACKTEST);
+    if (ownRequests)
+        w.add(PSTR("timeouts"), master.timeoutCount);
+    w.beginObject(PSTR("capabilities"));
+    otcaps.writeJson(w);
+    w.endObject();
+    w.endObject();
+
+    if (ownRequests) {
+        w.beginObject(PSTR("scheduler"));
+        scheduler.writeJson(w);
+        w.beginObject(PSTR("polling"));
+        for (auto *valobj: slaveValues)
+            valobj->writePollJson(w);
+        w.endObject();
+        w.beginObject(PSTR("writesAvoided"));
+        for (uint8_t i=0; i<numWriteRequests; i++)
+            w.add(getOTname(writeRequests[i]->getId()), writeRequests[i]->getAvoided());
+        w.endObject();
+        w.endObject();
+    }
+
+    if (otMode == OTMODE_REPEATER) {
+        w.beginObject(PSTR("repeaterRules"));
+        rules.writeJson(w);
+        w.endObject();
+
+        if (repeaterCache.enable) {
+            w.beginObject(PSTR("repeaterCache"));
+            w.add(PSTR("hits"), repeaterCache.hits);
+            w.add(PSTR("misses"), repeaterCache.misses);
+            w.add(PSTR("refreshes"), repeaterCache.refreshes);
+            w.beginObject(PSTR("scheduler"));
+            cacheScheduler.writeJson(w);
+            w.endObject();
+            w.endObject();
+        }
+    }
+
+    w.beginObject(PSTR("otTask"));
+    w.add(PSTR("loops"), taskStats.numLoops);
+    w.add(PSTR("loopAvg"), (uint32_t) taskStats.gapAvg); // us
+    w.add(PSTR("loopMax"), max(taskStats.gapMax[0], taskStats.gapMax[1])); // us, last 10..20 s
+    w.endObject();
+
+    w.beginObject(PSTR("thermostat"));
+    for (auto *valobj: thermostatValues)
+        valobj->writeJson(w);
+
+    if (slaveEnabled) {
+        w.add(PSTR("txCount"), slave.txCount);
+        w.add(PSTR("rxCount"), slave.rxCount);
+        w.add(PSTR("invalidCount"), slave.invalidCount);
+        w.add(PSTR("lateResponses"), slave.numLate);
+        w.add(PSTR("droppedResponses"), slave.numDropped);
+        if ( (otMode == OTMODE_REPEATER) && (repeaterLatency.total > 0) ) {
+            w.beginObject(PSTR("latency")); // ms
+            w.add(PSTR("p50"), repeaterLatency.percentile(50));
+            w.add(PSTR("p90"), repeaterLatency.percentile(90));
+            w.add(PSTR("p99"), repeaterLatency.percentile(99));
+            w.add(PSTR("count"), repeaterLatency.total);
+            w.endObject();
+        }
+
+        const char *sp = "";
+        switch (slave.hal.getSmartPowerState()) {
+        case OpenThermSmartPower::SMART_POWER_LOW:
+            sp = PSTR("low");
+            break;
+        case OpenThermSmartPower::SMART_POWER_MEDIUM:
+            sp = PSTR("medium");
+            break;
+        case OpenThermSmartPower::SMART_POWER_HIGH:
+            sp = PSTR("high");
+            break;
+        }
+        w.add(PSTR("smartPower"), sp);
+    }
+    w.endObject();
+
+    w.beginArray(PSTR("heatercircuit"));
+    for (int i=0; i<2; i++) {
+        w.beginObject();
+        float d;
+        if (roomSetPoint[i].get(d))
+            w.add(PSTR("roomsetpoint"), d);
+        if (roomTemp[i].get(d))
+            w.add(PSTR("roomtemp"), d);
+
+        w.add(PSTR("ovrdFlow"), heatingCtrl[i].overrideFlow);
+        w.add(PSTR("mode"), (int) heatingCtrl[i].mode);
+        w.add(PSTR("integState"), heatingCtrl[i].piCtrl.integState);
+        w.add(PSTR("roomTempFilt"), heatingCtrl[i].piCtrl.roomTempFilt);
+        if (heatingConfig[i].enableHyst)
+            w.add(PSTR("suspended"), heatingCtrl[i].suspended);
+        w.endObject();
+    }
+    w.endArray();
+}
+
+/**
+ * OT values of the slave or the room unit for the compact status, keyed by data ID.
+ */
+void OTControl::writeCbor(CborWriter &w, const bool thermostat) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
+    for (auto *valobj: thermostat ? thermostatValues : slaveValues)
+        valobj->writeCbor(w);
+}
+
+void OTControl::getSchemaJson(JsonObject &obj) {
+    std::lock_guard<std::recursive_mutex> guard(stateMutex);
+    JsonObject jslave = obj[F("slave")].to<JsonObject>();
+    for (auto *valobj: slaveValues) {
+        JsonObject jval = jslave[String((int) valobj->getId())].to<JsonObject>();
+        valobj->getSchemaJson(jval);
+    }
+
+    JsonObject jthermostat = obj[F("thermostat")].to<JsonObject>();
+    for (auto *valobj: thermostatValues) {
+        JsonObject jval = jthermostat[String((int) valobj->getId())].to<JsonObject>();
+        valobj->getSchemaJson(jval);
+    }
+}
+
 bool OTControl::sendDiscovery() {
     for (auto *valobj: slaveValues)
         valobj->refreshDisc();
@@ -835,6 +1402,9 @@ bool OTControl::sendDiscovery() {
     for (auto *valobj: thermostatValues)
         valobj->refreshDisc();
 
+    for (auto &fh: faultHistory)
+        fh.refreshDisc();
+
     bool discFlag = true;
 
     haDisc.createNumber(F("Outside temperature"), Mqtt::getTopicString(Mqtt::TOPIC_OUTSIDETEMP), mqtt.getCmdTopic(Mqtt::TOPIC_OUTSIDETEMP));
@@ -973,24 +1543,27 @@ bool OTControl::sendDiscovery() {
     return discFlag;
 }
 
-void OTControl::setDhwTemp(double temp) {
-    boilerCtrl.dhwTemp = temp;
-    setDhwRequest.force();
+void OTControl::setDhwTemp(float temp) {
+    post({Command::CMD_DHW_TEMP, 0, temp});
 }
 
 void OTControl::setDhwCtrlMode(const CtrlMode mode) {
-    boilerCtrl.dhwOn = (mode != CtrlMode::CTRLMODE_OFF);
-    setDhwRequest.force();
+    post({Command::CMD_DHW_MODE, 0, (float) mode});
 }
 
 void OTControl::setConfig(JsonObject &config) {
-    while (!master.hal.isReady()) {
+    post({Command::CMD_CONFIG, 0, 0, &config}, true);
+}
+
+/**
+ * Called by the OT task with the OT line idle. Only if the OT task posted the config
+ * itself a frame may still be on the line, it sleeps until that is done.
+ */
+void OTControl::applyConfig(JsonObject &config) {
+    while (!master.hal.isReady() || !slave.hal.isReady()) {
+        vTaskDelay(1);
         master.hal.process();
-        yield();
-    }
-    while (!slave.hal.isReady()) {
         slave.hal.process();
-        yield();
     }
 
     OTMode mode = OTMODE_BYPASS;
@@ -1012,6 +1585,7 @@ void OTControl::setConfig(JsonObject &config) {
         hc.roomTempCompI = hpObj[F("roomtempcompI")] | 0.0;
         hc.hysteresis = hpObj[F("hysteresis")] | 0.1;
         hc.enableHyst = hpObj[F("enableHyst")] | false;
+        heatingCurve[i].valid = false;
         
         heatingCtrl[i].flowTemp = hc.flow;
         heatingCtrl[i].chOn = hc.chOn;
@@ -1038,6 +1612,26 @@ void OTControl::setConfig(JsonObject &config) {
 
     masterMemberId = config[F("masterMemberId")] | 22;
 
+    OTValue::setPollConfig(config[F("polling")]);
+    boilerSim.setConfig(config[F("sim")]);
+    rules.setConfig(config[F("repeaterRules")]);
+
+    // hybrid repeater: {"enable": true, "maxAge": 30}, maxAge in s
+    JsonObject cacheObj = config[F("repeaterCache")];
+    repeaterCache.enable = cacheObj[F("enable")] | false;
+    repeaterCache.maxAge = (cacheObj[F("maxAge")] | 30) * 1000UL;
+    repeaterCache.refreshPending = false;
+
+    // deadband of temperature writes in K
+    const uint16_t deadband = (float) (config[F("writeDeadband")] | 0.2) * 256;
+    setDhwRequest.setDeadband(deadband);
+    setOutsideTemp.setDeadband(deadband);
+    for (int ch=0; ch<2; ch++) {
+        setBoilerRequest[ch].setDeadband(deadband);
+        setRoomTemp[ch].setDeadband(deadband);
+        setRoomSetPoint[ch].setDeadband(deadband);
+    }
+
     slaveApp = (SlaveApplication) ((int) config[F("slaveApp")] | 0);
 
     setOTMode(mode, config[F("enableSlave")] | false);
@@ -1048,135 +1642,204 @@ void OTControl::setConfig(JsonObject &config) {
 
     master.resetCounters();
     slave.resetCounters();
+    scheduler.resetCounters();
+    for (uint8_t i=0; i<numWriteRequests; i++)
+        writeRequests[i]->resetCounters();
 }
 
 void OTControl::setChCtrlMode(const CtrlMode mode, const uint8_t channel) {
-    heatingCtrl[channel].mode = mode;
-    switch (mode) {
-    case CTRLMODE_AUTO:
-        heatingCtrl[channel].chOn = heatingConfig[channel].chOn;
-        break;
-    case CTRLMODE_OFF:
-        heatingCtrl[channel].chOn = false;
-        break;
-    case CTRLMODE_ON:
-        heatingCtrl[channel].chOn = true;
-    }
-    setBoilerRequest[channel].force();
+    post({Command::CMD_CH_MODE, channel, (float) mode});
 }
 
 void OTControl::setOverrideCh(const bool ovrd, const uint8_t channel) {
-    heatingCtrl[channel].overrideFlow = ovrd;
-    setBoilerRequest[channel].force();
+    post({Command::CMD_OVERRIDE_CH, channel, (float) ovrd});
 }
 
 void OTControl::setOverrideDhw(const bool ovrd) {
-    boilerCtrl.overrideDhw = ovrd;
-    setDhwRequest.force();
+    post({Command::CMD_OVERRIDE_DHW, 0, (float) ovrd});
 }
 
-void OTControl::setChTemp(const double temp, const uint8_t channel) {
-    if (temp == 0)
-        heatingCtrl[channel].mode = CTRLMODE_AUTO;
-    else
-        heatingCtrl[channel].flowTemp = temp;
-    setBoilerRequest[channel].force();
+void OTControl::setChTemp(const float temp, const uint8_t channel) {
+    post({Command::CMD_CH_TEMP, channel, temp});
 }
 
 void OTControl::forceFlowCalc(const uint8_t channel) {
-    setBoilerRequest[channel].force();
+    post({Command::CMD_FORCE_FLOW, channel});
 }
 
 void OTControl::setVentSetpoint(const uint8_t v) {
-    ventCtrl.setpoint = v;
-    setVentSetpointRequest.force();
+    post({Command::CMD_VENT_SETPOINT, 0, (float) v});
 }
 
 void OTControl::setVentEnable(const bool en) {
-    ventCtrl.ventEnable = en;
+    post({Command::CMD_VENT_ENABLE, 0, (float) en});
 }
 
-unsigned long OTControl::slaveRequest(OpenThermMessageID id, OpenThermMessageType ty, uint16_t data) {
-    unsigned long res = 0;
+/**
+ * @param interval ms, minimum time between two requests
+ * @param refresh ms, keep-alive if the value didn't change since the last WRITE_ACK
+ */
+OTWriteRequest::OTWriteRequest(OpenThermMessageID id, const uint32_t interval, const uint32_t refresh, const Priority prio,
+            const OpenThermMessageType msgType):
+        OTJob(prio),
+        id(id),
+        msgType(msgType),
+        interval(interval),
+        refresh(refresh) {
+}
 
-    if (xSemaphoreTake(master.mutex, (TickType_t)100 / portTICK_PERIOD_MS) == pdTRUE) {
-        while (!master.hal.isReady()) {
-            master.hal.process();
-            yield();
-        }
-        unsigned long req = OpenTherm::buildRequest(ty, id, data);
-        sendRequest('T', req);
-        while (!master.hal.isReady()) {
-            master.hal.process();
-            slave.hal.process(); // in loopback mode slave objekt has to process our request!
-            yield();
-        }
-        res = master.hal.getLastResponse();
-        xSemaphoreGive(master.mutex);
-    }
-    return res;
+void OTWriteRequest::setSource(DataSource src) {
+    source = src;
 }
 
+void OTWriteRequest::setDeadband(const uint16_t raw) {
+    deadband = raw;
+}
 
-OTWriteRequest::OTWriteRequest(OpenThermMessageID id, uint16_t intervalS):
-        id(id),
-        interval(intervalS) {
+/**
+ * Compared against the data sent, not the acknowledged data: a value clamped by
+ * the slave is not sent again and again.
+ */
+bool OTWriteRequest::isChanged(const uint16_t data) const {
+    return abs((int16_t) data - (int16_t) sentData) > deadband;
 }
 
-void OTWriteRequest::send(const uint16_t data) {
-    nextMillis = millis() + interval * 1000;
+/**
+ * interval, doubled with every rejection of the slave
+ */
+uint32_t OTWriteRequest::getRetryInterval() const {
+    if (numRejected == 0)
+        return interval;
+    return min(interval << min(numRejected, (uint8_t) 12), MAX_BACKOFF);
+}
+
+/**
+ * Due every interval while the value changes or isn't acknowledged by the slave,
+ * otherwise only every refresh.
+ */
+bool OTWriteRequest::getRelease(const uint32_t now, uint32_t &release) {
+    if (!source)
+        return false;
+
+    if (forced) {
+        release = now;
+        return true;
+    }
+
+    release = lastSent + getRetryInterval();
+    if ( !acked || ((int32_t) (now - release) < 0) )
+        return true;
+
+    if ((int32_t) (now - holdUntil) < 0) {
+        release = holdRelease;
+        return true;
+    }
 
-    unsigned long req = OpenTherm::buildRequest(OpenThermMessageType::WRITE_DATA, id, data);
-    otcontrol.sendRequest('T', req);
+    uint16_t data;
+    const bool valid = source(data);
+    if (valid && isChanged(data))
+        return true;
+
+    if ( valid && (refresh > interval) && ((int32_t) (now - nextAvoid) >= 0) ) {
+        // a write was due, the deadband suppressed it
+        numAvoided++;
+        nextAvoid = now + interval;
+    }
+
+    // nothing new to tell, check the source again in a second
+    release = lastSent + refresh;
+    holdRelease = release;
+    holdUntil = now + 1000;
+    return true;
 }
 
-void OTWriteRequest::sendTemp(const double temp) {
-    int16_t td;
-    if (temp > 100)
-        td = 100 << 8;
-    else if (temp < -100)
-        td = - (int) (100 << 8);
-    else
-        td = (int) (temp * 256);
+bool OTWriteRequest::getRequest(unsigned long &request) {
+    uint16_t data;
+    if (!source(data))
+        return false;
+
+    sentData = data;
+    request = OpenTherm::buildRequest(msgType, id, data);
+    return true;
+}
+
+uint32_t OTWriteRequest::getPeriod() const {
+    return acked ? refresh : getRetryInterval();
+}
+
+void OTWriteRequest::onSent(const uint32_t now) {
+    lastSent = now;
+    forced = false;
+    acked = false;
+    holdUntil = now;
+    nextAvoid = now + interval;
+}
 
-    send(td);
+void OTWriteRequest::onResponse(const unsigned long msg) {
+    switch (OpenTherm::getMessageType(msg)) {
+    case OpenThermMessageType::WRITE_ACK:
+        ackData = msg & 0xFFFF;
+        acked = true;
+        numRejected = 0;
+        break;
+    case OpenThermMessageType::UNKNOWN_DATA_ID:
+    case OpenThermMessageType::DATA_INVALID:
+        // retried with back off, the slave may learn the ID later (e.g. after a reset)
+        if (numRejected < 255)
+            numRejected++;
+        break;
+    default:
+        break;
+    }
 }
 
 void OTWriteRequest::force() {
-    nextMillis = 0;
+    forced = true;
+}
+
+OpenThermMessageID OTWriteRequest::getId() const {
+    return id;
 }
 
-OTWriteRequest::operator bool() {
-    return (millis() > nextMillis);
+uint32_t OTWriteRequest::getAvoided() const {
+    return numAvoided;
+}
+
+void OTWriteRequest::resetCounters() {
+    numAvoided = 0;
 }
 
 
 OTWRSetDhw::OTWRSetDhw():
-        OTWriteRequest(OpenThermMessageID::TdhwSet, 30) {
+        OTWriteRequest(OpenThermMessageID::TdhwSet, 30000, 120000, PRIO_SETPOINT) {
 }
 
 OTWRSetBoilerTemp::OTWRSetBoilerTemp(const uint8_t ch):
-        OTWriteRequest(OpenThermMessageID::TSet, 10) {
+        OTWriteRequest(OpenThermMessageID::TSet, 10000, 30000, PRIO_CONTROL) {
     if (ch == 1)
         id = OpenThermMessageID::TsetCH2;
 }
 
 OTWRMasterConfigMember::OTWRMasterConfigMember():
-        OTWriteRequest(OpenThermMessageID::MConfigMMemberIDcode, 60) {
+        OTWriteRequest(OpenThermMessageID::MConfigMMemberIDcode, 60000, 60000, PRIO_INFO) {
 }
 
 OTWRSetVentSetpoint::OTWRSetVentSetpoint():
-        OTWriteRequest(OpenThermMessageID::Vset, 60) {
+        OTWriteRequest(OpenThermMessageID::Vset, 60000, 300000, PRIO_SETPOINT) {
 }
 
 OTWRSetRoomTemp::OTWRSetRoomTemp(const uint8_t ch):
-        OTWriteRequest((ch == 0) ? OpenThermMessageID::Tr : OpenThermMessageID::TrCH2, 60) {
+        OTWriteRequest((ch == 0) ? OpenThermMessageID::Tr : OpenThermMessageID::TrCH2, 60000, 300000, PRIO_SETPOINT) {
 }
 
 OTWRSetRoomSetPoint::OTWRSetRoomSetPoint(const uint8_t ch):
-        OTWriteRequest((ch == 0) ? OpenThermMessageID::TrSet : OpenThermMessageID::TrSetCH2, 60) {
+        OTWriteRequest((ch == 0) ? OpenThermMessageID::TrSet : OpenThermMessageID::TrSetCH2, 60000, 300000, PRIO_SETPOINT) {
 }
 
 OTWRSetOutsideTemp::OTWRSetOutsideTemp():
-        OTWriteRequest(OpenThermMessageID::Toutside, 60) {
-}
\ No newline at end of file
+        OTWriteRequest(OpenThermMessageID::Toutside, 60000, 300000, PRIO_SETPOINT) {
+}
+
+OTStatusRequest::OTStatusRequest(OpenThermMessageID id):
+        OTWriteRequest(id, 800, 800, PRIO_STATUS, OpenThermMessageType::READ_DATA) {
+}
@@ -0,0 +1,423 @@
+#include "otreplay.h"
+#include "otcontrol.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <new>
+
+OTReplay otreplay;
+static SemaphoreHandle_t stateMutex = xSemaphoreCreateMutex();
+
+static int hexDigit(const uint8_t c) {
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    return -1;
+}
+
+static uint32_t getU32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+OTReplay::Upload *OTReplay::Upload::create() {
+    void *mem = malloc(sizeof(Upload) + MAX_FRAMES * sizeof(OTFrame));
+    if (mem == nullptr)
+        return nullptr;
+    return new (mem) Upload();
+}
+
+OTFrame *OTReplay::Upload::getFrames() {
+    return reinterpret_cast<OTFrame*>(this + 1);
+}
+
+void OTReplay::Upload::add(const OTFrame &frame) {
+    if (numFrames >= MAX_FRAMES) {
+        overflow = true;
+        return;
+    }
+    getFrames()[numFrames++] = frame;
+}
+
+/**
+ * text log, one frame per line: source char followed by 8 hex digits
+ */
+void OTReplay::Upload::putText(const uint8_t c) {
+    if (c == '\n') {
+        endLine();
+        return;
+    }
+
+    if ( lineStart && ((c == ' ') || (c == '\t')) )
+        return;
+
+    lineStart = false;
+    if (bufLen < LINE_START)
+        buf[bufLen++] = c;
+}
+
+void OTReplay::Upload::endLine() {
+    if ( (bufLen >= 9) && strchr("TBRAPSEX", buf[0]) && ((bufLen == 9) || (hexDigit(buf[9]) < 0)) ) {
+        uint32_t frame = 0;
+        uint8_t n;
+        for (n=1; n<=8; n++) {
+            const int d = hexDigit(buf[n]);
+            if (d < 0)
+                break;
+            frame = (frame << 4) | d;
+        }
+
+        if (n > 8) {
+            OTFrame f;
+            f.micros = numFrames * TEXT_SPACING;
+            f.frame = frame;
+            f.source = buf[0];
+            switch (f.source) {
+            case 'E':
+                f.status = (uint8_t) OpenThermResponseStatus::INVALID;
+                break;
+            case 'X':
+                f.status = (uint8_t) OpenThermResponseStatus::TIMEOUT;
+                break;
+            default:
+                f.status = (uint8_t) OpenThermResponseStatus::SUCCESS;
+                break;
+            }
+            f.reserved = 0;
+            add(f);
+        }
+    }
+    bufLen = 0;
+    lineStart = true;
+}
+
+/**
+ * binary capture, see framelog.h
+ */
+void OTReplay::Upload::putCapture(const uint8_t c) {
+    const size_t HDR = OTFrameLog::CAPTURE_HEADER_SIZE;
+
+    if (bufLen < HDR) {
+        buf[bufLen++] = c;
+        if (bufLen == HDR) {
+            recSize = buf[6] | (buf[7] << 8);
+            recCount = getU32(buf + 8);
+            if (recSize < OTFrameLog::CAPTURE_RECORD_SIZE)
+                format = FMT_INVALID;
+        }
+        return;
+    }
+
+    if (recPos < OTFrameLog::CAPTURE_RECORD_SIZE)
+        buf[recPos] = c;
+    if (++recPos < recSize)
+        return;
+
+    recPos = 0;
+    if (recIndex++ >= recCount)
+        return;
+
+    OTFrame f;
+    f.micros = getU32(buf);
+    f.frame = getU32(buf + 4);
+    f.source = buf[8];
+    f.status = buf[9];
+    f.reserved = 0;
+    if (f.status != OTFrameLog::STATUS_LOST)
+        add(f);
+}
+
+/**
+ * Called from the web server task for every chunk of the request body.
+ */
+void OTReplay::Upload::write(const uint8_t *data, const size_t len) {
+    for (size_t i=0; i<len; i++) {
+        switch (format) {
+        case FMT_UNKNOWN:
+            // "OTCP": binary capture, otherwise text
+            buf[bufLen++] = data[i];
+            if (buf[bufLen - 1] != "OTCP"[bufLen - 1]) {
+                uint8_t start[4];
+                const uint8_t n = bufLen;
+                memcpy(start, buf, n);
+                format = FMT_TEXT;
+                bufLen = 0;
+                for (uint8_t j=0; j<n; j++)
+                    putText(start[j]);
+            }
+            else if (bufLen == 4)
+                format = FMT_CAPTURE;
+            break;
+
+        case FMT_TEXT:
+            putText(data[i]);
+            break;
+
+        case FMT_CAPTURE:
+            putCapture(data[i]);
+            break;
+
+        default:
+            return;
+        }
+    }
+}
+
+/**
+ * @returns false if no frame was found
+ */
+bool OTReplay::Upload::finish() {
+    if (format == FMT_TEXT)
+        endLine(); // last line without line feed
+    return (format != FMT_INVALID) && !overflow && (numFrames > 0);
+}
+
+bool OTReplay::Upload::isOverflow() const {
+    return overflow;
+}
+
+/**
+ * Only one upload at a time, called from the web server task.
+ * @returns false if another upload is in progress or waiting to be started
+ */
+bool OTReplay::lockUpload(const void *owner) {
+    if ( uploadReady || ((uploadOwner != nullptr) && (uploadOwner != owner)) )
+        return false;
+    uploadOwner = owner;
+    return true;
+}
+
+/**
+ * @returns true if owner held the lock
+ */
+bool OTReplay::unlockUpload(const void *owner) {
+    if (uploadOwner != owner)
+        return false;
+    uploadOwner = nullptr;
+    return true;
+}
+
+/**
+ * Called from the web server task, takes over up (from Upload::create()) if it returns true.
+ * The frames are not copied, the unused part of the buffer is released.
+ * @param speed time scale of the replay, 0: as fast as possible
+ */
+bool OTReplay::load(Upload *up, const float speed) {
+    if (uploadReady)
+        return false; // previous upload not started yet
+
+    Upload *shrunk = (Upload*) realloc(up, sizeof(Upload) + up->numFrames * sizeof(OTFrame));
+    pending = shrunk ? shrunk : up;
+    uploadSpeed = max(speed, 0.0f);
+    uploadReady = true;
+    return true;
+}
+
+void OTReplay::start() {
+    free(current);
+    current = pending;
+    pending = nullptr;
+    frames = current->getFrames();
+    numFrames = current->numFrames;
+    speed = uploadSpeed;
+    uploadReady = false;
+
+    pos = 0;
+    numFed = 0;
+    numChecked = 0;
+    numMismatch = 0;
+    busyMicros = 0;
+    otcontrol.master.divert = true;
+    otcontrol.slave.divert = true;
+    startMicros = micros();
+    running = true;
+}
+
+void OTReplay::stop() {
+    endMicros = micros();
+    running = false;
+    otcontrol.master.divert = false;
+    otcontrol.slave.divert = false;
+
+    JsonDocument doc;
+    JsonObject obj = doc.to<JsonObject>();
+    otcontrol.getJson(obj);
+    xSemaphoreTake(stateMutex, portMAX_DELAY);
+    state.clear();
+    serializeJson(doc, state);
+    xSemaphoreGive(stateMutex);
+}
+
+/**
+ * Passes frames[pos] to OTControl and checks what it sends against the recorded output,
+ * advances pos past both.
+ */
+void OTReplay::feed() {
+    OTControl &ctrl = otcontrol;
+    const OTFrame &in = frames[pos++];
+    char outSource = 0;
+
+    switch (in.source) {
+    case 'T':
+        if (ctrl.otMode != OTControl::OTMODE_REPEATER)
+            return; // own request
+        [[fallthrough]];
+    case 'R':
+        outSource = 'R';
+        break;
+
+    case 'S':
+        outSource = 'P';
+        break;
+
+    case 'B':
+    case 'A':
+        outSource = 'A';
+        break;
+
+    case 'E':
+    case 'X':
+        break;
+
+    default:
+        return; // own frames
+    }
+
+    // old logs: the original frame marked as rewritten, the output wasn't recorded
+    const bool legacy = (in.source == 'R') || (in.source == 'A');
+    const bool hasOut = outSource && !legacy && (pos < numFrames) && (frames[pos].source == outSource) &&
+                        (OpenTherm::getDataID(frames[pos].frame) == OpenTherm::getDataID(in.frame));
+    const uint32_t expected = hasOut ? frames[pos].frame : 0;
+    if (hasOut)
+        pos++;
+
+    const bool request = (outSource == 'R') || (outSource == 'P');
+    ctrl.master.diverted = false;
+    ctrl.slave.diverted = false;
+    const uint32_t t = micros();
+    if (request)
+        ctrl.OnRxSlave(in.frame, OpenThermResponseStatus::SUCCESS);
+    else
+        ctrl.OnRxMaster(in.frame, (OpenThermResponseStatus) in.status);
+    busyMicros += micros() - t;
+    numFed++;
+
+    if (outSource == 0)
+        return; // not checked
+    numChecked++;
+
+    // forwarded to the boiler, answered or forwarded to the room unit
+    const bool forwarded = ctrl.master.diverted;
+    const bool answered = ctrl.slave.diverted;
+    uint32_t out = 0;
+    if (request && forwarded)
+        out = ctrl.master.divertedMsg;
+    else if (answered)
+        out = ctrl.slave.divertedMsg;
+
+    bool ok;
+    switch (in.source) {
+    case 'T':
+        ok = forwarded && (out == (hasOut ? expected : in.frame));
+        break;
+
+    case 'S':
+        ok = hasOut ? (answered && (out == expected)) : (!forwarded && !answered);
+        break;
+
+    case 'B':
+        ok = hasOut ? (answered && (out == expected)) : (!answered || (out == in.frame));
+        break;
+
+    case 'R':
+        ok = forwarded && (out != in.frame);
+        break;
+
+    default:
+        ok = answered && (out != in.frame);
+        break;
+    }
+
+    if (ok)
+        return;
+
+    if (numMismatch < MAX_MISMATCHES) {
+        Mismatch &mm = mismatches[numMismatch];
+        mm.index = &in - frames;
+        mm.frame = in.frame;
+        mm.out = out;
+        mm.expected = expected;
+        mm.source = in.source;
+    }
+    numMismatch++;
+}
+
+/**
+ * Called by OTControl::loop() in the OT task, starts a loaded replay once the OT line is idle.
+ */
+void OTReplay::loop() {
+    if (uploadReady && !running) {
+        if (!otcontrol.master.hal.isReady() || otcontrol.slave.respPending || otcontrol.fwdPending)
+            return;
+        start();
+    }
+
+    if (!running)
+        return;
+
+    const uint32_t elapsed = micros() - startMicros;
+    const uint32_t frame0 = frames[0].micros;
+    uint8_t n = 0;
+
+    // limit the number of frames per call to keep the OT task responsive
+    while ( (pos < numFrames) && (n < 32) ) {
+        const OTFrame &frame = frames[pos];
+        if ( (speed > 0) && (elapsed < (frame.micros - frame0) / speed) )
+            break;
+        n++;
+        feed();
+    }
+
+    if (pos >= numFrames)
+        stop();
+}
+bool OTReplay::isRunning() const {
+    return running || uploadReady;
+}
+
+void OTReplay::getJson(JsonObject &obj) {
+    obj[F("running")] = isRunning();
+    obj[F("frames")] = numFrames;
+    obj[F("pos")] = pos;
+    obj[F("speed")] = speed;
+    obj[F("fed")] = numFed;
+    obj[F("checked")] = numChecked;
+    obj[F("mismatches")] = numMismatch;
+    if (busyMicros > 0)
+        obj[F("framesPerSec")] = (uint32_t) (numFed * 1000000.0 / busyMicros);
+    const uint32_t wall = (running ? micros() : endMicros) - startMicros;
+    if (wall > 0)
+        obj[F("wallFramesPerSec")] = (uint32_t) (numFed * 1000000.0 / wall);
+
+    JsonArray jmm = obj[F("mismatch")].to<JsonArray>();
+    for (uint8_t i=0; i<min(numMismatch, (uint32_t) MAX_MISMATCHES); i++) {
+        JsonObject jm = jmm.add<JsonObject>();
+        char buf[9];
+        jm[F("index")] = mismatches[i].index;
+        jm[F("source")] = String(mismatches[i].source);
+        snprintf(buf, sizeof(buf), "%08lX", (unsigned long) mismatches[i].frame);
+        jm[F("frame")] = buf;
+        snprintf(buf, sizeof(buf), "%08lX", (unsigned long) mismatches[i].out);
+        jm[F("out")] = buf;
+        snprintf(buf, sizeof(buf), "%08lX", (unsigned long) mismatches[i].expected);
+        jm[F("expected")] = buf;
+    }
+
+    if (!running) {
+        xSemaphoreTake(stateMutex, portMAX_DELAY);
+        if (!state.isEmpty())
+            obj[F("state")] = serialized(state);
+        xSemaphoreGive(stateMutex);
+    }
+}
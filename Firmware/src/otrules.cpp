@@ -0,0 +1,259 @@
+#include "otrules.h"
+
+static const char *DIR_NAMES[] = {"req", "resp"};
+static const char *COND_NAMES[] = {"always", "overrideCh1", "overrideCh2", "overrideDhw", "outsideLocal"};
+static const char *ACTION_NAMES[] = {"replace", "compute", "block", "answer"};
+static const char *SOURCE_NAMES[] = {"none", "flow1", "flow2", "dhwSet", "outside", "status"};
+static const char *TYPE_NAMES[] = {"READ_DATA", "WRITE_DATA", "INVALID_DATA", "RESERVED", "READ_ACK", "WRITE_ACK", "DATA_INVALID", "UNKNOWN_DATA_ID"};
+
+template<size_t N>
+static int findName(const char *(&names)[N], const char *str, const int def) {
+    if (str == nullptr)
+        return def;
+    for (size_t i=0; i<N; i++)
+        if (strcmp(names[i], str) == 0)
+            return i;
+    return -1;
+}
+
+// hex string or number
+static uint16_t getHex(JsonVariant v, const uint16_t def) {
+    if (v.is<const char*>())
+        return strtol(v.as<const char*>(), nullptr, 16);
+    return v | def;
+}
+
+static constexpr uint8_t typeBit(const OpenThermMessageType mt) {
+    return 1 << (uint8_t) mt;
+}
+
+OTRules::OTRules() {
+    setConfig(JsonArray());
+}
+
+void OTRules::setFunctions(CondFunc cond, SourceFunc source) {
+    condFunc = cond;
+    sourceFunc = source;
+}
+
+bool OTRules::add(const Rule &rule) {
+    uint8_t n = 0;
+    for (uint8_t i=0; i<numRules; i++)
+        if ( (rules[i].dir == rule.dir) && (rules[i].id == rule.id) )
+            n++;
+
+    if ( (numRules >= MAX_RULES) || (n >= MAX_PER_ID) ) {
+        numDropped++;
+        return false;
+    }
+    rules[numRules++] = rule;
+    return true;
+}
+
+bool OTRules::parseRule(JsonObject jr, Rule &rule) {
+    const int dir = findName(DIR_NAMES, jr[F("dir")].as<const char*>(), DIR_REQUEST);
+    const int cond = findName(COND_NAMES, jr[F("cond")].as<const char*>(), COND_ALWAYS);
+    const int action = findName(ACTION_NAMES, jr[F("action")].as<const char*>(), ACT_REPLACE);
+    const int source = findName(SOURCE_NAMES, jr[F("source")].as<const char*>(), SRC_NONE);
+    const int msgType = findName(TYPE_NAMES, jr[F("msgType")].as<const char*>(), NO_TYPE);
+    if ( (dir < 0) || (cond < 0) || (action < 0) || (source < 0) || (msgType < 0) || !jr[F("id")].is<int>() )
+        return false;
+
+    const int id = jr[F("id")];
+    if ( (id < 0) || (id > 255) )
+        return false;
+
+    if ( (action == ACT_COMPUTE) && (source == SRC_NONE) )
+        return false;
+
+    if ( (action == ACT_ANSWER) && (dir != DIR_REQUEST) )
+        return false;
+
+    rule.dir = (RuleDir) dir;
+    rule.id = id;
+    rule.types = 0;
+    JsonArray jtypes = jr[F("types")];
+    if (jtypes.isNull())
+        rule.types = 0xFF;
+    for (JsonVariant jt: jtypes) {
+        const int t = findName(TYPE_NAMES, jt.as<const char*>(), -1);
+        if (t < 0)
+            return false;
+        rule.types |= 1 << t;
+    }
+    rule.mask = getHex(jr[F("mask")], 0);
+    rule.match = getHex(jr[F("match")], 0) & rule.mask;
+    rule.cond = (RuleCond) cond;
+    rule.action = (RuleAction) action;
+    rule.source = (action == ACT_REPLACE) ? SRC_NONE : (RuleSource) source;
+    rule.value = getHex(jr[F("data")], 0);
+    rule.dataMask = getHex(jr[F("dataMask")], 0xFFFF);
+    rule.msgType = msgType;
+    rule.builtin = false;
+    rule.hits = 0;
+    return true;
+}
+
+/**
+ * groups the rules by direction and ID, config rules before the built-in ones,
+ * keeping their order otherwise
+ */
+void OTRules::compile() {
+    auto after = [](const Rule &a, const Rule &b) {
+        if (a.dir != b.dir)
+            return a.dir > b.dir;
+        if (a.id != b.id)
+            return a.id > b.id;
+        return a.builtin && !b.builtin;
+    };
+
+    for (uint8_t i=1; i<numRules; i++) {
+        const Rule r = rules[i];
+        int8_t j = i - 1;
+        while ( (j >= 0) && after(rules[j], r) ) {
+            rules[j + 1] = rules[j];
+            j--;
+        }
+        rules[j + 1] = r;
+    }
+
+    memset(table, 0, sizeof(table));
+    for (uint8_t i=0; i<numRules; i++) {
+        auto &entry = table[rules[i].dir][rules[i].id];
+        if (entry.num == 0)
+            entry.first = i;
+        entry.num++;
+    }
+}
+
+/**
+ * Config rules first, followed by the built-in overrides. Called from the OT task.
+ */
+void OTRules::setConfig(JsonArray config) {
+    static const Rule BUILTIN[] = {
+    //  dir             ID                                                  types                                       mask    match   cond                action          source          value   dataMask    msgType                                         builtin hits
+        {DIR_REQUEST,   (uint8_t) OpenThermMessageID::TSet,                 typeBit(OpenThermMessageType::WRITE_DATA),  0,      0,      COND_OVERRIDE_CH1,  ACT_COMPUTE,    SRC_FLOW1,      0,      0xFFFF,     NO_TYPE,                                        true,   0},
+        {DIR_REQUEST,   (uint8_t) OpenThermMessageID::TsetCH2,              typeBit(OpenThermMessageType::WRITE_DATA),  0,      0,      COND_OVERRIDE_CH2,  ACT_COMPUTE,    SRC_FLOW2,      0,      0xFFFF,     NO_TYPE,                                        true,   0},
+        {DIR_REQUEST,   (uint8_t) OpenThermMessageID::TdhwSet,              typeBit(OpenThermMessageType::WRITE_DATA),  0,      0,      COND_OVERRIDE_DHW,  ACT_COMPUTE,    SRC_DHW_SET,    0,      0xFFFF,     NO_TYPE,                                        true,   0},
+        {DIR_REQUEST,   (uint8_t) OpenThermMessageID::Status,               0xFF,                                       0,      0,      COND_ALWAYS,        ACT_COMPUTE,    SRC_STATUS,     0,      0xFFFF,     (uint8_t) OpenThermMessageType::READ_DATA,      true,   0},
+        {DIR_RESPONSE,  (uint8_t) OpenThermMessageID::Toutside,             0xFF,                                       0,      0,      COND_OUTSIDE_LOCAL, ACT_COMPUTE,    SRC_OUTSIDE,    0,      0xFFFF,     (uint8_t) OpenThermMessageType::READ_ACK,       true,   0},
+        // room unit tried to read the DHW set point, make it write the set point instead
+        {DIR_RESPONSE,  (uint8_t) OpenThermMessageID::TdhwSet,              typeBit(OpenThermMessageType::READ_ACK),    0,      0,      COND_OVERRIDE_DHW,  ACT_REPLACE,    SRC_NONE,       0,      0xFFFF,     (uint8_t) OpenThermMessageType::DATA_INVALID,   true,   0}
+    };
+
+    numRules = 0;
+    numDropped = 0;
+    for (const Rule &r: BUILTIN)
+        add(r);
+
+    // slots of the built-in rules are taken, compile() puts the config rules before them
+    for (JsonObject jr: config) {
+        Rule rule;
+        if (parseRule(jr, rule))
+            add(rule);
+        else
+            numDropped++;
+    }
+    if (numDropped)
+        log_w("%u repeater rules dropped (invalid or more than %u per ID / %u in total)", numDropped, MAX_PER_ID, MAX_RULES);
+
+    compile();
+    numFrames = 0;
+    evalAvg = 0;
+    evalMax = 0;
+}
+
+/**
+ * Applies the first matching rule to msg. Called from the OT task for every frame in repeater mode.
+ */
+OTRules::Result OTRules::apply(const RuleDir dir, unsigned long &msg) {
+    const uint32_t t0 = micros();
+    const uint8_t id = (uint8_t) OpenTherm::getDataID(msg);
+    const uint8_t mt = (uint8_t) OpenTherm::getMessageType(msg);
+    const uint16_t data = msg & 0xFFFF;
+    const auto &entry = table[dir][id];
+    Result res = RES_FORWARD;
+
+    for (uint8_t i=entry.first; i<entry.first + entry.num; i++) {
+        Rule &r = rules[i];
+        if ( !(r.types & (1 << mt)) || ((data & r.mask) != r.match) )
+            continue;
+
+        if ( (r.cond != COND_ALWAYS) && !(condFunc && condFunc(r.cond)) )
+            continue;
+
+        uint16_t newData = (data & ~r.dataMask) | (r.value & r.dataMask);
+        if ( (r.source != SRC_NONE) && !(sourceFunc && sourceFunc(r.source, data, newData)) )
+            continue; // no value available
+
+        r.hits++;
+        uint8_t newType = (r.msgType != NO_TYPE) ? r.msgType : mt;
+        switch (r.action) {
+        case ACT_BLOCK:
+            res = RES_BLOCK;
+            break;
+
+        case ACT_ANSWER:
+            if (r.msgType == NO_TYPE)
+                newType = (uint8_t) ((mt == (uint8_t) OpenThermMessageType::WRITE_DATA) ? OpenThermMessageType::WRITE_ACK : OpenThermMessageType::READ_ACK);
+            msg = OpenTherm::buildResponse((OpenThermMessageType) newType, (OpenThermMessageID) id, newData);
+            res = RES_ANSWER;
+            break;
+
+        default:
+            if (dir == DIR_REQUEST)
+                msg = OpenTherm::buildRequest((OpenThermMessageType) newType, (OpenThermMessageID) id, newData);
+            else
+                msg = OpenTherm::buildResponse((OpenThermMessageType) newType, (OpenThermMessageID) id, newData);
+            break;
+        }
+        break;
+    }
+
+    const uint32_t dt = micros() - t0;
+    if (dt > evalMax)
+        evalMax = dt;
+    evalAvg += (dt - evalAvg) * ((numFrames < 100) ? 1.0f / (numFrames + 1) : 0.01f);
+    numFrames++;
+    return res;
+}
+
+void OTRules::getJson(JsonObject &obj) const {
+    obj[F("frames")] = numFrames;
+    obj[F("evalAvg")] = roundf(evalAvg * 10) / 10; // us
+    obj[F("evalMax")] = evalMax; // us
+    obj[F("dropped")] = numDropped;
+
+    JsonArray jrules = obj[F("rules")].to<JsonArray>();
+    for (uint8_t i=0; i<numRules; i++) {
+        const Rule &r = rules[i];
+        JsonObject jr = jrules.add<JsonObject>();
+        jr[F("dir")] = DIR_NAMES[r.dir];
+        jr[F("id")] = r.id;
+        jr[F("action")] = ACTION_NAMES[r.action];
+        if (r.builtin)
+            jr[F("builtin")] = true;
+        jr[F("hits")] = r.hits;
+    }
+}
+
+void OTRules::writeJson(JsonWriter &w) const {
+    w.add(PSTR("frames"), numFrames);
+    w.add(PSTR("evalAvg"), roundf(evalAvg * 10) / 10); // us
+    w.add(PSTR("evalMax"), evalMax); // us
+    w.add(PSTR("dropped"), numDropped);
+
+    w.beginArray(PSTR("rules"));
+    for (uint8_t i=0; i<numRules; i++) {
+        const Rule &r = rules[i];
+        w.beginObject();
+        w.add(PSTR("dir"), DIR_NAMES[r.dir]);
+        w.add(PSTR("id"), r.id);
+        w.add(PSTR("action"), ACTION_NAMES[r.action]);
+        if (r.builtin)
+            w.add(PSTR("builtin"), true);
+        w.add(PSTR("hits"), r.hits);
+        w.endObject();
+    }
+    w.endArray();
+}
@@ -0,0 +1,174 @@
+#include "otscheduler.h"
+
+// relative deadlines (ms after release) of the priority classes
+const uint32_t OTScheduler::DEADLINE[OTJob::PRIO_NUM] = {
+    200,    // PRIO_STATUS: released every 800 ms -> status at least every second
+    1000,   // PRIO_CONTROL
+    2000,   // PRIO_SETPOINT
+    5000,   // PRIO_SENSOR
+    15000,  // PRIO_INFO
+    30000,  // PRIO_COUNTER
+    120000  // PRIO_BACKGROUND
+};
+
+OTJob::OTJob(const Priority prio):
+        prio(prio) {
+}
+
+OTScheduler::OTScheduler() {
+    resetCounters();
+}
+
+void OTScheduler::add(OTJob *job) {
+    for (uint8_t i=0; i<numJobs; i++)
+        if (jobs[i] == job)
+            return;
+
+    if (numJobs < MAX_JOBS)
+        jobs[numJobs++] = job;
+}
+
+bool OTScheduler::next(unsigned long &request) {
+    const uint32_t now = millis();
+    bool skipped[MAX_JOBS] = {false};
+
+    if (now - windowStart >= LOAD_WINDOW) {
+        load = busyMicros / (LOAD_WINDOW * 1000.0f);
+        frameRate = windowFrames * 1000.0f / LOAD_WINDOW;
+        busyMicros = 0;
+        windowFrames = 0;
+        windowStart = now;
+    }
+
+    while (true) {
+        int8_t best = -1;
+        uint32_t bestDeadline = 0;
+
+        for (uint8_t i=0; i<numJobs; i++) {
+            if (skipped[i])
+                continue;
+
+            OTJob *job = jobs[i];
+            uint32_t release;
+            if (!job->getRelease(now, release))
+                continue;
+
+            if ((int32_t) (now - release) < 0)
+                continue; // not due yet
+
+            const uint32_t deadline = release + DEADLINE[job->prio];
+            if ( (best < 0) ||
+                 ((int32_t) (deadline - bestDeadline) < 0) ||
+                 ((deadline == bestDeadline) && (job->prio < jobs[best]->prio)) ) {
+                best = i;
+                bestDeadline = deadline;
+            }
+        }
+
+        if (best < 0)
+            return false;
+
+        OTJob *job = jobs[best];
+        if (!job->getRequest(request)) {
+            // due, but nothing to send right now (e.g. no sensor value yet)
+            skipped[best] = true;
+            continue;
+        }
+
+        if ((int32_t) (now - bestDeadline) > 0) {
+            const uint32_t lateness = now - bestDeadline;
+            job->numMissed++;
+            numMissed++;
+            if (lateness > maxLateness)
+                maxLateness = lateness;
+            if (lateness > maxLatenessPrio[job->prio])
+                maxLatenessPrio[job->prio] = lateness;
+        }
+
+        job->numSent++;
+        numSent++;
+        job->onSent(now);
+        return true;
+    }
+}
+
+void OTScheduler::onTx() {
+    txMicros = micros();
+    busy = true;
+}
+
+void OTScheduler::onRx() {
+    if (!busy)
+        return;
+
+    busy = false;
+    const uint32_t slot = micros() - txMicros;
+    busyMicros += slot;
+    windowFrames++;
+
+    if (avgSlot == 0)
+        avgSlot = slot / 1000.0f;
+    else
+        avgSlot = 0.95f * avgSlot + 0.05f * (slot / 1000.0f);
+}
+
+void OTScheduler::resetCounters() {
+    numSent = 0;
+    numMissed = 0;
+    maxLateness = 0;
+    memset(maxLatenessPrio, 0, sizeof(maxLatenessPrio));
+    for (uint8_t i=0; i<numJobs; i++) {
+        jobs[i]->numSent = 0;
+        jobs[i]->numMissed = 0;
+    }
+}
+
+/**
+ * Bus utilization requested by all active periodic jobs (sum of slot / period).
+ * Below 1.0 every job gets its share of the bus, EDF then meets the deadlines
+ * as long as no job waits for more than one frame in progress.
+ */
+float OTScheduler::getDemand() {
+    const uint32_t now = millis();
+    float demand = 0;
+
+    for (uint8_t i=0; i<numJobs; i++) {
+        uint32_t release;
+        const uint32_t period = jobs[i]->getPeriod();
+        if ( (period > 0) && jobs[i]->getRelease(now, release) )
+            demand += avgSlot / period;
+    }
+    return demand;
+}
+
+void OTScheduler::getJson(JsonObject &obj) {
+    obj[F("load")] = round(load * 1000) / 10; // %
+    obj[F("demand")] = round(getDemand() * 1000) / 10; // %
+    obj[F("frameRate")] = round(frameRate * 100) / 100; // frames / s
+    obj[F("avgSlot")] = round(avgSlot); // ms
+    obj[F("sent")] = numSent;
+    obj[F("missed")] = numMissed;
+    obj[F("maxLateness")] = maxLateness;
+
+    JsonArray jlate = obj[F("maxLatenessPrio")].to<JsonArray>();
+    for (uint8_t i=0; i<OTJob::PRIO_NUM; i++)
+        jlate.add(maxLatenessPrio[i]);
+}
+
+/**
+ * Same members as getJson(), added to the current object of w.
+ */
+void OTScheduler::writeJson(JsonWriter &w) {
+    w.add(PSTR("load"), (float) (round(load * 1000) / 10)); // %
+    w.add(PSTR("demand"), (float) (round(getDemand() * 1000) / 10)); // %
+    w.add(PSTR("frameRate"), (float) (round(frameRate * 100) / 100)); // frames / s
+    w.add(PSTR("avgSlot"), (float) round(avgSlot)); // ms
+    w.add(PSTR("sent"), numSent);
+    w.add(PSTR("missed"), numMissed);
+    w.add(PSTR("maxLateness"), maxLateness);
+
+    w.beginArray(PSTR("maxLatenessPrio"));
+    for (uint8_t i=0; i<OTJob::PRIO_NUM; i++)
+        w.add(nullptr, maxLatenessPrio[i]);
+    w.endArray();
+}
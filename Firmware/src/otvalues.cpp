@@ -2,324 +2,393 @@
 #include "otvalues.h"
 #include "otcontrol.h"
 #include "mqtt.h"
+#include "otdata.h"
+#include <array>
+#include <tuple>
+#include <utility>
 
-struct OTItem {
-    OpenThermMessageID id;
-    const char* name;
-    const char* haName {nullptr};
-    static const char* getName(OpenThermMessageID id);
-};
+static const uint32_t ONESHOT_RETRY = 10000; // ms
+static const uint16_t MAX_POLL_INTERVAL = 900; // s, upper limit of adaptive polling
+
+bool OTValue::adaptivePolling = false;
+
+constexpr uint16_t floatToOT(double f) {
+    return (((int) f) << 8) | (int) ((f - (int) f) * 256);
+}
+
+constexpr uint16_t nib(uint8_t hb, uint8_t lb) {
+    return (hb << 8) | lb;
+}
 
-static const OTItem OTITEMS[] PROGMEM = {
-//  ID of message                                   string id for MQTT                  
-    {OpenThermMessageID::Status,                    PSTR("status")},
-    {OpenThermMessageID::TSet,                      PSTR("ch_set_t")},
-    {OpenThermMessageID::MConfigMMemberIDcode,      PSTR("master_config_member")},
-    {OpenThermMessageID::SConfigSMemberIDcode,      PSTR("slave_config_member")},
-    {OpenThermMessageID::ASFflags,                  PSTR("fault_flags")},
-    {OpenThermMessageID::RBPflags,                  PSTR("rp_flags")},
-    {OpenThermMessageID::TsetCH2,                   PSTR("ch_set_t2")},
-    {OpenThermMessageID::TrOverride,                PSTR("tr_override")},
-    {OpenThermMessageID::MaxRelModLevelSetting,     PSTR("max_rel_mod")},
-    {OpenThermMessageID::MaxCapacityMinModLevel,    PSTR("max_cap_min_mod")},
-    {OpenThermMessageID::TrSet,                     PSTR("room_set_t")},
-    {OpenThermMessageID::RelModLevel,               PSTR("rel_mod")},
-    {OpenThermMessageID::CHPressure,                PSTR("ch_pressure")},
-    {OpenThermMessageID::DHWFlowRate,               PSTR("dhw_flow_rate")},
-    {OpenThermMessageID::DayTime,                   PSTR("day_time")},
-    {OpenThermMessageID::Date,                      PSTR("date")},
-    {OpenThermMessageID::Year,                      PSTR("year")},
-    {OpenThermMessageID::TrSetCH2,                  PSTR("room_set_t2")},
-    {OpenThermMessageID::Tr,                        PSTR("room_t")},
-    {OpenThermMessageID::Tboiler,                   PSTR("flow_t")},
-    {OpenThermMessageID::Tdhw,                      PSTR("dhw_t")},
-    {OpenThermMessageID::Toutside,                  PSTR("outside_t")},
-    {OpenThermMessageID::Tret,                      PSTR("return_t")},
-    {OpenThermMessageID::TflowCH2,                  PSTR("flow_t2")},
-    {OpenThermMessageID::Tdhw2,                     PSTR("dhw_t2")},
-    {OpenThermMessageID::Texhaust,                  PSTR("exhaust_t")},
-    {OpenThermMessageID::TboilerHeatExchanger,      PSTR("boiler_heat_ex_t")},
-    {OpenThermMessageID::BoilerFanSpeedSetpointAndActual, PSTR("boiler_fan")},
-    {OpenThermMessageID::FlameCurrent,              PSTR("flame_current")},
-    {OpenThermMessageID::TrCH2,                     PSTR("room_t2")},
-    {OpenThermMessageID::TrOverride2,               PSTR("tr_override2")},           
-    {OpenThermMessageID::TdhwSetUBTdhwSetLB,        PSTR("dhw_bounds")},
-    {OpenThermMessageID::MaxTSetUBMaxTSetLB,        PSTR("ch_bounds")},
-    {OpenThermMessageID::TdhwSet,                   PSTR("dhw_set_t")},
-    {OpenThermMessageID::StatusVentilationHeatRecovery, PSTR("vent_status")},
-    {OpenThermMessageID::Vset,                      PSTR("rel_vent_set")},
-    {OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery, PSTR("vent_fault_flags")},
-    {OpenThermMessageID::OpenThermVersionVentilationHeatRecovery,   PSTR("vent_ot_version")},
-    {OpenThermMessageID::VentilationHeatRecoveryVersion,    PSTR("vent_prod_version")},
-    {OpenThermMessageID::RelVentLevel,              PSTR("rel_vent")},
-    {OpenThermMessageID::RHexhaust,                 PSTR("rel_hum_exhaust")},
-    {OpenThermMessageID::CO2exhaust,                PSTR("co2_exhaust")},
-    {OpenThermMessageID::Tsi,                       PSTR("supply_inlet_t")},
-    {OpenThermMessageID::Tso,                       PSTR("supply_outlet_t")},
-    {OpenThermMessageID::Tei,                       PSTR("exhaust_inlet_t")},
-    {OpenThermMessageID::Teo,                       PSTR("exhaust_outlet_t")},
-    {OpenThermMessageID::RPMexhaust,                PSTR("exhaust_fan_speed")},
-    {OpenThermMessageID::RPMsupply,                 PSTR("supply_fan_speed")},
-    {OpenThermMessageID::RemoteOverrideFunction,    PSTR("remote_override_function")},
-    {OpenThermMessageID::UnsuccessfulBurnerStarts,  PSTR("unsuccessful_burner_starts")},
-    {OpenThermMessageID::FlameSignalTooLowNumber,   PSTR("num_flame_signal_low")},
-    {OpenThermMessageID::OEMDiagnosticCode,         PSTR("oem_diag_code")},
-    {OpenThermMessageID::SuccessfulBurnerStarts,    PSTR("burner_starts")},
-    {OpenThermMessageID::CHPumpStarts,              PSTR("ch_pump_starts")},
-    {OpenThermMessageID::BurnerOperationHours,      PSTR("burner_op_hours")},
-    {OpenThermMessageID::DHWBurnerOperationHours,   PSTR("dhw_burner_op_hours")},
-    {OpenThermMessageID::OpenThermVersionMaster,    PSTR("master_ot_version")},
-    {OpenThermMessageID::OpenThermVersionSlave,     PSTR("slave_ot_version")},
-    {OpenThermMessageID::MasterVersion,             PSTR("master_prod_version")},
-    {OpenThermMessageID::SlaveVersion,              PSTR("slave_prod_version")}
+using enum OTJob::Priority;
+
+/*
+    Message catalogue: one row per data ID and direction. The value objects are
+    created from it in static storage (see OTValueStore below).
+*/
+static constexpr OTItem OTITEMS[] = {
+//  ID of message                                   decoder                         direction           intv prio           string id for MQTT              loopback test data                      HA discovery
+    {OpenThermMessageID::SConfigSMemberIDcode,      OTDEC_SLAVE_CONFIG,             OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("slave_config_member"),    0x2501}, // DHW present, cooling present, CH2 present
+    {OpenThermMessageID::OpenThermVersionSlave,     OTDEC_PRODUCT_VERSION,          OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("slave_ot_version"),       nib(2, 2),          HATYPE_SENSOR,      PSTR("OT-version slave")},
+    {OpenThermMessageID::SlaveVersion,              OTDEC_PRODUCT_VERSION,          OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("slave_prod_version"),     nib(4, 4),          HATYPE_SENSOR,      PSTR("productversion slave")},
+    {OpenThermMessageID::Status,                    OTDEC_STATUS,                   OTDIR_SLAVE,        -1, PRIO_INFO,      PSTR("status"),                 0x000E},
+    {OpenThermMessageID::StatusVentilationHeatRecovery, OTDEC_VENT_STATUS,          OTDIR_SLAVE,        -1, PRIO_INFO,      PSTR("vent_status"),            0x001E},
+    {OpenThermMessageID::MaxCapacityMinModLevel,    OTDEC_CAPACITY_MODULATION,      OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("max_cap_min_mod"),        nib(20, 5)}, // 20 kW / 5 %
+    {OpenThermMessageID::TdhwSetUBTdhwSetLB,        OTDEC_DHW_BOUNDS,               OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("dhw_bounds"),             nib(60, 40)}, // 60 °C upper bound, 40 C° lower bound
+    {OpenThermMessageID::MaxTSetUBMaxTSetLB,        OTDEC_CH_BOUNDS,                OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("ch_bounds"),              nib(60, 25)}, // 60 °C upper bound, 20 C° lower bound
+    {OpenThermMessageID::TrOverride,                OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("tr_override"),            0,                  HATYPE_TEMP,        PSTR("room setpoint override")},
+    {OpenThermMessageID::RelModLevel,               OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("rel_mod"),                floatToOT(33.3),    HATYPE_POWERFACTOR, PSTR("rel. modulation")},
+    {OpenThermMessageID::CHPressure,                OTDEC_FLOAT,                    OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("ch_pressure"),            floatToOT(1.25),    HATYPE_PRESSURE,    PSTR("CH pressure")},
+    {OpenThermMessageID::DHWFlowRate,               OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("dhw_flow_rate"),          floatToOT(2.4),     HATYPE_SENSOR,      PSTR("flow rate"),          PSTR("L/min"),  PSTR("volume_flow_rate")},
+    {OpenThermMessageID::Tboiler,                   OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("flow_t"),                 floatToOT(48.5),    HATYPE_TEMP,        PSTR("flow temp.")},
+    {OpenThermMessageID::TflowCH2,                  OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("flow_t2"),                floatToOT(48.6),    HATYPE_TEMP,        PSTR("flow temp. 2")},
+    {OpenThermMessageID::Tdhw,                      OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("dhw_t"),                  floatToOT(37.5),    HATYPE_TEMP,        PSTR("DHW temperature")},
+    {OpenThermMessageID::Tdhw2,                     OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("dhw_t2"),                 floatToOT(37.6),    HATYPE_TEMP,        PSTR("DHW temperature 2")},
+    {OpenThermMessageID::Toutside,                  OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("outside_t"),              floatToOT(3.5),     HATYPE_TEMP,        PSTR("outside temp.")},
+    {OpenThermMessageID::Tret,                      OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("return_t"),               floatToOT(41.7),    HATYPE_TEMP,        PSTR("return temp.")},
+    {OpenThermMessageID::Texhaust,                  OTDEC_I16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("exhaust_t"),              90,                 HATYPE_TEMP,        PSTR("exhaust temp.")},
+    {OpenThermMessageID::TrOverride2,               OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("tr_override2"),           0,                  HATYPE_TEMP,        PSTR("room setpoint 2 override")},
+    {OpenThermMessageID::OpenThermVersionVentilationHeatRecovery, OTDEC_PRODUCT_VERSION, OTDIR_SLAVE,   0,  PRIO_INFO,      PSTR("vent_ot_version"),        0x0105,             HATYPE_SENSOR,      PSTR("OT-version slave")},
+    {OpenThermMessageID::VentilationHeatRecoveryVersion, OTDEC_PRODUCT_VERSION,     OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("vent_prod_version"),      0x0107,             HATYPE_SENSOR,      PSTR("productversion slave")},
+    {OpenThermMessageID::RelVentLevel,              OTDEC_U16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("rel_vent"),               55,                 HATYPE_SENSOR,      PSTR("rel. ventilation")}, // relative ventilation 0..100 %
+    {OpenThermMessageID::RHexhaust,                 OTDEC_U16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("rel_hum_exhaust"),        45,                 HATYPE_SENSOR,      PSTR("humidity exhaust"),   PSTR("%"),      PSTR("humidity")},
+    {OpenThermMessageID::CO2exhaust,                OTDEC_U16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("co2_exhaust"),            1450,               HATYPE_SENSOR,      PSTR("CO2 exhaust"),        PSTR("ppm"),    PSTR("carbon_dioxide")},
+    {OpenThermMessageID::Tsi,                       OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("supply_inlet_t"),         floatToOT(22.1),    HATYPE_TEMP,        PSTR("supply inlet temp.")},
+    {OpenThermMessageID::Tso,                       OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("supply_outlet_t"),        floatToOT(22.2),    HATYPE_TEMP,        PSTR("supply outlet temp.")},
+    {OpenThermMessageID::Tei,                       OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("exhaust_inlet_t"),        floatToOT(22.3),    HATYPE_TEMP,        PSTR("exhaust inlet temp.")},
+    {OpenThermMessageID::Teo,                       OTDEC_FLOAT,                    OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("exhaust_outlet_t"),       floatToOT(22.1),    HATYPE_TEMP,        PSTR("exhaust outlet temp.")},
+    {OpenThermMessageID::RPMexhaust,                OTDEC_U16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("exhaust_fan_speed"),      2300,               HATYPE_SENSOR,      PSTR("exhaust fan speed")},
+    {OpenThermMessageID::RPMsupply,                 OTDEC_U16,                      OTDIR_SLAVE,        10, PRIO_SENSOR,    PSTR("supply_fan_speed"),       2400,               HATYPE_SENSOR,      PSTR("supply fan speed")},
+    {OpenThermMessageID::UnsuccessfulBurnerStarts,  OTDEC_U16,                      OTDIR_SLAVE,        30, PRIO_COUNTER,   PSTR("unsuccessful_burner_starts"), 19,             HATYPE_SENSOR,      PSTR("failed burnerstarts")},
+    {OpenThermMessageID::FlameSignalTooLowNumber,   OTDEC_U16,                      OTDIR_SLAVE,        30, PRIO_COUNTER,   PSTR("num_flame_signal_low"),   4,                  HATYPE_SENSOR,      PSTR("Flame sig low")},
+    {OpenThermMessageID::OEMDiagnosticCode,         OTDEC_U16,                      OTDIR_SLAVE,        60, PRIO_INFO,      PSTR("oem_diag_code"),          123,                HATYPE_SENSOR,      PSTR("OEM diagnostic code")},
+    {OpenThermMessageID::SuccessfulBurnerStarts,    OTDEC_U16,                      OTDIR_SLAVE,        30, PRIO_COUNTER,   PSTR("burner_starts"),          9999,               HATYPE_SENSOR,      PSTR("burnerstarts")},
+    {OpenThermMessageID::CHPumpStarts,              OTDEC_U16,                      OTDIR_SLAVE,        30, PRIO_COUNTER,   PSTR("ch_pump_starts"),         7777},
+    {OpenThermMessageID::BurnerOperationHours,      OTDEC_U16,                      OTDIR_SLAVE,        120, PRIO_COUNTER,  PSTR("burner_op_hours"),        8888,               HATYPE_HOURS,       PSTR("operating hours")},
+    {OpenThermMessageID::DHWBurnerOperationHours,   OTDEC_U16,                      OTDIR_SLAVE,        120, PRIO_COUNTER,  PSTR("dhw_burner_op_hours"),    196,                HATYPE_HOURS,       PSTR("operating hours DHW")},
+    {OpenThermMessageID::ASFflags,                  OTDEC_FAULT_FLAGS,              OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("fault_flags"),            0x0000}, // no error flags, oem error code 0
+    {OpenThermMessageID::RBPflags,                  OTDEC_REMOTE_PARAMETER,         OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("rp_flags"),               0x0101},
+    {OpenThermMessageID::RemoteOverrideFunction,    OTDEC_REMOTE_OVERRIDE_FUNCTION, OTDIR_SLAVE,        0,  PRIO_INFO,      PSTR("remote_override_function"), 0x0000},
+    {OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery, OTDEC_VENT_FAULT_FLAGS, OTDIR_SLAVE, 30, PRIO_INFO, PSTR("vent_fault_flags"),       0x0F33},
+    {OpenThermMessageID::ASFflagsOEMfaultCodeSolarStorage, OTDEC_U16,             OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("solar_fault_flags"),      0x0000},
+    {OpenThermMessageID::TboilerHeatExchanger,      OTDEC_FLOAT,                    OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("boiler_heat_ex_t"),       floatToOT(48.5),    HATYPE_TEMP,        PSTR("Heat exchange temp.")},
+    {OpenThermMessageID::BoilerFanSpeedSetpointAndActual, OTDEC_BOILER_FAN_SPEED,   OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("boiler_fan"),             nib(20, 21)},
+    {OpenThermMessageID::FlameCurrent,              OTDEC_FLOAT,                    OTDIR_SLAVE,        30, PRIO_INFO,      PSTR("flame_current"),          floatToOT(96.8),    HATYPE_SENSOR,      PSTR("Flame current"),      PSTR("µA"),     PSTR("current")},
+
+    {OpenThermMessageID::TSet,                      OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("ch_set_t"),               -1,                 HATYPE_TEMP,        PSTR("flow set temp.")},
+    {OpenThermMessageID::TsetCH2,                   OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("ch_set_t2")},
+    {OpenThermMessageID::Tr,                        OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("room_t")},
+    {OpenThermMessageID::TrCH2,                     OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("room_t2")},
+    {OpenThermMessageID::TrSet,                     OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("room_set_t")},
+    {OpenThermMessageID::TrSetCH2,                  OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("room_set_t2")},
+    {OpenThermMessageID::MasterVersion,             OTDEC_PRODUCT_VERSION,          OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("master_prod_version"),    -1,                 HATYPE_SENSOR,      PSTR("productversion master")},
+    {OpenThermMessageID::MaxRelModLevelSetting,     OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("max_rel_mod")},
+    {OpenThermMessageID::OpenThermVersionMaster,    OTDEC_PRODUCT_VERSION,          OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("master_ot_version"),      -1,                 HATYPE_SENSOR,      PSTR("OT-version master")},
+    {OpenThermMessageID::MConfigMMemberIDcode,      OTDEC_MASTER_CONFIG,            OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("master_config_member")},
+    {OpenThermMessageID::TdhwSet,                   OTDEC_FLOAT,                    OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("dhw_set_t")},
+    {OpenThermMessageID::Status,                    OTDEC_MASTER_STATUS,            OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("status")},
+    {OpenThermMessageID::StatusVentilationHeatRecovery, OTDEC_VENT_MASTER_STATUS,   OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("vent_status")},
+    {OpenThermMessageID::DayTime,                   OTDEC_DAY_TIME,                 OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("day_time")},
+    {OpenThermMessageID::Date,                      OTDEC_DATE,                     OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("date")},
+    {OpenThermMessageID::Year,                      OTDEC_U16,                      OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("year")},
+    {OpenThermMessageID::Vset,                      OTDEC_U16,                      OTDIR_THERMOSTAT,   -1, PRIO_INFO,      PSTR("rel_vent_set")},
 };
 
-OTValue *slaveValues[45] = { // reply data collected (read) from slave (boiler / ventilation / solar)
-    new OTValueSlaveConfigMember(),
-    new OTValueProductVersion(  OpenThermMessageID::OpenThermVersionSlave,      0, PSTR("OT-version slave")),
-    new OTValueProductVersion(  OpenThermMessageID::SlaveVersion,               0, PSTR("productversion slave")),
-    new OTValueStatus(),
-    new OTValueVentStatus(),
-    new OTValueCapacityModulation(),
-    new OTValueDHWBounds(),
-    new OTValueCHBounds(),
-    new OTValueFloatTemp(       OpenThermMessageID::TrOverride,                 PSTR("room setpoint override")),
-    new OTValueFloat(           OpenThermMessageID::RelModLevel,                10),
-    new OTValueFloat(           OpenThermMessageID::CHPressure,                 30),
-    new OTValueFloat(           OpenThermMessageID::DHWFlowRate,                10),
-    new OTValueFloatTemp(       OpenThermMessageID::Tboiler,                    PSTR("flow temp.")),
-    new OTValueFloatTemp(       OpenThermMessageID::TflowCH2,                   PSTR("flow temp. 2")),
-    new OTValueFloatTemp(       OpenThermMessageID::Tdhw,                       PSTR("DHW temperature")),
-    new OTValueFloatTemp(       OpenThermMessageID::Tdhw2,                      PSTR("DHW temperature 2")),
-    new OTValueFloatTemp(       OpenThermMessageID::Toutside,                   PSTR("outside temp.")),
-    new OTValueFloatTemp(       OpenThermMessageID::Tret,                       PSTR("return temp.")),
-    new OTValuei16(             OpenThermMessageID::Texhaust,                   10),
-    new OTValueFloatTemp(       OpenThermMessageID::TrOverride2,                PSTR("room setpoint 2 override")),
-    new OTValueProductVersion(  OpenThermMessageID::OpenThermVersionVentilationHeatRecovery,    0, PSTR("OT-version slave")),
-    new OTValueProductVersion(  OpenThermMessageID::VentilationHeatRecoveryVersion,             0, PSTR("productversion slave")),
-    new OTValueu16(             OpenThermMessageID::RelVentLevel,               10),
-    new OTValueu16(             OpenThermMessageID::RHexhaust,                  10),
-    new OTValueu16(             OpenThermMessageID::CO2exhaust,                 10),
-    new OTValueFloatTemp(       OpenThermMessageID::Tsi,                        PSTR("supply inlet temp.")),
-    new OTValueFloatTemp(       OpenThermMessageID::Tso,                        PSTR("supply outlet temp.")),
-    new OTValueFloatTemp(       OpenThermMessageID::Tei,                        PSTR("exhaust inlet temp.")),
-    new OTValueFloatTemp(       OpenThermMessageID::Teo,                        PSTR("exhaust outlet temp.")),
-    new OTValueu16(             OpenThermMessageID::RPMexhaust,                 10),
-    new OTValueu16(             OpenThermMessageID::RPMsupply,                  10),
-    new OTValueu16(             OpenThermMessageID::UnsuccessfulBurnerStarts,   30),
-    new OTValueu16(             OpenThermMessageID::FlameSignalTooLowNumber,    30),
-    new OTValueu16{             OpenThermMessageID::OEMDiagnosticCode,          60},
-    new OTValueu16(             OpenThermMessageID::SuccessfulBurnerStarts,     30),
-    new OTValueu16(             OpenThermMessageID::CHPumpStarts,               30),
-    new OTValueu16(             OpenThermMessageID::BurnerOperationHours,       120),
-    new OTValueu16(             OpenThermMessageID::DHWBurnerOperationHours,    120),
-    new OTValueFaultFlags(                                                      30),
-    new OTValueRemoteParameter(),
-    new OTValueRemoteOverrideFunction(),
-    new OTValueVentFaultFlags(                                                  30),
-    new OTValueHeatExchangerTemp(),
-    new OTValueBoilerFanSpeed(),
-    new OTValueFlameCurrent(),
+static constexpr size_t NUM_OTITEMS = sizeof(OTITEMS) / sizeof(OTITEMS[0]);
+
+static constexpr bool checkOTItems() {
+    for (size_t i=0; i<NUM_OTITEMS; i++) {
+        if ( (OTITEMS[i].dir == OTDIR_THERMOSTAT) && (OTITEMS[i].loopback >= 0) )
+            return false; // loopback data is sent by slave only
+        for (size_t j=i+1; j<NUM_OTITEMS; j++)
+            if ( (OTITEMS[i].id == OTITEMS[j].id) && (OTITEMS[i].dir == OTITEMS[j].dir) )
+                return false;
+    }
+    return true;
+}
+static_assert(checkOTItems(), "OTITEMS: duplicate ID / direction or loopback data for thermostat value");
+
+// the generic discovery uses {{ value_json.<dir>.<name> }}, valid for values serialized as a scalar only
+static constexpr bool checkHATypes() {
+    for (size_t i=0; i<NUM_OTITEMS; i++) {
+        if (OTITEMS[i].haType == HATYPE_NONE)
+            continue;
+        switch (OTITEMS[i].decoder) {
+        case OTDEC_U16:
+        case OTDEC_I16:
+        case OTDEC_FLOAT:
+        case OTDEC_PRODUCT_VERSION:
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(checkHATypes(), "OTITEMS: HA discovery for a value not serialized as a scalar");
+
+// value class of each decoder
+template<OTDecoder D> struct OTValueClass;
+template<> struct OTValueClass<OTDEC_U16>                       { typedef OTValueu16 type; };
+template<> struct OTValueClass<OTDEC_I16>                       { typedef OTValuei16 type; };
+template<> struct OTValueClass<OTDEC_FLOAT>                     { typedef OTValueFloat type; };
+template<> struct OTValueClass<OTDEC_PRODUCT_VERSION>           { typedef OTValueProductVersion type; };
+template<> struct OTValueClass<OTDEC_STATUS>                    { typedef OTValueStatus type; };
+template<> struct OTValueClass<OTDEC_MASTER_STATUS>             { typedef OTValueMasterStatus type; };
+template<> struct OTValueClass<OTDEC_VENT_STATUS>               { typedef OTValueVentStatus type; };
+template<> struct OTValueClass<OTDEC_VENT_MASTER_STATUS>        { typedef OTValueVentMasterStatus type; };
+template<> struct OTValueClass<OTDEC_SLAVE_CONFIG>              { typedef OTValueSlaveConfigMember type; };
+template<> struct OTValueClass<OTDEC_MASTER_CONFIG>             { typedef OTValueMasterConfig type; };
+template<> struct OTValueClass<OTDEC_FAULT_FLAGS>               { typedef OTValueFaultFlags type; };
+template<> struct OTValueClass<OTDEC_VENT_FAULT_FLAGS>          { typedef OTValueVentFaultFlags type; };
+template<> struct OTValueClass<OTDEC_REMOTE_PARAMETER>          { typedef OTValueRemoteParameter type; };
+template<> struct OTValueClass<OTDEC_REMOTE_OVERRIDE_FUNCTION>  { typedef OTValueRemoteOverrideFunction type; };
+template<> struct OTValueClass<OTDEC_CAPACITY_MODULATION>       { typedef OTValueCapacityModulation type; };
+template<> struct OTValueClass<OTDEC_DHW_BOUNDS>                { typedef OTValueDHWBounds type; };
+template<> struct OTValueClass<OTDEC_CH_BOUNDS>                 { typedef OTValueCHBounds type; };
+template<> struct OTValueClass<OTDEC_DAY_TIME>                  { typedef OTValueDayTime type; };
+template<> struct OTValueClass<OTDEC_DATE>                      { typedef OTValueDate type; };
+template<> struct OTValueClass<OTDEC_BOILER_FAN_SPEED>          { typedef OTValueBoilerFanSpeed type; };
+
+// one value object per row of OTITEMS, in static storage
+template<typename Seq> struct OTValueStore;
+template<size_t... I> struct OTValueStore<std::index_sequence<I...>> {
+    std::tuple<typename OTValueClass<OTITEMS[I].decoder>::type...> values {OTITEMS[I]...};
+
+    static constexpr std::array<OTValue*, NUM_OTITEMS> getPointers(OTValueStore &store) {
+        return {{ &std::get<I>(store.values)... }};
+    }
 };
 
+static OTValueStore<std::make_index_sequence<NUM_OTITEMS>> valueStore;
+static constexpr std::array<OTValue*, NUM_OTITEMS> OTVALUES = valueStore.getPointers(valueStore);
+
+template<OTDirection DIR>
+static constexpr size_t countValues() {
+    size_t n = 0;
+    for (const auto &item: OTITEMS)
+        if (item.dir == DIR)
+            n++;
+    return n;
+}
 
-OTValue *thermostatValues[17] = { // request data sent (written) from roomunit
-    new OTValueFloat(           OpenThermMessageID::TSet,                   -1),
-    new OTValueFloat(           OpenThermMessageID::TsetCH2,                -1),
-    new OTValueFloat(           OpenThermMessageID::Tr,                     -1),
-    new OTValueFloat(           OpenThermMessageID::TrCH2,                  -1),
-    new OTValueFloat(           OpenThermMessageID::TrSet,                  -1),
-    new OTValueFloat(           OpenThermMessageID::TrSetCH2,               -1),
-    new OTValueProductVersion(  OpenThermMessageID::MasterVersion,          -1, PSTR("productversion master")),
-    new OTValueFloat(           OpenThermMessageID::MaxRelModLevelSetting,  -1),
-    new OTValueProductVersion(  OpenThermMessageID::OpenThermVersionMaster, -1, PSTR("OT-version master")),
-    new OTValueMasterConfig(),
-    new OTValueFloat(           OpenThermMessageID::TdhwSet,                -1),
-    new OTValueMasterStatus(),
-    new OTValueVentMasterStatus(),
-    new OTValueDayTime(),
-    new OTValueDate(),
-    new OTValueu16(             OpenThermMessageID::Year,                   -1),
-    new OTValueu16(             OpenThermMessageID::Vset,                   -1),
+template<OTDirection DIR>
+static constexpr std::array<OTValue*, countValues<DIR>()> filterValues() {
+    std::array<OTValue*, countValues<DIR>()> values {};
+    size_t n = 0;
+    for (size_t i=0; i<NUM_OTITEMS; i++)
+        if (OTITEMS[i].dir == DIR)
+            values[n++] = OTVALUES[i];
+    return values;
+}
+
+static constexpr auto SLAVEVALUES = filterValues<OTDIR_SLAVE>();
+static constexpr auto THERMOSTATVALUES = filterValues<OTDIR_THERMOSTAT>();
+
+const OTValueList slaveValues {SLAVEVALUES.data(), SLAVEVALUES.size()};
+const OTValueList thermostatValues {THERMOSTATVALUES.data(), THERMOSTATVALUES.size()};
+
+// OTITEMS / value objects indexed by data ID, so lookups in the rx path don't have to search
+struct OTIdInfo {
+    const char* name {nullptr};
+    int32_t loopback {-1};
+    OTValue *slave {nullptr};
+    OTValue *thermostat {nullptr};
 };
 
+static constexpr std::array<OTIdInfo, 256> buildIdTable() {
+    std::array<OTIdInfo, 256> table {};
+    for (size_t i=0; i<NUM_OTITEMS; i++) {
+        OTIdInfo &info = table[(uint8_t) OTITEMS[i].id];
+        info.name = OTITEMS[i].name;
+        if (OTITEMS[i].dir == OTDIR_SLAVE) {
+            info.slave = OTVALUES[i];
+            info.loopback = OTITEMS[i].loopback;
+        }
+        else
+            info.thermostat = OTVALUES[i];
+    }
+    return table;
+}
+
+static constexpr std::array<OTIdInfo, 256> OTIDTABLE = buildIdTable();
+
 const char* getOTname(OpenThermMessageID id) {
-    return OTItem::getName(id);
+    return OTIDTABLE[(uint8_t) id].name;
 }
 
-const char* OTItem::getName(OpenThermMessageID id) {
-    for (int i=0; i<sizeof(OTITEMS) / sizeof(OTITEMS[0]); i++)
-        if (OTITEMS[i].id == id)
-            return OTITEMS[i].name;
-    return nullptr;
+bool getOTloopback(OpenThermMessageID id, uint16_t &value) {
+    const int32_t lb = OTIDTABLE[(uint8_t) id].loopback;
+    if (lb < 0)
+        return false;
+
+    value = lb;
+    return true;
 }
 
-/**
- * @param interval -1: never query. 0: only query once. >0: query every interval seconds
- */
-OTValue::OTValue(const OpenThermMessageID id, const int interval):
-        id(id),
-        interval(interval),
+OTValue::OTValue(const OTItem &item):
+        OTJob(item.prio),
+        id(item.id),
+        interval(item.interval),
+        curInterval(max(item.interval, (int16_t) 0)),
+        minInterval(curInterval),
+        maxInterval(curInterval),
+        item(item),
         value(0),
-        enabled(interval != -1),
-        isSet(false),
-        discFlag(false) {
+        enabled(item.interval != -1),
+        discFlag(false),
+        isSet(false) {
 }
 
 OTValue* OTValue::getSlaveValue(const OpenThermMessageID id) {
-    for (auto *val: slaveValues) {
-        if (val->id == id) {
-            return val;
-        }
-    }
-    return nullptr;
+    return OTIDTABLE[(uint8_t) id].slave;
 }
 
 OTValue* OTValue::getThermostatValue(const OpenThermMessageID id) {
-    for (auto *val: thermostatValues) {
-        if (val->id == id) {
-            return val;
-        }
-    }
-    return nullptr;
+    return OTIDTABLE[(uint8_t) id].thermostat;
 }
 
-bool OTValue::process() {
+bool OTValue::getRelease(const uint32_t now, uint32_t &release) {
     if (!enabled || (interval == -1))
         return false;
 
     if (isSet && (interval == 0))
         return false;
 
-    if ((lastTransfer > 0) && ((millis() - lastTransfer) / 1000 < interval))
-        return false;
+    // in repeater mode the values read by the room unit are as fresh as a refresh
+    uint32_t last = lastTransfer;
+    if ( cached && (!queried || ((int32_t) (cachedAt - lastTransfer) > 0)) )
+        last = cachedAt;
+
+    if (!queried && !cached)
+        release = now;
+    else if (interval == 0)
+        release = last + ONESHOT_RETRY; // no reply yet, retry
+    else
+        release = last + curInterval * 1000UL;
 
-    unsigned long request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, id, value);
-    otcontrol.sendRequest('T', request);
-    lastTransfer = millis();
     return true;
 }
 
-OpenThermMessageID OTValue::getId() const {
-    return id;
+bool OTValue::getRequest(unsigned long &request) {
+    request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, id, value);
+    return true;
 }
 
-bool OTValue::sendDiscovery() {
-    const char *name = getName();
-    if (name == nullptr)
-        return false;
-
-    String sName = FPSTR(name);
+uint32_t OTValue::getPeriod() const {
+    return (interval > 0) ? curInterval * 1000UL : 0;
+}
 
-/* missing discoveries: 
-    {OpenThermMessageID::TrOverride,                PSTR("tr_override")},
-    {OpenThermMessageID::DayTime,                   PSTR("day_time")},
-    {OpenThermMessageID::Date,                      PSTR("date")},
-    {OpenThermMessageID::Year,                      PSTR("year")},
-    {OpenThermMessageID::TrCH2,                     PSTR("room_t2")},
-    {OpenThermMessageID::TrOverride2,               PSTR("tr_override2")},           
-    {OpenThermMessageID::TdhwSet,                   PSTR("dhw_set_t")},
-    {OpenThermMessageID::Vset,                      PSTR("rel_vent_set")},
-    {OpenThermMessageID::RemoteOverrideFunction,    PSTR("remote_override_function")},
-    {OpenThermMessageID::CHPumpStarts,              PSTR("ch_pump_starts")},
-*/
+/**
+ * Adaptive polling: halve the interval whenever the value changed, stretch it by
+ * a quarter while it stays constant. Bounded by minInterval and maxInterval.
+ */
+void OTValue::adaptInterval(const uint16_t newVal) {
+    if (!adaptivePolling || (interval <= 0) || !isSet)
+        return;
 
-    switch (id) {
-        case OpenThermMessageID::CO2exhaust:
-            haDisc.createSensor(F("CO2 exhaust"), sName);
-            haDisc.setUnit(F("ppm"));
-            haDisc.setDeviceClass(F("carbon_dioxide"));
-            break;
+    if (isChanged(newVal))
+        curInterval = max((uint16_t) (curInterval / 2), minInterval);
+    else
+        curInterval = min((uint16_t) (curInterval + max(curInterval / 4, 1)), maxInterval);
+}
 
-        case OpenThermMessageID::RelModLevel:
-            haDisc.createPowerFactorSensor(F("rel. modulation"), sName);
-            break;
+bool OTValue::isChanged(const uint16_t newVal) const {
+    return newVal != value;
+}
 
-        case OpenThermMessageID::CHPressure:
-            haDisc.createPressureSensor(F("CH pressure"), sName);
-            break;
+/**
+ * @param limits [min, max] polling interval in s, defaults to interval / 4 ... interval * 6
+ */
+void OTValue::setPollLimits(JsonVariant limits) {
+    if (interval <= 0)
+        return;
 
-        case OpenThermMessageID::RelVentLevel:
-            haDisc.createSensor(F("rel. ventilation"), sName);
-            break;
+    // read as int, a negative value must not wrap the uint16_t limits
+    const int minLimit = limits[0] | max(interval / 4, 2);
+    const int maxLimit = limits[1] | min(interval * 6, (int) MAX_POLL_INTERVAL);
+    minInterval = constrain(minLimit, 1, (int) MAX_POLL_INTERVAL);
+    maxInterval = constrain(maxLimit, (int) minInterval, (int) MAX_POLL_INTERVAL);
+    curInterval = adaptivePolling ? constrain(interval, minInterval, maxInterval) : interval;
+}
 
-        case OpenThermMessageID::RHexhaust:
-            haDisc.createSensor(F("humidity exhaust"), sName);
-            haDisc.setDeviceClass(F("humidity"));
-            haDisc.setUnit(F("%"));
-            break;
+/**
+ * config: {"adaptive": true, "limits": {"flow_t": [2, 30], "18": [60, 900], ...}}
+ * limits are keyed by value name or by data ID, the name takes precedence
+ */
+void OTValue::setPollConfig(JsonObject config) {
+    adaptivePolling = config[F("adaptive")] | false;
+    JsonObject limits = config[F("limits")];
+    for (auto *valobj: slaveValues) {
+        JsonVariant lim = limits[FPSTR(valobj->getName())];
+        if (lim.isNull())
+            lim = limits[String((int) valobj->getId())];
+        valobj->setPollLimits(lim);
+    }
+}
 
-        case OpenThermMessageID::RPMexhaust:
-            haDisc.createSensor(F("exhaust fan speed"), sName);
-            break;
+void OTValue::getPollJson(JsonObject &obj) const {
+    if (enabled && (interval > 0))
+        obj[FPSTR(getName())] = curInterval;
+}
 
-        case OpenThermMessageID::RPMsupply:
-            haDisc.createSensor(F("supply fan speed"), sName);
-            break;
+void OTValue::writePollJson(JsonWriter &w) const {
+    if (enabled && (interval > 0))
+        w.add(getName(), curInterval);
+}
 
-        case OpenThermMessageID::BurnerOperationHours:
-            haDisc.createHourDuration(F("operating hours"), sName);
-            break;
+void OTValue::onSent(const uint32_t now) {
+    lastTransfer = now;
+    queried = true;
+}
 
-        case OpenThermMessageID::DHWBurnerOperationHours:
-            haDisc.createHourDuration(F("operating hours DHW"), sName);
-            break;
+OpenThermMessageID OTValue::getId() const {
+    return id;
+}
 
-        case OpenThermMessageID::SuccessfulBurnerStarts:
-            haDisc.createSensor(F("burnerstarts"), sName);
-            break;
+bool OTValue::sendDiscovery() {
+    const char *name = getName();
+    if (name == nullptr)
+        return false;
 
-        case OpenThermMessageID::UnsuccessfulBurnerStarts:
-            haDisc.createSensor(F("failed burnerstarts"), sName);
-            break;
+    String sName = FPSTR(name);
+    String haName = FPSTR(item.haName);
 
-        case OpenThermMessageID::TSet:
-            haDisc.createTempSensor(F("flow set temp."), sName);
+    switch (item.haType) {
+        case HATYPE_SENSOR:
+            haDisc.createSensor(haName, sName);
             break;
 
-        case OpenThermMessageID::Texhaust:
-            haDisc.createTempSensor(F("exhaust temp."), sName);
+        case HATYPE_TEMP:
+            haDisc.createTempSensor(haName, sName);
             break;
 
-        case OpenThermMessageID::DHWFlowRate:
-            haDisc.createSensor(F("flow rate"), sName);
-            haDisc.setUnit(F("L/min"));
-            haDisc.setDeviceClass(F("volume_flow_rate"));
+        case HATYPE_POWERFACTOR:
+            haDisc.createPowerFactorSensor(haName, sName);
             break;
 
-        case OpenThermMessageID::FlameSignalTooLowNumber:
-            haDisc.createSensor(F("Flame sig low"), sName);
+        case HATYPE_PRESSURE:
+            haDisc.createPressureSensor(haName, sName);
             break;
 
-        case OpenThermMessageID::OEMDiagnosticCode:
-            haDisc.createSensor(F("OEM diagnostic code"), sName);
+        case HATYPE_HOURS:
+            haDisc.createHourDuration(haName, sName);
             break;
 
         default:
             return false;
     }
 
-    String valTempl = F("{{ value_json.thermostat.# }}");
-    for (auto *valobj: slaveValues) {
-        if (valobj == this) {
-            valTempl = F("{{ value_json.slave.# }}");
-            break;
-        }
-    }
-    valTempl.replace("#", sName);
-    haDisc.setValueTemplate(valTempl);
-        
-    return haDisc.publish();
+    if (item.haUnit != nullptr)
+        haDisc.setUnit(FPSTR(item.haUnit));
+    if (item.haDevClass != nullptr)
+        haDisc.setDeviceClass(FPSTR(item.haDevClass));
+
+    return sendDiscovery("");
 }
 
 bool OTValue::sendDiscovery(String field, const bool addBaseName) {
-    bool inSlave = false;
-    for (auto *valobj: slaveValues) {
-        if (valobj == this) {
-            inSlave = true;
-            break;
-        }
-    }
+    const bool inSlave = (item.dir == OTDIR_SLAVE);
 
     String valTempl = F("{{ value_json");
     valTempl += inSlave ? F(".slave") : F(".thermostat");
@@ -344,10 +413,11 @@ void OTValue::refreshDisc() {
 }
 
 const char* OTValue::getName() const {
-    return OTItem::getName(id);
+    return getOTname(id);
 }
 
 void OTValue::setValue(uint16_t val) {
+    adaptInterval(val);
     value = val;
     isSet = true;
     enabled = true;
@@ -360,6 +430,31 @@ uint16_t OTValue::getValue() {
     return value;
 }
 
+/**
+ * Marks the value as received in repeater mode, answered by the boiler to the room unit
+ * or to a cache refresh. Doesn't touch the poll timing of master mode.
+ */
+void OTValue::setCached() {
+    cachedAt = millis();
+    cached = true;
+}
+
+/**
+ * Value of a periodically polled (read-only) ID, for local answers to the room unit.
+ * @param maxAge ms
+ */
+bool OTValue::getCached(const uint32_t maxAge, uint16_t &val) const {
+    if (!enabled || !isSet || !cached || (interval <= 0) || (millis() - cachedAt > maxAge))
+        return false;
+
+    val = value;
+    return true;
+}
+
+bool OTValue::isCacheable() const {
+    return interval > 0;
+}
+
 void OTValue::disable() {
     enabled = false;
     isSet = false;
@@ -368,6 +463,12 @@ void OTValue::disable() {
 void OTValue::init(const bool enabled) {
     this->enabled = enabled;
     isSet = false;
+    queried = false;
+    cached = false;
+}
+
+bool OTValue::isEnabled() const {
+    return enabled;
 }
 
 void OTValue::getJson(JsonObject &obj) const {
@@ -382,8 +483,50 @@ void OTValue::getJson(JsonObject &obj) const {
     }
 }
 
-OTValueu16::OTValueu16(const OpenThermMessageID id, const int interval):
-        OTValue(id, interval) {
+// type of the value in the compact status, indexed by OTDecoder
+static const char *COMPACT_TYPES[] PROGMEM = {
+    "u16", "i16", "float", "u8u8",
+    "flags", "flags", "flags", "flags", "flags", "flags", "flags", "flags", "flags", "flags",
+    "u8u8", "u8u8", "u8u8", "daytime", "u8u8", "u8u8"
+};
+static_assert(sizeof(COMPACT_TYPES) / sizeof(COMPACT_TYPES[0]) == OTDEC_BOILER_FAN_SPEED + 1);
+
+/**
+ * Compact status: the raw 16 bit value keyed by the data ID, decoded only for numbers.
+ */
+void OTValue::writeCbor(CborWriter &w) const {
+    if (!enabled)
+        return;
+
+    if (!isSet)
+        w.addNull((uint8_t) id);
+    else if (item.decoder == OTDEC_FLOAT)
+        w.add((uint8_t) id, static_cast<const OTValueFloat*>(this)->getValue());
+    else if (item.decoder == OTDEC_I16)
+        w.add((uint8_t) id, (int16_t) value);
+    else
+        w.add((uint8_t) id, value);
+}
+
+void OTValue::getSchemaJson(JsonObject &obj) const {
+    obj[F("name")] = FPSTR(getName());
+    obj[F("type")] = FPSTR(COMPACT_TYPES[item.decoder]);
+}
+
+void OTValue::writeJson(JsonWriter &w) const {
+    if (enabled) {
+        if (isSet)
+            writeValue(w);
+        else {
+            const char *name = getName();
+            if (name)
+                w.add(name, (const char*) nullptr);
+        }
+    }
+}
+
+OTValueu16::OTValueu16(const OTItem &item):
+        OTValue(item) {
 }
 
 uint16_t OTValueu16::getValue() const {
@@ -394,9 +537,13 @@ void OTValueu16::getValue(JsonObject &obj) const {
     obj[FPSTR(getName())] = getValue();
 }
 
+void OTValueu16::writeValue(JsonWriter &w) const {
+    w.add(getName(), getValue());
+}
+
 
-OTValuei16::OTValuei16(const OpenThermMessageID id, const int interval):
-        OTValue(id, interval) {
+OTValuei16::OTValuei16(const OTItem &item):
+        OTValue(item) {
 }
 
 int16_t OTValuei16::getValue() const {
@@ -407,58 +554,74 @@ void OTValuei16::getValue(JsonObject &obj) const {
     obj[FPSTR(getName())] = getValue();
 }
 
+void OTValuei16::writeValue(JsonWriter &w) const {
+    w.add(getName(), getValue());
+}
+
 
-OTValueFloat::OTValueFloat(const OpenThermMessageID id, const int interval):
-        OTValue(id, interval) {
+OTValueFloat::OTValueFloat(const OTItem &item):
+        OTValue(item) {
 }
 
-double OTValueFloat::getValue() const {
-    int8_t i = value >> 8;
-    if (i >= 0)
-        return round((i + (value & 0xFF) / 256.0) * 10) / 10.0;
-    else
-        return round((i - (value & 0xFF) / 256.0) * 10) / 10.0;
+float OTValueFloat::getValue() const {
+    return f88ToFloat(value);
 }
 
 void OTValueFloat::getValue(JsonObject &obj) const {
     obj[FPSTR(getName())] = getValue();
 }
 
-
-OTValueFloatTemp::OTValueFloatTemp(const OpenThermMessageID id, const char *haName):
-        OTValueFloat(id, 10),
-        haName(haName) {
+void OTValueFloat::writeValue(JsonWriter &w) const {
+    w.add(getName(), getValue());
 }
 
-bool OTValueFloatTemp::sendDiscovery() {
-    haDisc.createTempSensor(FPSTR(haName), FPSTR(getName()));
-    return OTValue::sendDiscovery("");
+bool OTValueFloat::isChanged(const uint16_t newVal) const {
+    // ignore changes below the resolution of getValue() (0.1)
+    return abs((int16_t) newVal - (int16_t) value) >= 26;
 }
 
 
-OTValueFlags::OTValueFlags(const OpenThermMessageID id, const int interval, const Flag *flagtable, const uint8_t numFlags, const bool slave):
-        OTValue(id, interval),
-        flagTable(flagtable),
+OTValueFlags::OTValueFlags(const OTItem &item, const Flag *flagtable, const uint8_t numFlags):
+        OTValue(item),
         numFlags(numFlags),
-        slave(slave) {
+        flagTable(flagtable) {
 }
 
 void OTValueFlags::getValue(JsonObject &obj) const {
+    char hex[5];
+    snprintf(hex, sizeof(hex), "%x", value);
     JsonObject flags = obj[FPSTR(getName())].to<JsonObject>();
-    flags[F("value")] = String(value, HEX);
+    flags[F("value")] = hex;
     for (uint8_t i=0; i<numFlags; i++) {
         const char *str = flagTable[i].name;
         flags[FPSTR(str)] = (bool) (value & (1<<flagTable[i].bit));
     }
 }
 
+void OTValueFlags::writeValue(JsonWriter &w) const {
+    char hex[5];
+    snprintf(hex, sizeof(hex), "%x", value);
+    w.beginObject(getName());
+    w.add(PSTR("value"), hex);
+    for (uint8_t i=0; i<numFlags; i++)
+        w.add(flagTable[i].name, (bool) (value & (1<<flagTable[i].bit)));
+    w.endObject();
+}
+
+void OTValueFlags::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonObject bits = obj[F("bits")].to<JsonObject>();
+    for (uint8_t i=0; i<numFlags; i++)
+        bits[FPSTR(flagTable[i].name)] = flagTable[i].bit;
+}
+
 bool OTValueFlags::sendDiscFlag(String name, const char *field, const char *devClass)  {
     String dc;
     if (devClass != nullptr)
         dc = FPSTR(devClass);
     haDisc.createBinarySensor(name, FPSTR(field), dc);
     String valTmpl = F("{{ 'ON' if value_json.#0.#1.#2 else 'OFF' }}");
-    valTmpl.replace("#0", slave ? F("slave") : F("thermostat"));
+    valTmpl.replace("#0", (item.dir == OTDIR_SLAVE) ? F("slave") : F("thermostat"));
     valTmpl.replace("#1", getName());
     valTmpl.replace("#2", FPSTR(field));
     haDisc.setValueTemplate(valTmpl);
@@ -479,8 +642,8 @@ bool OTValueFlags::sendDiscovery() {
 }
 
 
-OTValueStatus::OTValueStatus():
-        OTValueFlags(OpenThermMessageID::Status, -1, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueStatus::OTValueStatus(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 bool OTValueStatus::getMode(const uint8_t channel) {
@@ -491,26 +654,26 @@ bool OTValueStatus::getMode(const uint8_t channel) {
 }
 
 
-OTValueMasterStatus::OTValueMasterStatus():
-        OTValueFlags(OpenThermMessageID::Status, -1, flags, sizeof(flags) / sizeof(flags[0]), false) {
+OTValueMasterStatus::OTValueMasterStatus(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 
-OTValueVentStatus::OTValueVentStatus():
-        OTValueFlags(OpenThermMessageID::StatusVentilationHeatRecovery, -1, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueVentStatus::OTValueVentStatus(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 
-OTValueVentMasterStatus::OTValueVentMasterStatus():
-        OTValueFlags(OpenThermMessageID::StatusVentilationHeatRecovery, -1, flags, sizeof(flags) / sizeof(flags[0]), false) {
+OTValueVentMasterStatus::OTValueVentMasterStatus(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 bool OTValueVentMasterStatus::sendDiscovery() {
     return true;
 }
 
-OTValueSlaveConfigMember::OTValueSlaveConfigMember():
-        OTValueFlags(OpenThermMessageID::SConfigSMemberIDcode, 0, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueSlaveConfigMember::OTValueSlaveConfigMember(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 void OTValueSlaveConfigMember::getValue(JsonObject &obj) const {
@@ -518,9 +681,14 @@ void OTValueSlaveConfigMember::getValue(JsonObject &obj) const {
     obj[F("memberId")] = value & 0xFF;
 }
 
+void OTValueSlaveConfigMember::writeValue(JsonWriter &w) const {
+    OTValueFlags::writeValue(w);
+    w.add(PSTR("memberId"), value & 0xFF);
+}
+
 
-OTValueFaultFlags::OTValueFaultFlags(const int interval):
-        OTValueFlags(OpenThermMessageID::ASFflags, interval, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueFaultFlags::OTValueFaultFlags(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 void OTValueFaultFlags::getValue(JsonObject &obj) const {
@@ -528,9 +696,14 @@ void OTValueFaultFlags::getValue(JsonObject &obj) const {
     obj[F("oem_fault_code")] = value & 0xFF;
 }
 
+void OTValueFaultFlags::writeValue(JsonWriter &w) const {
+    OTValueFlags::writeValue(w);
+    w.add(PSTR("oem_fault_code"), value & 0xFF);
+}
+
 
-OTValueVentFaultFlags::OTValueVentFaultFlags(const int interval):
-        OTValueFlags(OpenThermMessageID::ASFflagsOEMfaultCodeVentilationHeatRecovery, interval, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueVentFaultFlags::OTValueVentFaultFlags(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 void OTValueVentFaultFlags::getValue(JsonObject &obj) const {
@@ -538,14 +711,18 @@ void OTValueVentFaultFlags::getValue(JsonObject &obj) const {
     obj[F("oem_vent_fault_code")] = value & 0xFF;
 }
 
+void OTValueVentFaultFlags::writeValue(JsonWriter &w) const {
+    OTValueFlags::writeValue(w);
+    w.add(PSTR("oem_vent_fault_code"), value & 0xFF);
+}
+
 
-OTValueProductVersion::OTValueProductVersion(const OpenThermMessageID id, const int interval, const char *haName):
-        OTValue(id, interval),
-        haName(haName) {
+OTValueProductVersion::OTValueProductVersion(const OTItem &item):
+        OTValue(item) {
 }
 
 bool OTValueProductVersion::sendDiscovery() {
-    haDisc.createSensor(FPSTR(haName), FPSTR(getName()));
+    haDisc.createSensor(FPSTR(item.haName), FPSTR(getName()));
     haDisc.setStateClass("");
     return OTValue::sendDiscovery("");
 }
@@ -557,9 +734,15 @@ void OTValueProductVersion::getValue(JsonObject &obj) const {
     obj[FPSTR(getName())] = v;
 }
 
+void OTValueProductVersion::writeValue(JsonWriter &w) const {
+    char v[8];
+    snprintf(v, sizeof(v), "%u.%u", value >> 8, value & 0xFF);
+    w.add(getName(), v);
+}
+
 
-OTValueCapacityModulation::OTValueCapacityModulation():
-        OTValue(OpenThermMessageID::MaxCapacityMinModLevel, 0) {
+OTValueCapacityModulation::OTValueCapacityModulation(const OTItem &item):
+        OTValue(item) {
 }
 
 bool OTValueCapacityModulation::sendDiscovery() {
@@ -578,8 +761,20 @@ void OTValueCapacityModulation::getValue(JsonObject &obj) const {
     obj[PSTR(MIN_MODULATION)] = value & 0xFF;
 }
 
-OTValueDHWBounds::OTValueDHWBounds():
-        OTValue(OpenThermMessageID::TdhwSetUBTdhwSetLB, 0) {
+void OTValueCapacityModulation::writeValue(JsonWriter &w) const {
+    w.add(MAX_CAPACITY, value >> 8);
+    w.add(MIN_MODULATION, value & 0xFF);
+}
+
+void OTValueCapacityModulation::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // high byte, low byte
+    fields.add(FPSTR(MAX_CAPACITY));
+    fields.add(FPSTR(MIN_MODULATION));
+}
+
+OTValueDHWBounds::OTValueDHWBounds(const OTItem &item):
+        OTValue(item) {
 }
 
 void OTValueDHWBounds::getValue(JsonObject &obj) const {
@@ -587,6 +782,18 @@ void OTValueDHWBounds::getValue(JsonObject &obj) const {
     obj[PSTR(DHW_MIN)] = value & 0xFF;
 }
 
+void OTValueDHWBounds::writeValue(JsonWriter &w) const {
+    w.add(DHW_MAX, value >> 8);
+    w.add(DHW_MIN, value & 0xFF);
+}
+
+void OTValueDHWBounds::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // high byte, low byte
+    fields.add(FPSTR(DHW_MAX));
+    fields.add(FPSTR(DHW_MIN));
+}
+
 bool OTValueDHWBounds::sendDiscovery() {
     haDisc.createTempSensor(F("DHW max. temp."), FPSTR(DHW_MAX));
     if (!OTValue::sendDiscovery(FPSTR(DHW_MAX)))
@@ -596,8 +803,8 @@ bool OTValueDHWBounds::sendDiscovery() {
     return OTValue::sendDiscovery(FPSTR(DHW_MIN));
 }
 
-OTValueCHBounds::OTValueCHBounds():
-        OTValue(OpenThermMessageID::MaxTSetUBMaxTSetLB, 0) {
+OTValueCHBounds::OTValueCHBounds(const OTItem &item):
+        OTValue(item) {
 }
 
 void OTValueCHBounds::getValue(JsonObject &obj) const {
@@ -605,6 +812,18 @@ void OTValueCHBounds::getValue(JsonObject &obj) const {
     obj[PSTR(CH_MIN)] = value & 0xFF;
 }
 
+void OTValueCHBounds::writeValue(JsonWriter &w) const {
+    w.add(CH_MAX, value >> 8);
+    w.add(CH_MIN, value & 0xFF);
+}
+
+void OTValueCHBounds::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // high byte, low byte
+    fields.add(FPSTR(CH_MAX));
+    fields.add(FPSTR(CH_MIN));
+}
+
 bool OTValueCHBounds::sendDiscovery() {
     haDisc.createTempSensor(F("CH max. temp."), FPSTR(CH_MAX));
     if (!OTValue::sendDiscovery(FPSTR(CH_MAX)))
@@ -615,8 +834,8 @@ bool OTValueCHBounds::sendDiscovery() {
 }
 
 
-OTValueMasterConfig::OTValueMasterConfig():
-        OTValueFlags(OpenThermMessageID::MConfigMMemberIDcode, -1, flags, sizeof(flags) / sizeof(flags[0]), false) {
+OTValueMasterConfig::OTValueMasterConfig(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 void OTValueMasterConfig::getValue(JsonObject &obj) const {
@@ -624,25 +843,30 @@ void OTValueMasterConfig::getValue(JsonObject &obj) const {
     obj[F("memberId")] = value & 0xFF;
 }
 
+void OTValueMasterConfig::writeValue(JsonWriter &w) const {
+    OTValueFlags::writeValue(w);
+    w.add(PSTR("memberId"), value & 0xFF);
+}
+
 bool OTValueMasterConfig::sendDiscovery() {
     return true;
 }
 
-OTValueRemoteParameter::OTValueRemoteParameter():
-        OTValueFlags(OpenThermMessageID::RBPflags, 0, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueRemoteParameter::OTValueRemoteParameter(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 
-OTValueRemoteOverrideFunction::OTValueRemoteOverrideFunction():
-        OTValueFlags(OpenThermMessageID::RemoteOverrideFunction, 0, flags, sizeof(flags) / sizeof(flags[0]), true) {
+OTValueRemoteOverrideFunction::OTValueRemoteOverrideFunction(const OTItem &item):
+        OTValueFlags(item, flags, sizeof(flags) / sizeof(flags[0])) {
 }
 
 bool OTValueRemoteOverrideFunction::sendDiscovery() {
     return true;
 }
 
-OTValueDayTime::OTValueDayTime():
-        OTValue(OpenThermMessageID::DayTime, 0) {
+OTValueDayTime::OTValueDayTime(const OTItem &item):
+        OTValue(item) {
 }
 
 void OTValueDayTime::getValue(JsonObject &obj) const {
@@ -651,13 +875,27 @@ void OTValueDayTime::getValue(JsonObject &obj) const {
     obj[F("minute")] = value & 0xFF;
 }
 
+void OTValueDayTime::writeValue(JsonWriter &w) const {
+    w.add(PSTR("dayOfWeek"), (value >> 13) & 0x07);
+    w.add(PSTR("hour"), (value >> 8) & 0x1F);
+    w.add(PSTR("minute"), value & 0xFF);
+}
+
+void OTValueDayTime::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // bits 13..15, 8..12, 0..7
+    fields.add(F("dayOfWeek"));
+    fields.add(F("hour"));
+    fields.add(F("minute"));
+}
+
 bool OTValueDayTime::sendDiscovery() {
     return true;
 }
 
 
-OTValueDate::OTValueDate():
-        OTValue(OpenThermMessageID::Date, 0) {
+OTValueDate::OTValueDate(const OTItem &item):
+        OTValue(item) {
 }
 
 void OTValueDate::getValue(JsonObject &obj) const {
@@ -665,23 +903,25 @@ void OTValueDate::getValue(JsonObject &obj) const {
     obj[F("day")] = value & 0xFF;
 }
 
-bool OTValueDate::sendDiscovery() {
-    return true;
+void OTValueDate::writeValue(JsonWriter &w) const {
+    w.add(PSTR("month"), value >> 8);
+    w.add(PSTR("day"), value & 0xFF);
 }
 
-
-OTValueHeatExchangerTemp::OTValueHeatExchangerTemp():
-        OTValueFloat(OpenThermMessageID::TboilerHeatExchanger, 30) {
+void OTValueDate::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // high byte, low byte
+    fields.add(F("month"));
+    fields.add(F("day"));
 }
 
-bool OTValueHeatExchangerTemp::sendDiscovery() {
-    haDisc.createTempSensor(F("Heat exchange temp."), FPSTR(getName()));
-    return OTValue::sendDiscovery("");
+bool OTValueDate::sendDiscovery() {
+    return true;
 }
 
 
-OTValueBoilerFanSpeed::OTValueBoilerFanSpeed():
-        OTValue(OpenThermMessageID::BoilerFanSpeedSetpointAndActual, 30) {
+OTValueBoilerFanSpeed::OTValueBoilerFanSpeed(const OTItem &item):
+        OTValue(item) {
 }
 
 void OTValueBoilerFanSpeed::getValue(JsonObject &obj) const {
@@ -690,6 +930,20 @@ void OTValueBoilerFanSpeed::getValue(JsonObject &obj) const {
     fanspeeds[PSTR(ACTUAL)] = value & 0xFF;
 }
 
+void OTValueBoilerFanSpeed::writeValue(JsonWriter &w) const {
+    w.beginObject(getName());
+    w.add(SETPOINT, value >> 8);
+    w.add(ACTUAL, value & 0xFF);
+    w.endObject();
+}
+
+void OTValueBoilerFanSpeed::getSchemaJson(JsonObject &obj) const {
+    OTValue::getSchemaJson(obj);
+    JsonArray fields = obj[F("fields")].to<JsonArray>(); // high byte, low byte
+    fields.add(FPSTR(SETPOINT));
+    fields.add(FPSTR(ACTUAL));
+}
+
 bool OTValueBoilerFanSpeed::sendDiscovery() {
     haDisc.createTempSensor(F("Boiler fan speed setpoint"), FPSTR(SETPOINT));
     String field = FPSTR(getName());
@@ -701,13 +955,3 @@ bool OTValueBoilerFanSpeed::sendDiscovery() {
 }
 
 
-OTValueFlameCurrent::OTValueFlameCurrent():
-        OTValueFloat(OpenThermMessageID::FlameCurrent, 30) {
-}
-
-bool OTValueFlameCurrent::sendDiscovery() {
-    haDisc.createSensor(F("Flame current"), FPSTR(getName()));
-    haDisc.setUnit(F("µA"));
-    haDisc.setDeviceClass(F("current"));
-    return OTValue::sendDiscovery("");
-}
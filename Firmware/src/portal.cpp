@@ -9,18 +9,32 @@
 #include "html.h"
 #include "otcontrol.h"
 #include "httpUpdate.h"
+#include "framelog.h"
+#include "otreplay.h"
+#include "slaverequest.h"
+#include "idscan.h"
+#include "tsp.h"
+#include "mqtt.h"
+#ifdef DEBUG
+#include <esp_cpu.h>
+#include <StreamString.h>
+#endif
 
 static const char APP_JSON[] PROGMEM = "application/json";
+static const char APP_CBOR[] PROGMEM = "application/cbor";
 static const IPAddress apAddress(4, 3, 2, 1);
 static const IPAddress apMask(255, 255, 255, 0);
 Portal portal;
 static AsyncWebServer websrv(80);
 AsyncWebSocket ws("/ws");
+static AsyncWebSocket wsStatus("/wsstatus");
 
 
 Portal::Portal():
     reboot(false),
     updateEnable(true) {
+    memset(statusClients, 0, sizeof(statusClients));
+    statusMutex = xSemaphoreCreateMutex();
 }
 
 void Portal::begin(bool configMode) {
@@ -40,6 +54,10 @@ void Portal::begin(bool configMode) {
 
     websrv.begin();
     websrv.addHandler(&ws);
+    wsStatus.onEvent([this](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+        onStatusEvent(client, type);
+    });
+    websrv.addHandler(&wsStatus);
 
     websrv.on("/", HTTP_ANY, [](AsyncWebServerRequest *request) {
         #ifdef DEBUG
@@ -119,14 +137,195 @@ void Portal::begin(bool configMode) {
             request->send(400); // bad request
     });
 
+    // before /status, which would also handle /status/...
+    websrv.on("/status/schema", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        JsonObject jobj = doc.to<JsonObject>();
+        devstatus.getSchemaJson(jobj);
+
+        AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
+        serializeJson(doc, *response);
+        request->send(response);
+    });
+
+    websrv.on("/status.cbor", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        auto snap = devstatus.getCborSnapshot();
+        AsyncWebServerResponse *response = request->beginResponse(FPSTR(APP_CBOR), snap->data.size(),
+            [snap](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                const size_t len = min(maxLen, snap->data.size() - index);
+                memcpy(buffer, snap->data.data() + index, len);
+                return len;
+            });
+        response->addHeader(F("Cache-Control"), F("no-cache"));
+        request->send(response);
+    });
+
     websrv.on("/status", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        auto snap = devstatus.getSnapshot();
+        // weak: the hash leaves out the volatile fields (runtime, counters, rssi, ...),
+        // a 304 may leave them stale by up to the unchanged period
+        char etag[14];
+        snprintf(etag, sizeof(etag), "W/\"%08lx\"", (unsigned long) snap->hash);
+
+        if (request->hasHeader(F("If-None-Match")) && (request->getHeader(F("If-None-Match"))->value() == etag)) {
+            AsyncWebServerResponse *response = request->beginResponse(304);
+            response->addHeader(F("ETag"), etag);
+            request->send(response);
+            return;
+        }
+
+        // the response holds a reference to the snapshot until it is sent
+        AsyncWebServerResponse *response = request->beginResponse(FPSTR(APP_JSON), snap->json.length(),
+            [snap](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                const size_t len = min(maxLen, snap->json.length() - index);
+                memcpy(buffer, snap->json.c_str() + index, len);
+                return len;
+            });
+        response->addHeader(F("ETag"), etag);
+        response->addHeader(F("Cache-Control"), F("no-cache"));
+        request->send(response);
+    });
+
+    websrv.on("/curve", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        JsonArray jarr = doc.to<JsonArray>();
+        otcontrol.getCurveJson(jarr);
+
         AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
-        devstatus.lock();
-        JsonDocument &doc = devstatus.buildDoc();
         serializeJson(doc, *response);
+        request->send(response);
+    });
+
+    websrv.on("/capture", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        // snapshot of the frame log, frames overwritten during download are marked as lost
+        const uint32_t end = framelog.getHead();
+        const uint32_t count = min(end, OTFrameLog::SIZE);
+        const uint32_t start = end - count;
+        const uint32_t now = micros();
+
+        AsyncWebServerResponse *response = request->beginResponse(F("application/octet-stream"), framelog.getCaptureSize(count),
+            [start, count, now](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                return framelog.fillCapture(start, count, now, buf, maxLen, index);
+            });
+        response->addHeader(F("Content-Disposition"), F("attachment; filename=\"otcapture.bin\""));
+        request->send(response);
+    });
+
+    websrv.on("/replay", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        JsonObject jobj = doc.to<JsonObject>();
+        otreplay.getJson(jobj);
+
+        AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
+        serializeJson(doc, *response);
+        request->send(response);
+    });
+
+    websrv.on("/replay", HTTP_POST, 
+        [this] (AsyncWebServerRequest *request) {
+            // text log or binary capture, ?speed=<factor> (default 1, 0: as fast as possible)
+            auto *up = (OTReplay::Upload*) request->_tempObject;
+            if (up == nullptr) {
+                // out of memory, another upload in progress or no body
+                if (otreplay.unlockUpload(request))
+                    request->send(500);
+                else
+                    request->send((request->contentLength() > 0) ? 409 : 400);
+                return;
+            }
+
+            float speed = 1;
+            if (request->hasParam(F("speed")))
+                speed = request->getParam(F("speed"))->value().toFloat();
+            if (!up->finish())
+                request->send(up->isOverflow() ? 413 : 400);
+            else if (otreplay.load(up, speed)) {
+                request->_tempObject = nullptr; // frames taken over by the replay
+                request->send(200);
+            }
+            else
+                request->send(409);
+            otreplay.unlockUpload(request);
+        },
+        [] (AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
+        },
+        [this] (AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+            // parsed while receiving, the frames are kept by the request until load() takes them over
+            if (index == 0) {
+                if (!otreplay.lockUpload(request))
+                    return;
+                request->onDisconnect([request]() {
+                    otreplay.unlockUpload(request);
+                });
+                request->_tempObject = OTReplay::Upload::create();
+            }
+
+            auto *up = (OTReplay::Upload*) request->_tempObject;
+            if (up != nullptr)
+                up->write(data, len);
+        }
+    );
+
+#ifdef DEBUG
+    websrv.on("/bench", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        JsonObject jobj = doc.to<JsonObject>();
+        otcontrol.benchmark(jobj);
+
+        // status document + serialization against the streaming writer,
+        // heap: memory held when the output is complete
+        devstatus.lock();
+        uint32_t heap = ESP.getFreeHeap();
+        uint32_t t = esp_cpu_get_cycle_count();
+        JsonDocument &sdoc = devstatus.buildDoc();
+        const uint32_t tBuild = esp_cpu_get_cycle_count() - t;
+        String str;
+        serializeJson(sdoc, str);
+        const uint32_t tDoc = esp_cpu_get_cycle_count() - t;
+        const uint32_t heapDoc = heap - ESP.getFreeHeap();
+        const size_t sizeDoc = str.length();
         devstatus.unlock();
+        str = String();
+
+        heap = ESP.getFreeHeap();
+        t = esp_cpu_get_cycle_count();
+        StreamString sstr;
+        sstr.reserve(sizeDoc + 256);
+        devstatus.writeJson(sstr);
+        const uint32_t tStream = esp_cpu_get_cycle_count() - t;
+        const uint32_t heapStream = heap - ESP.getFreeHeap();
+        const size_t sizeStream = sstr.length();
+
+        heap = ESP.getFreeHeap();
+        t = esp_cpu_get_cycle_count();
+        StreamString cbor;
+        cbor.reserve(1024);
+        devstatus.writeCbor(cbor);
+        const uint32_t tCbor = esp_cpu_get_cycle_count() - t;
+        const uint32_t heapCbor = heap - ESP.getFreeHeap();
+        const size_t sizeCbor = cbor.length();
+
+        jobj[F("buildDoc")] = tBuild;
+        JsonObject jdoc = jobj[F("statusDoc")].to<JsonObject>();
+        jdoc[F("cycles")] = tDoc;
+        jdoc[F("heap")] = heapDoc;
+        jdoc[F("size")] = sizeDoc;
+        JsonObject jstream = jobj[F("statusStream")].to<JsonObject>();
+        jstream[F("cycles")] = tStream;
+        jstream[F("heap")] = heapStream;
+        jstream[F("size")] = sizeStream;
+        JsonObject jcbor = jobj[F("statusCbor")].to<JsonObject>();
+        jcbor[F("cycles")] = tCbor;
+        jcbor[F("heap")] = heapCbor;
+        jcbor[F("size")] = sizeCbor;
+        JsonObject jparity = jobj[F("parity")].to<JsonObject>();
+        devstatus.checkParity(jparity);
+
+        AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
+        serializeJson(doc, *response);
         request->send(response);
     });
+#endif
 
     websrv.on("/reboot", HTTP_GET, [this](AsyncWebServerRequest *request) {
         request->send(200);
@@ -166,38 +365,109 @@ void Portal::begin(bool configMode) {
     );
 
     websrv.on("/slaverequest", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        if (!request->hasParam("id")) {
-            request->send(503);
-            return;
+        JsonDocument doc;
+        JsonObject jobj = doc.to<JsonObject>();
+
+        if (request->hasParam("ticket")) {
+            // poll result
+            OTSlaveRequests::Ticket ticket;
+            if (!slaveRequests.get(request->getParam("ticket")->value().toInt(), ticket)) {
+                request->send(404);
+                return;
+            }
+            OTSlaveRequests::getJson(ticket, jobj);
         }
-        OpenThermMessageID id = (OpenThermMessageID) request->getParam("id")->value().toInt();
+        else {
+            if (!request->hasParam("id")) {
+                request->send(503);
+                return;
+            }
+            OpenThermMessageID id = (OpenThermMessageID) request->getParam("id")->value().toInt();
 
-        if (!request->hasParam("rw")) {
-            request->send(503);
-            return;
+            if (!request->hasParam("rw")) {
+                request->send(503);
+                return;
+            }
+            OpenThermMessageType ty = (request->getParam("rw")->value().toInt() != 0) ? OpenThermMessageType::READ_DATA : OpenThermMessageType::WRITE_DATA;
+
+            if (!request->hasParam("data")) {
+                request->send(503);
+                return;
+            }
+            String hexData = request->getParam("data")->value();
+            uint16_t data = strtol(hexData.c_str(), nullptr, 16);
+
+            // result follows on the websocket or by polling /slaverequest?ticket=
+            const uint32_t ticket = slaveRequests.add(OpenTherm::buildRequest(ty, id, data));
+            if (!ticket) {
+                request->send(503); // queue full
+                return;
+            }
+            jobj["ticket"] = ticket;
         }
-        OpenThermMessageType ty = (request->getParam("rw")->value().toInt() != 0) ? OpenThermMessageType::READ_DATA : OpenThermMessageType::WRITE_DATA;
 
-        if (!request->hasParam("data")) {
-            request->send(503);
-            return;
+        AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
+        serializeJson(doc, *response);
+        request->send(response);
+    });
+
+    websrv.on("/idscan", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        JsonObject jobj = doc.to<JsonObject>();
+        idscan.getJson(jobj);
+
+        AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
+        serializeJson(doc, *response);
+        request->send(response);
+    });
+
+    websrv.on("/idscan", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        // ?first=0&last=127, results follow on the websocket. ?abort=1 stops the scan
+        if (request->hasParam(F("abort")))
+            idscan.abort();
+        else {
+            const int first = request->hasParam(F("first")) ? request->getParam(F("first"))->value().toInt() : 0;
+            const int last = request->hasParam(F("last")) ? request->getParam(F("last"))->value().toInt() : 127;
+            if ( (first < 0) || (first > 255) || (last < 0) || (last > 255) ) {
+                request->send(400);
+                return;
+            }
+            idscan.start(first, last);
         }
-        String hexData = request->getParam("data")->value();
-        uint16_t data = strtol(hexData.c_str(), nullptr, 16);
+        request->send(200);
+    });
 
-        unsigned long rep = otcontrol.slaveRequest(id, ty, data);
+    websrv.on("/tsp", HTTP_GET, [this](AsyncWebServerRequest *request) {
         JsonDocument doc;
         JsonObject jobj = doc.to<JsonObject>();
-        
-        jobj["type"] = (int) OpenTherm::getMessageType(rep);
-        jobj["id"] = (int) id;
-        jobj["data"] = String(OpenTherm::getUInt(rep), 16);
+        tsp.getJson(jobj);
 
         AsyncResponseStream *response = request->beginResponseStream(FPSTR(APP_JSON));
         serializeJson(doc, *response);
         request->send(response);
     });
 
+    websrv.on("/tsp", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        // ?index=3&value=45, result follows on the websocket. ?reload=1 reads all TSPs again
+        if (request->hasParam(F("reload"))) {
+            tsp.reload();
+            request->send(200);
+            return;
+        }
+
+        if (!request->hasParam(F("index")) || !request->hasParam(F("value"))) {
+            request->send(400);
+            return;
+        }
+        const int index = request->getParam(F("index"))->value().toInt();
+        const int value = request->getParam(F("value"))->value().toInt();
+        if ( (index < 0) || (index > 255) || (value < 0) || (value > 255) ) {
+            request->send(400);
+            return;
+        }
+        request->send(tsp.write(index, value) ? 200 : 404);
+    });
+
     websrv.on("/checkupdate", HTTP_POST, [this](AsyncWebServerRequest *request) {
         this->checkUpdate = true;
         request->send(200);
@@ -225,9 +495,172 @@ void Portal::loop() {
         httpupdate.update();
     }
 
+    idscan.loop();
+
+    OTSlaveRequests::Ticket ticket;
+    while (slaveRequests.popResult(ticket)) {
+        JsonDocument doc;
+        JsonObject jobj = doc[F("slaverequest")].to<JsonObject>();
+        OTSlaveRequests::getJson(ticket, jobj);
+        String str;
+        serializeJson(doc, str);
+        ws.textAll(str);
+    }
+
+    uint8_t tspIndex;
+    OTTsp::Entry tspEntry;
+    while (tsp.popResult(tspIndex, tspEntry)) {
+        JsonDocument doc;
+        JsonObject jobj = doc[F("tsp")].to<JsonObject>();
+        OTTsp::getEntryJson(tspIndex, tspEntry, jobj);
+        String str;
+        serializeJson(doc, str);
+        ws.textAll(str);
+        mqtt.publish(mqtt.getBaseTopic() + F("/tsp"), doc, false);
+    }
+
+    loopStatus();
+
     ws.cleanupClients();
 }
 
+/**
+ * Called from the async TCP task.
+ */
+void Portal::onStatusEvent(AsyncWebSocketClient *client, const AwsEventType type) {
+    bool rejected = (type == WS_EVT_CONNECT);
+    xSemaphoreTake(statusMutex, portMAX_DELAY);
+    switch (type) {
+    case WS_EVT_CONNECT:
+        for (auto &sc: statusClients) {
+            if (sc.id == 0) {
+                sc.id = client->id();
+                sc.full = true;
+                rejected = false;
+                break;
+            }
+        }
+        break;
+    case WS_EVT_DISCONNECT:
+        for (auto &sc: statusClients)
+            if (sc.id == client->id())
+                sc.id = 0;
+        break;
+    default:
+        break;
+    }
+    xSemaphoreGive(statusMutex);
+
+    if (rejected)
+        client->close(); // all slots taken, the client retries later
+}
+
+/**
+ * Pushes {"status":{...},"seq":n} to new clients and {"delta":{...},"seq":n} with the
+ * fields changed since the last push to all others. The status is the shared
+ * snapshot of DevStatus, the deltas come from its tracker (same as for MQTT),
+ * changes within 1 / statusRate s are coalesced. Deltas also carry the volatile
+ * fields (runtime, rssi, counters, ...) of every new snapshot.
+ */
+void Portal::loopStatus() {
+    if ( (statusRate == 0) || (millis() - lastStatusPush < 1000UL / statusRate) )
+        return;
+    lastStatusPush = millis();
+
+    const bool resync = millis() - lastStatusResync >= STATUS_RESYNC;
+    if (resync)
+        lastStatusResync = millis();
+
+    StatusClient clients[MAX_STATUS_CLIENTS];
+    bool any = false;
+    xSemaphoreTake(statusMutex, portMAX_DELAY);
+    for (uint8_t i=0; i<MAX_STATUS_CLIENTS; i++) {
+        StatusClient &sc = statusClients[i];
+        if (resync)
+            sc.full = true;
+        clients[i] = sc;
+        sc.full = false;
+        any |= sc.id != 0;
+    }
+    xSemaphoreGive(statusMutex);
+    if (!any)
+        return;
+
+    auto snap = devstatus.getSnapshot();
+    String fullMsg;
+    // clients usually share the epoch, the delta is built once per epoch
+    String deltaMsg;
+    uint32_t deltaSince = 0;
+    uint32_t deltaSeq = 0;
+    uint32_t deltaBuilt = 0;
+    bool deltaValid = false;
+
+    for (auto &sc: clients) {
+        if (sc.id == 0)
+            continue;
+
+        const String *msg;
+        uint32_t seq;
+        uint32_t built;
+        if (sc.full) {
+            if (fullMsg.isEmpty()) {
+                fullMsg.reserve(snap->json.length() + 32);
+                fullMsg = F("{\"status\":");
+                fullMsg += snap->json;
+                fullMsg += F(",\"seq\":");
+                fullMsg += snap->epoch;
+                fullMsg += '}';
+            }
+            msg = &fullMsg;
+            seq = snap->epoch;
+            built = snap->built;
+        }
+        else {
+            if ( (sc.seq == snap->epoch) && (sc.built == snap->built) )
+                continue;
+            if (!deltaValid || (deltaSince != sc.seq)) {
+                JsonDocument delta;
+                auto dsnap = devstatus.getDelta(sc.seq, delta[F("delta")].to<JsonObject>(), true);
+                delta[F("seq")] = dsnap->epoch;
+                deltaMsg.clear();
+                serializeJson(delta, deltaMsg);
+                deltaSince = sc.seq;
+                deltaSeq = dsnap->epoch;
+                deltaBuilt = dsnap->built;
+                deltaValid = true;
+            }
+            if ( (deltaSeq == sc.seq) && (deltaBuilt == sc.built) )
+                continue;
+            msg = &deltaMsg;
+            seq = deltaSeq;
+            built = deltaBuilt;
+        }
+
+        AsyncWebSocketClient *client = wsStatus.client(sc.id);
+        if (client == nullptr)
+            continue;
+        const bool sent = client->canSend();
+        if (sent)
+            client->text(*msg);
+        xSemaphoreTake(statusMutex, portMAX_DELAY);
+        for (auto &c: statusClients) {
+            if (c.id == sc.id) {
+                if (sent) {
+                    c.seq = seq;
+                    c.built = built;
+                }
+                else
+                    c.full = true; // frame dropped, the client has to start over
+            }
+        }
+        xSemaphoreGive(statusMutex);
+    }
+}
+
+void Portal::setStatusRate(const uint8_t rate) {
+    statusRate = min(rate, (uint8_t) 10);
+}
+
 void Portal::textAll(String text) {
     ws.textAll(text);
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ OutsideTemp outsideTemp;
 Sensor *Sensor::lastSensor = nullptr;
 
 static OneWire oneWire(4);
+static DallasTemperature ds(&oneWire);
 OneWireNode *oneWireNode = nullptr;
 
 Sensor::Sensor():
@@ -19,14 +20,14 @@ Sensor::Sensor():
     lastSensor = this;
 }
 
-void Sensor::set(const double val, const Source src) {
+void Sensor::set(const float val, const Source src) {
     if (src == this->src) {
-        this->value = round(val * 10) / 10;
+        this->value = roundf(val * 10) / 10;
         setFlag = true;
     }
 }
 
-bool Sensor::get(double &val) {
+bool Sensor::get(float &val) {
     if (setFlag) {
         val = this->value;
         return true;
@@ -63,7 +64,7 @@ AutoSensor::AutoSensor() {
     memset(values, 0, sizeof(values));
 }
 
-void AutoSensor::set(const double val, const Source src) {
+void AutoSensor::set(const float val, const Source src) {
     if (this->src == SOURCE_AUTO) {
         if (val != values[src]) {
             Sensor::set(val, this->src);
@@ -176,37 +177,118 @@ OneWireNode::OneWireNode(uint8_t *addr):
     memcpy(this->addr, addr, sizeof(this->addr));
 }
 
+OneWireNode::ConvState OneWireNode::convState = CONV_IDLE;
+uint32_t OneWireNode::convStart = 0;
+uint16_t OneWireNode::convTime = 0;
+OneWireNode *OneWireNode::readNode = nullptr;
+static const uint32_t CONV_INTERVAL = 5000; // ms
+
 void OneWireNode::begin() {
     oneWire.reset_search();
     uint8_t addr[8];
     while (oneWire.search(addr)) {
         new OneWireNode(addr);
     }
-    loop();
+    ds.setWaitForConversion(false);
+}
+
+/**
+ * config: {"resolution": {"28ff641e0f3c0417": 10}}
+ */
+void OneWireNode::setConfig(JsonObject obj) {
+    JsonObject jres = obj[F("resolution")];
+    OneWireNode *node = oneWireNode;
+    while (node) {
+        const uint8_t res = jres[node->getAdr()] | 0;
+        node->resolution = ((res >= 9) && (res <= 12)) ? res : 0;
+        node = node->next;
+    }
 }
 
 void OneWireNode::loop() {
-    static uint32_t next = 0;
-    if (millis() > next) {
+    switch (convState) {
+    case CONV_IDLE: {
+        if ( !oneWireNode || ((int32_t) (millis() - convStart) < (int32_t) CONV_INTERVAL) )
+            break;
+
+        // the conversion has to be long enough for the sensor with the highest resolution,
+        // a configured resolution isn't set yet after a power loss of the sensor
+        uint8_t maxRes = 9;
         OneWireNode *node = oneWireNode;
-        DallasTemperature ds(&oneWire);
-        ds.requestTemperatures();
         while (node) {
-            node->temp = round(ds.getTempC(node->addr) * 10) / 10;
-            if (node->temp != DEVICE_DISCONNECTED_C) {
-                for (int i=0; i<sizeof(roomTemp) / sizeof(roomTemp[0]); i++) {
-                    if (roomTemp[i].own == node)
-                        roomTemp[i].set(node->temp, Sensor::SOURCE_1WIRE);
-                }
-                if (outsideTemp.own == node)
-                    outsideTemp.set(node->temp, Sensor::SOURCE_1WIRE);
-            }
+            if (node->addr[0] == 0x10) // DS18S20, always 750 ms
+                maxRes = 12;
+            else
+                maxRes = max(maxRes, max(node->resolution, node->curResolution));
             node = node->next;
         }
-        next = millis() + 5000;
+        convTime = ds.millisToWaitForConversion(maxRes);
+        convStart = millis();
+        ds.requestTemperatures();
+        convState = CONV_WAIT;
+        break;
+    }
+
+    case CONV_WAIT:
+        if ((millis() - convStart) >= convTime) {
+            readNode = oneWireNode;
+            convState = CONV_READ;
+        }
+        break;
+
+    case CONV_READ:
+        if (readNode) {
+            readNode->read();
+            readNode = readNode->next;
+        }
+        if (!readNode)
+            convState = CONV_IDLE;
+        break;
     }
 }
 
+void OneWireNode::read() {
+    ScratchPad sp;
+
+    numReads++;
+    temp = DEVICE_DISCONNECTED_C;
+    if (!ds.readScratchPad(addr, sp)) {
+        numErrors++;
+        return;
+    }
+    if (OneWire::crc8(sp, 8) != sp[8]) {
+        numCrcErrors++;
+        return;
+    }
+
+    int16_t raw = (sp[1] << 8) | sp[0];
+    if (addr[0] == 0x10) // DS18S20, 0.5 K
+        raw <<= 3;
+    else {
+        curResolution = ((sp[4] >> 5) & 0x03) + 9;
+        raw &= ~((1 << (12 - curResolution)) - 1); // undefined bits at lower resolution
+    }
+    if (!converted && (raw == 85 * 16)) // power-on value of the scratchpad, no conversion yet
+        return;
+    converted = true;
+    temp = roundf(raw / 16.0f * 10) / 10;
+    publish();
+
+    // resolution is lost on power loss of the sensor, set it again for the next conversion
+    if (resolution && (addr[0] != 0x10) && (resolution != curResolution))
+        if (ds.setResolution(addr, resolution, true))
+            curResolution = resolution;
+}
+
+void OneWireNode::publish() {
+    for (int i=0; i<sizeof(roomTemp) / sizeof(roomTemp[0]); i++) {
+        if (roomTemp[i].own == this)
+            roomTemp[i].set(temp, Sensor::SOURCE_1WIRE);
+    }
+    if (outsideTemp.own == this)
+        outsideTemp.set(temp, Sensor::SOURCE_1WIRE);
+}
+
 void OneWireNode::writeJson(JsonObject &status) {
     OneWireNode *node = oneWireNode;
 
@@ -222,6 +304,40 @@ void OneWireNode::writeJson(JsonObject &status) {
     }
 }
 
+void OneWireNode::writeJson(JsonWriter &w) {
+    for (OneWireNode *node = oneWireNode; node; node = node->next) {
+        const String adrStr = node->getAdr();
+        if (node->temp != DEVICE_DISCONNECTED_C)
+            w.add(adrStr.c_str(), node->temp);
+        else
+            w.add(adrStr.c_str(), (const char*) nullptr);
+    }
+}
+
+void OneWireNode::writeStatsJson(JsonObject &status) {
+    OneWireNode *node = oneWireNode;
+
+    while (node) {
+        JsonObject jnode = status[node->getAdr()].to<JsonObject>();
+        jnode[F("resolution")] = node->curResolution;
+        jnode[F("reads")] = node->numReads;
+        jnode[F("crcErrors")] = node->numCrcErrors;
+        jnode[F("errors")] = node->numErrors;
+        node = node->next;
+    }
+}
+
+void OneWireNode::writeStatsJson(JsonWriter &w) {
+    for (OneWireNode *node = oneWireNode; node; node = node->next) {
+        w.beginObject(node->getAdr().c_str());
+        w.add(PSTR("resolution"), node->curResolution);
+        w.add(PSTR("reads"), node->numReads);
+        w.add(PSTR("crcErrors"), node->numCrcErrors);
+        w.add(PSTR("errors"), node->numErrors);
+        w.endObject();
+    }
+}
+
 String OneWireNode::getAdr() const {
     String result;
     for (uint8_t i=0; i<sizeof(addr); i++) {
@@ -0,0 +1,205 @@
+#include "slaverequest.h"
+
+OTSlaveRequests slaveRequests;
+
+OTSlaveRequests::OTSlaveRequests():
+        OTJob(PRIO_SETPOINT) {
+    memset(tickets, 0, sizeof(tickets));
+    mutex = xSemaphoreCreateMutex();
+}
+
+OTSlaveRequests::Ticket &OTSlaveRequests::slot(const uint32_t id) {
+    return tickets[id % SIZE];
+}
+
+void OTSlaveRequests::finish(Ticket &t, const State state, const unsigned long response) {
+    t.state = state;
+    t.response = response;
+    t.notified = !t.announce;
+}
+
+/**
+ * Called from the web server task.
+ * @param announce send the result over the websocket, otherwise it has to be polled
+ * @returns ticket, 0 if the queue is full
+ */
+uint32_t OTSlaveRequests::add(const unsigned long request, const bool announce) {
+    uint32_t id = 0;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Ticket &t = slot(nextId);
+    if ( (t.state != REQ_QUEUED) && (t.state != REQ_SENT) ) {
+        id = nextId++;
+        t.id = id;
+        t.request = request;
+        t.response = 0;
+        t.time = millis();
+        t.state = REQ_QUEUED;
+        t.announce = announce;
+        t.notified = false;
+    }
+    xSemaphoreGive(mutex);
+    return id;
+}
+
+/**
+ * @returns false if the ticket is unknown or its slot was reused
+ */
+bool OTSlaveRequests::get(const uint32_t id, Ticket &ticket) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    ticket = slot(id);
+    xSemaphoreGive(mutex);
+    return (id != 0) && (ticket.id == id) && (ticket.state != REQ_FREE);
+}
+
+bool OTSlaveRequests::getRelease(const uint32_t now, uint32_t &release) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    // skip cancelled requests
+    while ( (sendId != nextId) && (slot(sendId).state != REQ_QUEUED) )
+        sendId++;
+
+    if (sentId) {
+        Ticket &t = slot(sentId);
+        if (now - t.time > RESPONSE_TIMEOUT) {
+            // response got lost (e.g. OT mode changed)
+            finish(t, REQ_TIMEOUT, 0);
+            sentId = 0;
+        }
+    }
+
+    if ( !sentId && (sendId != nextId) ) {
+        release = slot(sendId).time;
+        res = true;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+bool OTSlaveRequests::getRequest(unsigned long &request) {
+    request = slot(sendId).request;
+    return true;
+}
+
+uint32_t OTSlaveRequests::getPeriod() const {
+    return 0;
+}
+
+void OTSlaveRequests::onSent(const uint32_t now) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Ticket &t = slot(sendId);
+    t.state = REQ_SENT;
+    t.time = now;
+    sentId = sendId++;
+    xSemaphoreGive(mutex);
+}
+
+/**
+ * Takes the next request outside of the scheduler (repeater mode).
+ */
+bool OTSlaveRequests::take(const uint32_t now, unsigned long &request) {
+    uint32_t release;
+    if (!getRelease(now, release) || !getRequest(request))
+        return false;
+
+    onSent(now);
+    return true;
+}
+
+/**
+ * @returns true if msg is the response to a request of this queue
+ */
+bool OTSlaveRequests::onResponse(const unsigned long msg, const OpenThermResponseStatus status) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (sentId) {
+        Ticket &t = slot(sentId);
+        switch (status) {
+        case OpenThermResponseStatus::TIMEOUT:
+            finish(t, REQ_TIMEOUT, 0);
+            res = true;
+            break;
+        case OpenThermResponseStatus::INVALID:
+            finish(t, REQ_INVALID, msg);
+            res = true;
+            break;
+        case OpenThermResponseStatus::SUCCESS:
+            if (OpenTherm::getDataID(msg) == OpenTherm::getDataID(t.request)) {
+                finish(t, REQ_DONE, msg);
+                res = true;
+            }
+            break;
+        default:
+            break;
+        }
+        if (res)
+            sentId = 0;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+/**
+ * Withdraws a request not sent yet, its result is not announced.
+ * @returns false if the request is sent already or the ticket is unknown
+ */
+bool OTSlaveRequests::cancel(const uint32_t id) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    Ticket &t = slot(id);
+    if ( (id != 0) && (t.id == id) && (t.state == REQ_QUEUED) ) {
+        finish(t, REQ_UNAVAILABLE, 0);
+        t.notified = true;
+        res = true;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+/**
+ * Fails all queued requests, the slave can't be reached in the current OT mode.
+ */
+void OTSlaveRequests::cancelAll() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    while (sendId != nextId) {
+        Ticket &t = slot(sendId++);
+        if (t.state == REQ_QUEUED)
+            finish(t, REQ_UNAVAILABLE, 0);
+    }
+    xSemaphoreGive(mutex);
+}
+
+/**
+ * Next finished request not announced yet, single consumer (Portal::loop)
+ */
+bool OTSlaveRequests::popResult(Ticket &ticket) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (uint8_t i=0; i<SIZE; i++) {
+        Ticket &t = tickets[i];
+        if ( (t.state >= REQ_DONE) && !t.notified ) {
+            t.notified = true;
+            ticket = t;
+            res = true;
+            break;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+void OTSlaveRequests::getJson(const Ticket &ticket, JsonObject &obj) {
+    static const char *STATES[] = {"free", "queued", "sent", "done", "timeout", "invalid", "unavailable"};
+
+    obj[F("ticket")] = ticket.id;
+    obj[F("state")] = STATES[ticket.state];
+    obj[F("id")] = (int) OpenTherm::getDataID(ticket.request);
+    if ( (ticket.state == REQ_DONE) || (ticket.state == REQ_INVALID) ) {
+        obj[F("type")] = (int) OpenTherm::getMessageType(ticket.response);
+        obj[F("data")] = String(OpenTherm::getUInt(ticket.response), 16);
+    }
+}
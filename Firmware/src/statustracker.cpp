@@ -0,0 +1,187 @@
+#include "statustracker.h"
+
+static const uint32_t FNV_OFFSET = 2166136261UL;
+static const uint32_t FNV_PRIME = 16777619UL;
+
+static uint32_t fnv(uint32_t h, const char *str) {
+    while (*str) {
+        h ^= (uint8_t) *str++;
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+// hash of the serialized value, without a buffer
+class HashPrint: public Print {
+public:
+    uint32_t hash {FNV_OFFSET};
+    size_t write(uint8_t c) override {
+        hash ^= c;
+        hash *= FNV_PRIME;
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t size) override {
+        for (size_t i=0; i<size; i++)
+            write(buf[i]);
+        return size;
+    }
+};
+
+static uint32_t pathHash(const uint32_t parent, const char *key) {
+    return fnv(fnv(parent, "/"), key) | 1; // never 0
+}
+
+/**
+ * @param volatileFields paths of the fields not to be tracked, "/" separated
+ */
+StatusTracker::StatusTracker(const char *const volatileFields[], const uint8_t num) {
+    for (uint8_t i=0; (i < num) && (numVolatile < MAX_VOLATILE); i++) {
+        String path = FPSTR(volatileFields[i]);
+        uint32_t h = FNV_OFFSET;
+        int start = 0;
+        while (start <= (int) path.length()) {
+            int end = path.indexOf('/', start);
+            if (end < 0)
+                end = path.length();
+            h = pathHash(h, path.substring(start, end).c_str());
+            start = end + 1;
+        }
+        volatilePaths[numVolatile++] = h;
+    }
+    memset(fields, 0, sizeof(fields));
+}
+
+StatusTracker::Field *StatusTracker::find(const uint32_t path) {
+    uint16_t i = path & (SIZE - 1);
+    for (uint16_t n=0; n<SIZE; n++) {
+        Field &f = fields[i];
+        if ( (f.path == path) || (f.path == 0) )
+            return &f;
+        i = (i + 1) & (SIZE - 1);
+    }
+    return nullptr;
+}
+
+bool StatusTracker::isVolatile(const uint32_t path) const {
+    for (uint8_t i=0; i<numVolatile; i++)
+        if (volatilePaths[i] == path)
+            return true;
+    return false;
+}
+
+uint16_t StatusTracker::updateObject(JsonObjectConst src, const uint32_t parent) {
+    uint16_t changes = 0;
+
+    for (JsonPairConst kv: src) {
+        const uint32_t path = pathHash(parent, kv.key().c_str());
+        if (isVolatile(path))
+            continue;
+        JsonVariantConst val = kv.value();
+
+        if (val.is<JsonObjectConst>()) {
+            changes += updateObject(val.as<JsonObjectConst>(), path);
+            continue;
+        }
+
+        HashPrint hp;
+        serializeJson(val, hp);
+        hash = (hash ^ path) * FNV_PRIME;
+        hash = (hash ^ hp.hash) * FNV_PRIME;
+
+        Field *f = find(path);
+        if ( (f != nullptr) && (f->path == path) && (f->value == hp.hash) )
+            continue;
+
+        if (f == nullptr)
+            full = true;
+        else {
+            if (f->path == 0) {
+                f->path = path;
+                numFields++;
+            }
+            f->value = hp.hash;
+            f->changed = epoch + 1;
+        }
+        changes++;
+    }
+    return changes;
+}
+
+uint16_t StatusTracker::deltaObject(JsonObjectConst src, const uint32_t since, JsonObject dst, const uint32_t parent, const bool withVolatile) {
+    uint16_t changes = 0;
+
+    for (JsonPairConst kv: src) {
+        const uint32_t path = pathHash(parent, kv.key().c_str());
+        JsonVariantConst val = kv.value();
+        if (isVolatile(path)) {
+            if (withVolatile) {
+                dst[kv.key()].set(val);
+                changes++;
+            }
+            continue;
+        }
+
+        if (val.is<JsonObjectConst>()) {
+            JsonObject sub = dst[kv.key()].to<JsonObject>();
+            const uint16_t n = deltaObject(val.as<JsonObjectConst>(), since, sub, path, withVolatile);
+            if (n == 0)
+                dst.remove(kv.key());
+            changes += n;
+            continue;
+        }
+
+        Field *f = find(path);
+        if ( (f != nullptr) && (f->path == path) && ((int32_t) (f->changed - since) <= 0) )
+            continue;
+
+        dst[kv.key()].set(val);
+        changes++;
+    }
+    return changes;
+}
+
+/**
+ * Takes over a new version of the document, called once per build.
+ * @returns number of changed fields
+ */
+uint16_t StatusTracker::update(JsonObjectConst src) {
+    hash = FNV_OFFSET;
+    const uint16_t changes = updateObject(src, FNV_OFFSET);
+    if (changes > 0)
+        epoch++;
+    return changes;
+}
+
+/**
+ * @param src document of the last update()
+ * @param since epoch known to the consumer
+ * @param delta receives the fields changed after since
+ * @param withVolatile add the volatile fields as well
+ * @returns number of fields in delta
+ */
+uint16_t StatusTracker::getDelta(JsonObjectConst src, const uint32_t since, JsonObject delta, const bool withVolatile) {
+    return deltaObject(src, since, delta, FNV_OFFSET, withVolatile);
+}
+
+uint32_t StatusTracker::getEpoch() const {
+    return epoch;
+}
+
+/**
+ * Hash of the tracked content of the last update(), for ETags.
+ */
+uint32_t StatusTracker::getHash() const {
+    return hash;
+}
+
+void StatusTracker::getJson(JsonObject &obj) const {
+    obj[F("epoch")] = epoch;
+    obj[F("fields")] = numFields;
+    obj[F("overflow")] = full;
+}
+
+void StatusTracker::writeJson(JsonWriter &w) const {
+    w.add(PSTR("epoch"), epoch);
+    w.add(PSTR("fields"), numFields);
+    w.add(PSTR("overflow"), full);
+}
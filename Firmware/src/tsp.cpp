@@ -0,0 +1,269 @@
+#include "tsp.h"
+#include "otcaps.h"
+
+OTTsp tsp;
+
+static const struct {
+    OpenThermMessageID count;
+    OpenThermMessageID value;
+} TSP_IDS[3] = {
+    {OpenThermMessageID::TSP, OpenThermMessageID::TSPindexTSPvalue},
+    {OpenThermMessageID::TSPventilationHeatRecovery, OpenThermMessageID::TSPindexTSPvalueVentilationHeatRecovery},
+    {OpenThermMessageID::TSPSolarStorage, OpenThermMessageID::TSPindexTSPvalueSolarStorage}
+};
+
+OTTsp::OTTsp():
+        OTJob(PRIO_BACKGROUND),
+        countId(TSP_IDS[0].count),
+        valueId(TSP_IDS[0].value) {
+    memset(entries, 0, sizeof(entries));
+    mutex = xSemaphoreCreateMutex();
+}
+
+/**
+ * Called from OTControl::setOTMode(), the cache is kept unless the slave application changed.
+ */
+void OTTsp::init(const bool enabled, const uint8_t slaveApp) {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if ( (slaveApp != app) && (slaveApp < 3) ) {
+        app = slaveApp;
+        countId = TSP_IDS[app].count;
+        valueId = TSP_IDS[app].value;
+        count = 0;
+        memset(entries, 0, sizeof(entries));
+    }
+
+    awaiting = false;
+    if (!enabled)
+        state = TSPS_OFF;
+    else if (otcaps.isUnsupported(countId))
+        state = TSPS_UNSUPPORTED;
+    else if (state != TSPS_DONE)
+        state = TSPS_COUNT;
+    xSemaphoreGive(mutex);
+}
+
+uint8_t OTTsp::numCached() const {
+    return min(count, MAX_TSP);
+}
+
+bool OTTsp::findPending(EntryState st, uint8_t &index) const {
+    for (uint8_t i=0; i<numCached(); i++)
+        if (entries[i].state == st) {
+            index = i;
+            return true;
+        }
+    return false;
+}
+
+void OTTsp::finishWrite(Entry &e, const EntryState st) {
+    e.state = st;
+    e.notify = true;
+}
+
+bool OTTsp::getRelease(const uint32_t now, uint32_t &release) {
+    uint8_t index;
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    switch (state) {
+    case TSPS_COUNT:
+    case TSPS_WALK:
+        res = true;
+        break;
+    case TSPS_DONE:
+        res = findPending(TSP_DIRTY, index) || findPending(TSP_VERIFY, index);
+        break;
+    default:
+        break;
+    }
+    release = lastSent + (awaiting ? RETRY : SPACING);
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+/**
+ * writes first, then read backs, then the walk through all TSPs
+ */
+bool OTTsp::getRequest(unsigned long &request) {
+    uint8_t index;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    sentWrite = false;
+    if (state == TSPS_COUNT)
+        request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, countId, 0);
+    else if (findPending(TSP_DIRTY, index)) {
+        sentWrite = true;
+        sentIndex = index;
+        request = OpenTherm::buildRequest(OpenThermMessageType::WRITE_DATA, valueId, (index << 8) | entries[index].newValue);
+    }
+    else {
+        if (!findPending(TSP_VERIFY, index))
+            index = walkNext;
+        sentIndex = index;
+        request = OpenTherm::buildRequest(OpenThermMessageType::READ_DATA, valueId, index << 8);
+    }
+    xSemaphoreGive(mutex);
+    return true;
+}
+
+uint32_t OTTsp::getPeriod() const {
+    return 0;
+}
+
+void OTTsp::onSent(const uint32_t now) {
+    lastSent = now;
+    awaiting = true;
+}
+
+/**
+ * Called for every response of the slave, in repeater mode the walk of the room
+ * unit fills the cache as well.
+ */
+void OTTsp::onResponse(const unsigned long msg) {
+    const auto id = OpenTherm::getDataID(msg);
+    if ( (id != countId) && (id != valueId) )
+        return;
+
+    const auto mt = OpenTherm::getMessageType(msg);
+    const uint8_t hb = (msg >> 8) & 0xFF;
+    const uint8_t lb = msg & 0xFF;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (id == countId) {
+        switch (mt) {
+        case OpenThermMessageType::READ_ACK:
+            if (hb != count) {
+                count = hb;
+                memset(entries, 0, sizeof(entries));
+            }
+            walkNext = 0;
+            if (state == TSPS_COUNT)
+                state = (count > 0) ? TSPS_WALK : TSPS_DONE;
+            awaiting = false;
+            break;
+        case OpenThermMessageType::UNKNOWN_DATA_ID:
+            state = TSPS_UNSUPPORTED;
+            awaiting = false;
+            break;
+        default:
+            break;
+        }
+    }
+    else if (mt == OpenThermMessageType::UNKNOWN_DATA_ID) {
+        // a rejected write fails only that entry, the TSPs can still be read
+        if (awaiting && sentWrite) {
+            if (entries[sentIndex].state == TSP_DIRTY)
+                finishWrite(entries[sentIndex], TSP_FAILED);
+        }
+        else
+            state = TSPS_UNSUPPORTED;
+        awaiting = false;
+    }
+    else if (hb < numCached()) {
+        Entry &e = entries[hb];
+        switch (mt) {
+        case OpenThermMessageType::READ_ACK:
+            e.value = lb;
+            if (e.state == TSP_VERIFY)
+                finishWrite(e, (lb == e.newValue) ? TSP_VALID : TSP_FAILED);
+            else if (e.state != TSP_DIRTY)
+                e.state = TSP_VALID;
+            break;
+        case OpenThermMessageType::WRITE_ACK:
+            if (e.state == TSP_DIRTY)
+                e.state = TSP_VERIFY;
+            break;
+        case OpenThermMessageType::DATA_INVALID:
+            if (sentWrite && (hb == sentIndex) && (e.state == TSP_DIRTY))
+                finishWrite(e, TSP_FAILED);
+            else if (e.state == TSP_UNKNOWN)
+                e.state = TSP_INVALID;
+            break;
+        default:
+            break;
+        }
+
+        if (awaiting && (hb == sentIndex)) {
+            awaiting = false;
+            if ( (state == TSPS_WALK) && (hb == walkNext) && !sentWrite && (++walkNext >= numCached()) )
+                state = TSPS_DONE;
+        }
+    }
+    xSemaphoreGive(mutex);
+}
+
+/**
+ * Called from the web server / MQTT task.
+ * @returns false if the index is unknown (yet)
+ */
+bool OTTsp::write(const uint8_t index, const uint8_t value) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if ( (state != TSPS_OFF) && (state != TSPS_UNSUPPORTED) && (index < numCached()) ) {
+        Entry &e = entries[index];
+        e.newValue = value;
+        e.state = TSP_DIRTY;
+        e.notify = false;
+        res = true;
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+/**
+ * Reads the number of TSPs and all values again.
+ */
+void OTTsp::reload() {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    if (state != TSPS_OFF)
+        state = TSPS_COUNT;
+    xSemaphoreGive(mutex);
+}
+
+/**
+ * Next finished write not announced yet, single consumer (Portal::loop)
+ */
+bool OTTsp::popResult(uint8_t &index, Entry &entry) {
+    bool res = false;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (uint8_t i=0; i<numCached(); i++) {
+        if (entries[i].notify) {
+            entries[i].notify = false;
+            index = i;
+            entry = entries[i];
+            res = true;
+            break;
+        }
+    }
+    xSemaphoreGive(mutex);
+    return res;
+}
+
+void OTTsp::getEntryJson(const uint8_t index, const Entry &entry, JsonObject &obj) {
+    static const char *STATES[] = {"unknown", "valid", "invalid", "dirty", "verify", "failed"};
+
+    obj[F("index")] = index;
+    obj[F("state")] = STATES[entry.state];
+    if (entry.state != TSP_UNKNOWN)
+        obj[F("value")] = entry.value;
+    if ( (entry.state == TSP_DIRTY) || (entry.state == TSP_VERIFY) || (entry.state == TSP_FAILED) )
+        obj[F("newValue")] = entry.newValue;
+}
+
+void OTTsp::getJson(JsonObject &obj) {
+    static const char *STATES[] = {"off", "count", "walk", "done", "unsupported"};
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    obj[F("state")] = STATES[state];
+    obj[F("dataId")] = (int) valueId;
+    obj[F("count")] = count;
+    JsonArray jentries = obj[F("entries")].to<JsonArray>();
+    for (uint8_t i=0; i<numCached(); i++) {
+        JsonObject je = jentries.add<JsonObject>();
+        getEntryJson(i, entries[i], je);
+    }
+    xSemaphoreGive(mutex);
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+/*
+    Minimal stand-in of the Arduino core for the host tests (env:native). Only
+    what the modules built there use, time is set by the tests and advances by
+    1 ms per yield() or delay() so busy waits end. Pins and LEDs have no effect,
+    there is no wall clock (getLocalTime() fails).
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define PROGMEM
+#define IRAM_ATTR
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(s) (s)
+
+#define HEX 16
+#define DEC 10
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+#define log_d(...)
+#define log_i(...)
+#define log_w(...)
+#define log_e(...)
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+using std::min;
+using std::max;
+
+inline unsigned long millis() {
+    return stub::ms;
+}
+
+inline unsigned long micros() {
+    return stub::us;
+}
+
+inline void yield() {
+    stub::setMillis(stub::ms + 1);
+}
+
+inline void delay(unsigned long ms) {
+    stub::setMillis(stub::ms + max(ms, 1ul));
+}
+
+inline void pinMode(int, int) {
+}
+
+inline void digitalWrite(int, int) {
+}
+
+inline int digitalRead(int) {
+    return LOW;
+}
+
+inline bool getLocalTime(struct tm *, uint32_t = 5000) {
+    return false;
+}
+
+// like the one of the Arduino core valid when zero initialized, globals may use it before its constructor ran
+class String {
+private:
+    char *buf {nullptr};
+    unsigned int len {0};
+    static std::string fmt(const char *f, ...) {
+        char tmp[64];
+        va_list args;
+        va_start(args, f);
+        vsnprintf(tmp, sizeof(tmp), f, args);
+        va_end(args);
+        return tmp;
+    }
+    void append(const char *str, const size_t n) {
+        char *nb = (char*) realloc(buf, len + n + 1);
+        if (!nb)
+            return;
+        buf = nb;
+        memmove(buf + len, str, n);
+        len += n;
+        buf[len] = 0;
+    }
+    void assign(const char *str, const size_t n) {
+        if (str == buf)
+            return;
+        len = 0;
+        append(str ? str : "", str ? n : 0);
+    }
+    std::string str() const { return std::string(c_str(), len); }
+public:
+    String(const char *str = "") { assign(str, str ? strlen(str) : 0); }
+    String(const char *str, size_t n) { assign(str, n); }
+    String(const std::string &str) { assign(str.data(), str.size()); }
+    String(const String &str) { assign(str.c_str(), str.len); }
+    String(String &&str) : buf(str.buf), len(str.len) { str.buf = nullptr; str.len = 0; }
+    explicit String(char c) { assign(&c, 1); }
+    String(int v, unsigned char base = DEC) : String(fmt(base == HEX ? "%x" : "%d", v)) {}
+    String(unsigned int v, unsigned char base = DEC) : String(fmt(base == HEX ? "%x" : "%u", v)) {}
+    String(long v, unsigned char base = DEC) : String(fmt(base == HEX ? "%lx" : "%ld", v)) {}
+    String(unsigned long v, unsigned char base = DEC) : String(fmt(base == HEX ? "%lx" : "%lu", v)) {}
+    String(float v, unsigned int dec = 2) : String(fmt("%.*f", dec, v)) {}
+    String(double v, unsigned int dec = 2) : String(fmt("%.*f", dec, v)) {}
+    ~String() { free(buf); }
+    String &operator=(const String &rhs) { if (this != &rhs) assign(rhs.c_str(), rhs.len); return *this; }
+    String &operator=(String &&rhs) { if (this != &rhs) { free(buf); buf = rhs.buf; len = rhs.len; rhs.buf = nullptr; rhs.len = 0; } return *this; }
+    String &operator=(const char *rhs) { assign(rhs, rhs ? strlen(rhs) : 0); return *this; }
+    const char *c_str() const { return buf ? buf : ""; }
+    unsigned int length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+    void clear() { len = 0; if (buf) buf[0] = 0; }
+    bool reserve(unsigned int size) { return true; }
+    bool concat(const String &str) { append(str.c_str(), str.len); return true; }
+    bool concat(const char *str) { if (str) append(str, strlen(str)); return true; }
+    bool concat(const char *str, unsigned int n) { append(str, n); return true; }
+    bool concat(char c) { append(&c, 1); return true; }
+    template<typename T> String &operator+=(const T &v) { concat(String(v)); return *this; }
+    String &operator+=(const String &str) { concat(str); return *this; }
+    String &operator+=(const char *str) { concat(str); return *this; }
+    String &operator+=(char c) { concat(c); return *this; }
+    bool operator==(const String &rhs) const { return strcmp(c_str(), rhs.c_str()) == 0; }
+    bool operator==(const char *rhs) const { return strcmp(c_str(), rhs ? rhs : "") == 0; }
+    bool operator!=(const String &rhs) const { return !(*this == rhs); }
+    bool operator!=(const char *rhs) const { return !(*this == rhs); }
+    bool operator<(const String &rhs) const { return strcmp(c_str(), rhs.c_str()) < 0; }
+    bool equals(const String &rhs) const { return *this == rhs; }
+    char operator[](unsigned int i) const { return i < len ? buf[i] : 0; }
+    char charAt(unsigned int i) const { return (*this)[i]; }
+    int compareTo(const String &rhs) const { return strcmp(c_str(), rhs.c_str()); }
+    int indexOf(char c, unsigned int from = 0) const {
+        const size_t pos = str().find(c, from);
+        return pos == std::string::npos ? -1 : (int) pos;
+    }
+    int indexOf(const String &s, unsigned int from = 0) const {
+        const size_t pos = str().find(s.str(), from);
+        return pos == std::string::npos ? -1 : (int) pos;
+    }
+    bool startsWith(const String &prefix) const { return (len >= prefix.len) && (strncmp(c_str(), prefix.c_str(), prefix.len) == 0); }
+    bool endsWith(const String &suffix) const {
+        return (len >= suffix.len) && (strcmp(c_str() + len - suffix.len, suffix.c_str()) == 0);
+    }
+    String substring(unsigned int from) const { return from < len ? String(c_str() + from, len - from) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        to = min(to, len);
+        return from < to ? String(c_str() + from, to - from) : String();
+    }
+    void remove(unsigned int index) { if (index < len) { len = index; buf[len] = 0; } }
+    void remove(unsigned int index, unsigned int count) { std::string s = str(); if (index < len) { s.erase(index, count); *this = s; } }
+    void replace(const String &find, const String &repl) {
+        if (find.len == 0)
+            return;
+        std::string s = str();
+        for (size_t pos = 0; (pos = s.find(find.str(), pos)) != std::string::npos; pos += repl.len)
+            s.replace(pos, find.len, repl.str());
+        *this = s;
+    }
+    void trim() {
+        std::string s = str();
+        const size_t first = s.find_first_not_of(" \t\r\n");
+        *this = (first == std::string::npos) ? std::string() : s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+    }
+    void toLowerCase() { for (unsigned int i=0; i<len; i++) buf[i] = tolower(buf[i]); }
+    void toUpperCase() { for (unsigned int i=0; i<len; i++) buf[i] = toupper(buf[i]); }
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return atof(c_str()); }
+};
+
+// result type of the concatenation in the Arduino core, ArduinoJson refers to it
+class StringSumHelper: public String {
+public:
+    using String::String;
+    StringSumHelper(const String &str) : String(str) {}
+};
+
+inline StringSumHelper operator+(const String &lhs, const String &rhs) {
+    StringSumHelper res(lhs);
+    res.concat(rhs);
+    return res;
+}
+
+inline StringSumHelper operator+(const String &lhs, const char *rhs) {
+    StringSumHelper res(lhs);
+    res.concat(rhs);
+    return res;
+}
+
+inline StringSumHelper operator+(const String &lhs, char rhs) {
+    StringSumHelper res(lhs);
+    res.concat(rhs);
+    return res;
+}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size) {
+        size_t n = 0;
+        while (size--)
+            n += write(*buf++);
+        return n;
+    }
+    size_t write(const char *str) {
+        return write((const uint8_t*) str, strlen(str));
+    }
+    size_t print(const String &str) {
+        return write((const uint8_t*) str.c_str(), str.length());
+    }
+    size_t print(const char *str) {
+        return write(str);
+    }
+    size_t println(const String &str) {
+        return print(str) + write("\r\n");
+    }
+    size_t printf(const char *format, ...) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        const int len = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        return (len > 0) ? write((const uint8_t*) buf, min((size_t) len, sizeof(buf) - 1)) : 0;
+    }
+};
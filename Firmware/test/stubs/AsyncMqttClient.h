@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+    Declarations of AsyncMqttClient used in headers of the modules built for the
+    host tests (env:native), the client is replaced by test/stubs/firmware.cpp.
+*/
+
+#include <stdint.h>
+
+enum class AsyncMqttClientDisconnectReason : uint8_t {
+    TCP_DISCONNECTED = 0
+};
+
+class AsyncMqttClient {
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+    Declarations of AsyncTCP used in headers of the modules built for the host
+    tests (env:native), no network.
+*/
+
+class AsyncClient {
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+    Declarations of ESPAsyncWebServer used in headers of the modules built for
+    the host tests (env:native), no web server.
+*/
+
+class AsyncWebSocketClient;
+
+enum AwsEventType {
+    WS_EVT_CONNECT,
+    WS_EVT_DISCONNECT,
+    WS_EVT_PONG,
+    WS_EVT_ERROR,
+    WS_EVT_DATA
+};
@@ -0,0 +1,364 @@
+#pragma once
+
+/*
+    Stand-in of the OpenTherm library for the host tests (env:native). The frame
+    helpers use the same encoding as the library, the interfaces run on a
+    simulated line: a frame is on the line for FRAME_TIME ms, then it is passed
+    to onTransmit of the sending interface. Without onTransmit the lines of the
+    master and the slave interface are connected (loopback test mode), a test
+    standing in for the room unit or the boiler sets onTransmit and hands its
+    frames to receive(). Callbacks run from process() like in the library: the
+    master is not ready for 100 ms after a response and times out 1 s after the
+    start of a request, the slave may respond from its callback.
+*/
+
+#include <Arduino.h>
+#include <functional>
+
+enum class OpenThermResponseStatus : uint8_t {
+    NONE,
+    SUCCESS,
+    INVALID,
+    TIMEOUT
+};
+
+enum class OpenThermMessageType : uint8_t {
+    READ_DATA = 0,
+    READ = READ_DATA,
+    WRITE_DATA = 1,
+    WRITE = WRITE_DATA,
+    INVALID_DATA = 2,
+    RESERVED = 3,
+    READ_ACK = 4,
+    WRITE_ACK = 5,
+    DATA_INVALID = 6,
+    UNKNOWN_DATA_ID = 7
+};
+
+enum class OpenThermSmartPower : uint8_t {
+    SMART_POWER_LOW,
+    SMART_POWER_MEDIUM,
+    SMART_POWER_HIGH
+};
+
+enum class OpenThermMessageID : uint8_t {
+    Status = 0,
+    TSet,
+    MConfigMMemberIDcode,
+    SConfigSMemberIDcode,
+    RemoteRequest,
+    ASFflags,
+    RBPflags,
+    CoolingControl,
+    TsetCH2,
+    TrOverride,
+    TSP,
+    TSPindexTSPvalue,
+    FHBsize,
+    FHBindexFHBvalue,
+    MaxRelModLevelSetting,
+    MaxCapacityMinModLevel,
+    TrSet,
+    RelModLevel,
+    CHPressure,
+    DHWFlowRate,
+    DayTime,
+    Date,
+    Year,
+    TrSetCH2,
+    Tr,
+    Tboiler,
+    Tdhw,
+    Toutside,
+    Tret,
+    Tstorage,
+    Tcollector,
+    TflowCH2,
+    Tdhw2,
+    Texhaust,
+    TboilerHeatExchanger,
+    BoilerFanSpeedSetpointAndActual,
+    FlameCurrent,
+    TrCH2,
+    RelativeHumidity,
+    TrOverride2,
+    TdhwSetUBTdhwSetLB = 48,
+    MaxTSetUBMaxTSetLB,
+    HcratioUBHcratioLB,
+    TdhwSet = 56,
+    MaxTSet,
+    Hcratio,
+    StatusVentilationHeatRecovery = 70,
+    Vset,
+    ASFflagsOEMfaultCodeVentilationHeatRecovery,
+    OEMDiagnosticCodeVentilationHeatRecovery,
+    SConfigSMemberIDCodeVentilationHeatRecovery,
+    OpenThermVersionVentilationHeatRecovery,
+    VentilationHeatRecoveryVersion,
+    RelVentLevel,
+    RHexhaust,
+    CO2exhaust,
+    Tsi,
+    Tso,
+    Tei,
+    Teo,
+    RPMexhaust,
+    RPMsupply,
+    RBPflagsVentilationHeatRecovery,
+    NominalVentilationValue,
+    TSPventilationHeatRecovery,
+    TSPindexTSPvalueVentilationHeatRecovery,
+    FHBsizeVentilationHeatRecovery,
+    FHBindexFHBvalueVentilationHeatRecovery,
+    Brand = 93,
+    BrandVersion,
+    BrandSerialNumber,
+    CoolingOperationHours,
+    PowerCycles,
+    RFsensorStatusInformation,
+    RemoteOverrideOperatingModeHeatingDHW,
+    RemoteOverrideFunction,
+    StatusSolarStorage,
+    ASFflagsOEMfaultCodeSolarStorage,
+    SConfigSMemberIDcodeSolarStorage,
+    SolarStorageVersion,
+    TSPSolarStorage,
+    TSPindexTSPvalueSolarStorage,
+    FHBsizeSolarStorage,
+    FHBindexFHBvalueSolarStorage,
+    ElectricityProducerStarts,
+    ElectricityProducerHours,
+    ElectricityProduction,
+    CumulativElectricityProduction,
+    UnsuccessfulBurnerStarts,
+    FlameSignalTooLowNumber,
+    OEMDiagnosticCode,
+    SuccessfulBurnerStarts,
+    CHPumpStarts,
+    DHWPumpValveStarts,
+    DHWBurnerStarts,
+    BurnerOperationHours,
+    CHPumpOperationHours,
+    DHWPumpValveOperationHours,
+    DHWBurnerOperationHours,
+    OpenThermVersionMaster,
+    OpenThermVersionSlave,
+    MasterVersion,
+    SlaveVersion
+};
+
+class OpenTherm {
+public:
+    static constexpr uint32_t FRAME_TIME = 34;      // ms, 32 bit + start and stop bit
+    static constexpr uint32_t TIMEOUT = 1000;       // ms, from the start of the request
+    static constexpr uint32_t MASTER_DELAY = 100;   // ms, not ready after a response
+private:
+    enum class State : uint8_t {
+        NOT_INITIALIZED,
+        READY,
+        SENDING,
+        RESPONSE_WAITING,
+        RECEIVED,
+        DELAY
+    } state {State::NOT_INITIALIZED};
+    const bool isSlave;
+    bool alwaysReceive {false};
+    void (*callback)(unsigned long, OpenThermResponseStatus) {nullptr};
+    unsigned long txFrame {0};
+    unsigned long rxFrame {0};
+    uint32_t stateTime {0};     // ms, start of the current state
+    uint32_t requestTime {0};   // ms, start of the last request
+    OpenThermResponseStatus lastStatus {OpenThermResponseStatus::NONE};
+    static inline OpenTherm *interfaces[2] {};
+
+    void transmit(const unsigned long frame) {
+        if (onTransmit)
+            onTransmit(frame);
+        else if (interfaces[!isSlave])
+            interfaces[!isSlave]->receive(frame);
+    }
+
+    void setState(const State st) {
+        state = st;
+        stateTime = millis();
+    }
+
+    void done(const OpenThermResponseStatus status) {
+        lastStatus = status;
+        if (callback)
+            callback(rxFrame, status);
+    }
+public:
+    // frame sent by this interface, nullptr: connected to the other interface
+    std::function<void(unsigned long frame)> onTransmit;
+
+    OpenTherm(int inPin, int outPin, bool isSlave = false):
+            isSlave(isSlave) {
+        interfaces[isSlave] = this;
+    }
+
+    ~OpenTherm() {
+        if (interfaces[isSlave] == this)
+            interfaces[isSlave] = nullptr;
+    }
+
+    // interface constructed last with this role, i.e. the one of the firmware
+    static OpenTherm *getInterface(const bool isSlave) {
+        return interfaces[isSlave];
+    }
+
+    void begin(void (*handleInterruptCallback)(void), void (*processResponseCallback)(unsigned long, OpenThermResponseStatus)) {
+        callback = processResponseCallback;
+        setState(State::READY);
+    }
+
+    bool isReady() {
+        return state == State::READY;
+    }
+
+    bool sendRequestAsync(unsigned long request) {
+        if (isSlave || !isReady())
+            return false;
+        txFrame = request;
+        requestTime = millis();
+        setState(State::SENDING);
+        return true;
+    }
+
+    bool sendResponse(unsigned long response) {
+        if (!isSlave || !isReady())
+            return false;
+        txFrame = response;
+        setState(State::SENDING);
+        return true;
+    }
+
+    // frame from the other side of the line, passed to the callback by the next process()
+    void receive(const unsigned long frame) {
+        if (isSlave) {
+            if ((state != State::READY) && (state != State::RECEIVED))
+                return; // sending
+        }
+        else if ((state != State::RESPONSE_WAITING) && !alwaysReceive)
+            return;
+        rxFrame = frame;
+        setState(State::RECEIVED);
+    }
+
+    void process() {
+        const uint32_t now = millis();
+        switch (state) {
+        case State::SENDING:
+            if (now - stateTime < FRAME_TIME)
+                break;
+            transmit(txFrame);
+            if (isSlave)
+                setState(State::READY);
+            else
+                setState(State::RESPONSE_WAITING);
+            break;
+
+        case State::RESPONSE_WAITING:
+            if (now - requestTime >= TIMEOUT) {
+                setState(State::READY);
+                done(OpenThermResponseStatus::TIMEOUT);
+            }
+            break;
+
+        case State::RECEIVED:
+            if (isSlave) {
+                setState(State::READY);
+                done(isValidRequest(rxFrame) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID);
+            }
+            else {
+                setState(State::DELAY);
+                done(isValidResponse(rxFrame) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID);
+            }
+            break;
+
+        case State::DELAY:
+            if (now - stateTime >= MASTER_DELAY)
+                setState(State::READY);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void handleInterrupt() {
+    }
+
+    void setAlwaysReceive(bool on) {
+        alwaysReceive = on;
+    }
+
+    OpenThermResponseStatus getLastResponseStatus() {
+        return lastStatus;
+    }
+
+    OpenThermSmartPower getSmartPowerState() {
+        return OpenThermSmartPower::SMART_POWER_LOW;
+    }
+
+    static bool parity(unsigned long frame) {
+        uint8_t p = 0;
+        while (frame > 0) {
+            if (frame & 1)
+                p++;
+            frame >>= 1;
+        }
+        return p & 1;
+    }
+
+    static bool isValidRequest(unsigned long request) {
+        return !parity(request) && ((request >> 28 & 7) < 4);
+    }
+
+    static bool isValidResponse(unsigned long response) {
+        return !parity(response) && ((response >> 28 & 7) >= 4);
+    }
+
+    static unsigned long buildRequest(OpenThermMessageType type, OpenThermMessageID id, unsigned int data) {
+        unsigned long request = data;
+        request |= ((unsigned long) type) << 28;
+        request |= ((unsigned long) id) << 16;
+        if (parity(request))
+            request |= 1ul << 31;
+        return request;
+    }
+
+    static unsigned long buildResponse(OpenThermMessageType type, OpenThermMessageID id, unsigned int data) {
+        return buildRequest(type, id, data);
+    }
+
+    static unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false,
+            bool enableCooling = false, bool enableOutsideTemperatureCompensation = false,
+            bool enableCentralHeating2 = false, bool summerMode = false, bool dhwBlock = false) {
+        unsigned int data = enableCentralHeating | (enableHotWater << 1) | (enableCooling << 2) |
+            (enableOutsideTemperatureCompensation << 3) | (enableCentralHeating2 << 4) | (summerMode << 5) | (dhwBlock << 6);
+        return buildRequest(OpenThermMessageType::READ_DATA, OpenThermMessageID::Status, data << 8);
+    }
+
+    static OpenThermMessageType getMessageType(unsigned long message) {
+        return (OpenThermMessageType) ((message >> 28) & 7);
+    }
+
+    static OpenThermMessageID getDataID(unsigned long frame) {
+        return (OpenThermMessageID) ((frame >> 16) & 0xFF);
+    }
+
+    static uint16_t getUInt(const unsigned long response) {
+        return response & 0xFFFF;
+    }
+
+    static float getFloat(const unsigned long response) {
+        const uint16_t u88 = getUInt(response);
+        return (u88 & 0x8000) ? -(0x10000L - u88) / 256.0f : u88 / 256.0f;
+    }
+
+    static unsigned int temperatureToData(float temperature) {
+        temperature = constrain(temperature, 0.0f, 100.0f);
+        return temperature * 256;
+    }
+};
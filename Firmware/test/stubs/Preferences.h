@@ -0,0 +1,52 @@
+#pragma once
+
+/*
+    Stand-in of the NVS preferences for the host tests (env:native), kept in
+    memory for the run of the test.
+*/
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+class Preferences {
+private:
+    static inline std::map<std::string, std::vector<uint8_t>> store;
+    std::string ns;
+    bool readOnly {true};
+public:
+    bool begin(const char *name, bool readOnly = false) {
+        ns = name;
+        this->readOnly = readOnly;
+        return true;
+    }
+
+    void end() {
+    }
+
+    size_t getBytesLength(const char *key) {
+        auto it = store.find(ns + '/' + key);
+        return (it == store.end()) ? 0 : it->second.size();
+    }
+
+    size_t getBytes(const char *key, void *buf, size_t maxLen) {
+        auto it = store.find(ns + '/' + key);
+        if ((it == store.end()) || (it->second.size() > maxLen))
+            return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putBytes(const char *key, const void *value, size_t len) {
+        if (readOnly)
+            return 0;
+        const uint8_t *p = (const uint8_t*) value;
+        store[ns + '/' + key].assign(p, p + len);
+        return len;
+    }
+
+    bool clear() {
+        store.clear();
+        return true;
+    }
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+    Stand-in of the WiFi driver for the host tests (env:native), never connected.
+*/
+
+#include <Arduino.h>
+
+class WiFiClass {
+public:
+    String macAddress() {
+        return "02:00:00:00:00:01";
+    }
+
+    int8_t RSSI() {
+        return 0;
+    }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,119 @@
+/*
+    Seams of the host tests (env:native): the modules of the firmware which are
+    not built there (sensors, MQTT, portal) reduced to what OTControl uses.
+    Sensors behave like the real ones, MQTT and the portal discard everything.
+*/
+
+#include "sensors.h"
+#include "mqtt.h"
+#include "portal.h"
+
+Sensor roomTemp[2];
+AutoSensor roomSetPoint[2];
+OutsideTemp outsideTemp;
+OneWireNode *oneWireNode = nullptr;
+Sensor *Sensor::lastSensor = nullptr;
+Mqtt mqtt;
+Portal portal;
+
+Sensor::Sensor():
+        own(nullptr),
+        src(SOURCE_NA),
+        value(0),
+        setFlag(false) {
+    prevSensor = lastSensor;
+    lastSensor = this;
+}
+
+void Sensor::set(const float val, const Source src) {
+    if (src == this->src) {
+        this->value = roundf(val * 10) / 10;
+        setFlag = true;
+    }
+}
+
+bool Sensor::get(float &val) {
+    if (setFlag) {
+        val = this->value;
+        return true;
+    }
+    return false;
+}
+
+void Sensor::setConfig(JsonObject &obj) {
+    src = (Source) (obj["source"] | (int) SOURCE_NA);
+    setFlag = false;
+    own = nullptr;
+}
+
+bool Sensor::isMqttSource() {
+    return (src == SOURCE_MQTT) || (src == SOURCE_AUTO);
+}
+
+bool Sensor::isOtSource() {
+    return (src == SOURCE_OT);
+}
+
+void Sensor::loopAll() {
+    for (Sensor *item = lastSensor; item; item = item->prevSensor)
+        item->loop();
+}
+
+AutoSensor::AutoSensor() {
+    memset(values, 0, sizeof(values));
+}
+
+void AutoSensor::set(const float val, const Source src) {
+    if (this->src == SOURCE_AUTO) {
+        if (val != values[src]) {
+            Sensor::set(val, this->src);
+            values[src] = val;
+        }
+    }
+    else
+        Sensor::set(val, src);
+}
+
+OutsideTemp::OutsideTemp():
+        nextMillis(0),
+        interval(0),
+        lat(0),
+        lon(0),
+        httpState(HTTP_IDLE) {
+}
+
+void OutsideTemp::setConfig(JsonObject &obj) {
+    Sensor::setConfig(obj);
+}
+
+void OutsideTemp::loop() {
+}
+
+Mqtt::Mqtt():
+        lastConTry(0),
+        lastStatus(0),
+        configSet(false),
+        conFlag(false) {
+}
+
+String Mqtt::getTopicString(const MqttTopic topic) {
+    return String((int) topic);
+}
+
+String Mqtt::getCmdTopic(const MqttTopic topic) {
+    return getTopicString(topic) + "/set";
+}
+
+bool Mqtt::publish(String topic, JsonDocument &payload, const bool retain) {
+    return true;
+}
+
+Portal::Portal():
+        reboot(false),
+        updateEnable(true) {
+    memset(statusClients, 0, sizeof(statusClients));
+    statusMutex = xSemaphoreCreateMutex();
+}
+
+void Portal::textAll(String text) {
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+    Stand-in of FreeRTOS for the host tests (env:native). Everything runs in the
+    thread of the test: tasks are not started, the test calls their loop and so
+    runs as the task created last. Semaphores and queues don't block, a take or
+    receive that would block fails, vTaskDelay() advances the clock.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+namespace stub {
+    struct Queue {
+        size_t itemSize;
+        size_t length;
+        std::deque<std::vector<uint8_t>> items;
+        bool isStatic;
+    };
+
+    struct Task {
+        TaskFunction_t func;
+        void *arg;
+    };
+
+    inline Task *currentTask = nullptr;
+
+    // clock of the Arduino core, set by the tests, a delay of the task advances it
+    inline unsigned long ms = 0;
+    inline unsigned long us = 0;
+
+    // sets both clocks
+    inline void setMillis(const unsigned long t) {
+        ms = t;
+        us = t * 1000;
+    }
+}
+
+typedef stub::Queue *QueueHandle_t;
+typedef stub::Queue *SemaphoreHandle_t;
+typedef stub::Task *TaskHandle_t;
+
+struct StaticSemaphore_t {
+    stub::Queue queue;
+};
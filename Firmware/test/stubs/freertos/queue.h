@@ -0,0 +1,33 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return new stub::Queue {itemSize, length, {}, false};
+}
+
+inline void vQueueDelete(QueueHandle_t queue) {
+    if (!queue->isStatic)
+        delete queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t) {
+    if (queue->items.size() >= queue->length)
+        return pdFALSE;
+    const uint8_t *p = (const uint8_t*) item;
+    queue->items.emplace_back(p, p + queue->itemSize);
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t) {
+    if (queue->items.empty())
+        return pdFALSE;
+    if (item && queue->itemSize)
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return queue->items.size();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "queue.h"
+
+// semaphores are queues of empty items, a mutex is given initially
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return xQueueCreate(1, 0);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf) {
+    buf->queue = {0, 1, {}, true};
+    return &buf->queue;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+    xQueueSend(sem, nullptr, 0);
+    return sem;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    return xQueueReceive(sem, nullptr, ticks);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return xQueueSend(sem, nullptr, 0);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    vQueueDelete(sem);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *, uint32_t, void *arg, UBaseType_t,
+        TaskHandle_t *handle, BaseType_t) {
+    stub::currentTask = new stub::Task {func, arg};
+    if (handle)
+        *handle = stub::currentTask;
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t func, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+        TaskHandle_t *handle) {
+    return xTaskCreatePinnedToCore(func, name, stack, arg, prio, handle, tskNO_AFFINITY);
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return stub::currentTask;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    stub::setMillis(stub::ms + (ticks > 0 ? ticks : 1) * portTICK_PERIOD_MS);
+}
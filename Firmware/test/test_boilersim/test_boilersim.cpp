@@ -0,0 +1,129 @@
+#include <unity.h>
+#include "boilersim.h"
+
+static BoilerSim *sim;
+
+static unsigned long request(const OpenThermMessageType type, const OpenThermMessageID id, const uint16_t data) {
+    return sim->handleRequest(OpenTherm::buildRequest(type, id, data));
+}
+
+static unsigned long read(const OpenThermMessageID id) {
+    return request(OpenThermMessageType::READ_DATA, id, 0);
+}
+
+// master status every second like a room unit, flags in the high byte
+static void run(const uint32_t s, const uint8_t masterStatus) {
+    for (uint32_t i=0; i<s; i++) {
+        stub::setMillis(millis() + 1000);
+        request(OpenThermMessageType::READ_DATA, OpenThermMessageID::Status, masterStatus << 8);
+    }
+}
+
+void setUp() {
+    stub::setMillis(1000);
+    sim = new BoilerSim();
+}
+
+void tearDown() {
+    delete sim;
+}
+
+void test_ch_heat_up() {
+    TEST_ASSERT_EQUAL_HEX32(OpenTherm::buildResponse(OpenThermMessageType::WRITE_ACK, OpenThermMessageID::TSet, 0x3C00),
+        request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x3C00));
+
+    run(10, 1<<0);
+    unsigned long resp = read(OpenThermMessageID::Status);
+    TEST_ASSERT_EQUAL(OpenThermMessageType::READ_ACK, OpenTherm::getMessageType(resp));
+    TEST_ASSERT_EQUAL_HEX16(1<<3, resp & (1<<3)); // flame
+    TEST_ASSERT_GREATER_THAN_FLOAT(5, OpenTherm::getFloat(read(OpenThermMessageID::RelModLevel)));
+
+    // the proportional modulation settles a few K below TSet, the burner switches off 3 K above
+    run(3600, 1<<0);
+    const float flow = OpenTherm::getFloat(read(OpenThermMessageID::Tboiler));
+    TEST_ASSERT_GREATER_THAN_FLOAT(55, flow);
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(63, flow);
+    const float ret = OpenTherm::getFloat(read(OpenThermMessageID::Tret));
+    TEST_ASSERT_LESS_THAN_FLOAT(flow, ret);
+    TEST_ASSERT_GREATER_THAN_FLOAT(20, ret);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, OpenTherm::getUInt(read(OpenThermMessageID::SuccessfulBurnerStarts)));
+}
+
+void test_ch_cool_down() {
+    request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x3C00);
+    run(3600, 1<<0);
+
+    // CH disabled: burner off, the water cools down to room temperature
+    run(10, 0);
+    TEST_ASSERT_EQUAL_HEX16(0, OpenTherm::getUInt(read(OpenThermMessageID::Status)) & (1<<3));
+    TEST_ASSERT_EQUAL_FLOAT(0, OpenTherm::getFloat(read(OpenThermMessageID::RelModLevel)));
+    run(4 * 3600, 0);
+    TEST_ASSERT_FLOAT_WITHIN(2, 20, OpenTherm::getFloat(read(OpenThermMessageID::Tboiler)));
+}
+
+void test_dhw_priority() {
+    request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x2800);
+    request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TdhwSet, 0x3C00);
+
+    // storage 15 K below its set point is reheated first, CH mode is off meanwhile
+    run(10, (1<<0) | (1<<1));
+    const uint16_t status = OpenTherm::getUInt(read(OpenThermMessageID::Status));
+    TEST_ASSERT_EQUAL_HEX16(1<<2, status & (1<<2));
+    TEST_ASSERT_EQUAL_HEX16(0, status & (1<<1));
+
+    run(3600, (1<<0) | (1<<1));
+    TEST_ASSERT_GREATER_THAN_FLOAT(55, OpenTherm::getFloat(read(OpenThermMessageID::Tdhw)));
+    TEST_ASSERT_EQUAL_FLOAT(60, OpenTherm::getFloat(read(OpenThermMessageID::TdhwSet)));
+}
+
+void test_unknown_id() {
+    // no simulation and no loopback test data
+    unsigned long resp = read(OpenThermMessageID::TSP);
+    TEST_ASSERT_EQUAL(OpenThermMessageType::UNKNOWN_DATA_ID, OpenTherm::getMessageType(resp));
+    TEST_ASSERT_EQUAL(OpenThermMessageID::TSP, OpenTherm::getDataID(resp));
+    TEST_ASSERT_TRUE(OpenTherm::isValidResponse(resp));
+
+    // a value of the slave isn't written by the master
+    resp = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::Tboiler, 0x3200);
+    TEST_ASSERT_EQUAL(OpenThermMessageType::UNKNOWN_DATA_ID, OpenTherm::getMessageType(resp));
+    TEST_ASSERT_EQUAL_HEX16(0x3200, OpenTherm::getUInt(resp));
+
+    // loopback test data
+    resp = read(OpenThermMessageID::CHPressure);
+    TEST_ASSERT_EQUAL(OpenThermMessageType::READ_ACK, OpenTherm::getMessageType(resp));
+
+    resp = request(OpenThermMessageType::INVALID_DATA, OpenThermMessageID::Tboiler, 0);
+    TEST_ASSERT_EQUAL(OpenThermMessageType::DATA_INVALID, OpenTherm::getMessageType(resp));
+}
+
+static void setLatency(const char *json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    sim->setConfig(doc.as<JsonObject>());
+}
+
+void test_latency() {
+    TEST_ASSERT_EQUAL_UINT16(20, sim->latency);
+    setLatency(R"({"latency": 100})");
+    TEST_ASSERT_EQUAL_UINT16(100, sim->latency);
+    setLatency(R"({"latency": 0})");
+    TEST_ASSERT_EQUAL_UINT16(0, sim->latency);
+
+    // replies have to be sent within 800 ms
+    setLatency(R"({"latency": 2000})");
+    TEST_ASSERT_EQUAL_UINT16(750, sim->latency);
+    setLatency(R"({"latency": -5})");
+    TEST_ASSERT_EQUAL_UINT16(0, sim->latency);
+    setLatency("{}");
+    TEST_ASSERT_EQUAL_UINT16(20, sim->latency);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ch_heat_up);
+    RUN_TEST(test_ch_cool_down);
+    RUN_TEST(test_dhw_priority);
+    RUN_TEST(test_unknown_id);
+    RUN_TEST(test_latency);
+    return UNITY_END();
+}
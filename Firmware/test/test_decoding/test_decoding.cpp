@@ -0,0 +1,74 @@
+#include <unity.h>
+#include "otdata.h"
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_f88_positive() {
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, f88ToFloat(0x0000));
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, f88ToFloat(0x0100));
+    TEST_ASSERT_EQUAL_FLOAT(48.5f, f88ToFloat(0x3080));
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, f88ToFloat(0x6400));
+    TEST_ASSERT_EQUAL_FLOAT(127.0f, f88ToFloat(0x7F00));
+}
+
+void test_f88_negative() {
+    // two's complement, not sign / magnitude
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, f88ToFloat(0xFF80));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, f88ToFloat(0xFF00));
+    TEST_ASSERT_EQUAL_FLOAT(-5.5f, f88ToFloat(0xFA80));
+    TEST_ASSERT_EQUAL_FLOAT(-40.0f, f88ToFloat(0xD800));
+    TEST_ASSERT_EQUAL_FLOAT(-128.0f, f88ToFloat(0x8000));
+}
+
+void test_f88_rounding() {
+    // to 0.1, half away from zero
+    TEST_ASSERT_EQUAL_FLOAT(21.3f, f88ToFloat(0x154D)); // 21.30078
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, f88ToFloat(0x0019)); // 0.09766
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, f88ToFloat(0x000C)); // 0.04688
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, f88ToFloat(0x000D)); // 0.05078
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, f88ToFloat(0xFFF4)); // -0.04688
+    TEST_ASSERT_EQUAL_FLOAT(-0.1f, f88ToFloat(0xFFF3)); // -0.05078
+}
+
+void test_f88_all() {
+    // every value within 0.05 of the exact value
+    for (uint32_t d=0; d<=0xFFFF; d++) {
+        const double exact = (int16_t) d / 256.0;
+        TEST_ASSERT_DOUBLE_WITHIN(0.0501, exact, f88ToFloat(d));
+    }
+}
+
+void test_float_to_f88() {
+    TEST_ASSERT_EQUAL_HEX16(0x0000, floatToF88(0));
+    TEST_ASSERT_EQUAL_HEX16(0x3080, floatToF88(48.5f));
+    TEST_ASSERT_EQUAL_HEX16(0xFF80, floatToF88(-0.5f));
+    TEST_ASSERT_EQUAL_HEX16(0xD800, floatToF88(-40));
+}
+
+void test_float_to_f88_limits() {
+    TEST_ASSERT_EQUAL_HEX16(0x6400, floatToF88(100));
+    TEST_ASSERT_EQUAL_HEX16(0x6400, floatToF88(250));
+    TEST_ASSERT_EQUAL_HEX16(0x9C00, floatToF88(-100));
+    TEST_ASSERT_EQUAL_HEX16(0x9C00, floatToF88(-250));
+}
+
+void test_round_trip() {
+    for (int t=-1000; t<=1000; t++)
+        TEST_ASSERT_EQUAL_FLOAT(t / 10.0f, f88ToFloat(floatToF88(t / 10.0f)));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_f88_positive);
+    RUN_TEST(test_f88_negative);
+    RUN_TEST(test_f88_rounding);
+    RUN_TEST(test_f88_all);
+    RUN_TEST(test_float_to_f88);
+    RUN_TEST(test_float_to_f88_limits);
+    RUN_TEST(test_round_trip);
+    return UNITY_END();
+}
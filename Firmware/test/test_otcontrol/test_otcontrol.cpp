@@ -0,0 +1,186 @@
+#include <unity.h>
+#include <vector>
+#include "otcontrol.h"
+
+/*
+    OTControl in loopback test mode: the master interface polls BoilerSim through
+    the simulated line. The frames on the line are recorded with their time.
+*/
+
+struct Frame {
+    uint32_t time;
+    unsigned long frame;
+};
+
+static std::vector<Frame> requests;
+static std::vector<Frame> responses;
+
+static const char CONFIG[] = R"({
+    "otMode": 4,
+    "heating": [{"chOn": true, "flow": 50, "flowMax": 60}, {"chOn": false}],
+    "boiler": {"dhwOn": true, "dhwTemperature": 50},
+    "sim": {"latency": 20}
+})";
+
+// advances the time in steps of 1 ms, the OT task calls loop() at least once per tick
+static void run(const uint32_t ms) {
+    for (const uint32_t end = millis() + ms; millis() != end; ) {
+        stub::setMillis(millis() + 1);
+        otcontrol.loop();
+    }
+}
+
+static void configure(const char *json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    JsonObject config = doc.as<JsonObject>();
+    otcontrol.setConfig(config);
+}
+
+static JsonDocument status() {
+    JsonDocument doc;
+    JsonObject obj = doc.to<JsonObject>();
+    otcontrol.getJson(obj);
+    return doc;
+}
+
+static std::vector<uint32_t> requestTimes(const OpenThermMessageID id) {
+    std::vector<uint32_t> times;
+    for (auto &f: requests)
+        if (OpenTherm::getDataID(f.frame) == id)
+            times.push_back(f.time);
+    return times;
+}
+
+static uint32_t maxGap(const std::vector<uint32_t> &times) {
+    uint32_t gap = 0;
+    for (size_t i=1; i<times.size(); i++)
+        gap = max(gap, times[i] - times[i - 1]);
+    return gap;
+}
+
+void setUp() {
+    requests.clear();
+    responses.clear();
+}
+
+void tearDown() {
+}
+
+void test_begin() {
+    static bool started = false;
+    if (!started) {
+        otcontrol.begin();
+        started = true;
+    }
+
+    OpenTherm *master = OpenTherm::getInterface(false);
+    OpenTherm *slave = OpenTherm::getInterface(true);
+    TEST_ASSERT_NOT_NULL(master);
+    TEST_ASSERT_NOT_NULL(slave);
+    master->onTransmit = [slave](unsigned long frame) {
+        requests.push_back({(uint32_t) millis(), frame});
+        slave->receive(frame);
+    };
+    slave->onTransmit = [master](unsigned long frame) {
+        responses.push_back({(uint32_t) millis(), frame});
+        master->receive(frame);
+    };
+
+    configure(CONFIG);
+    run(1000);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, requests.size());
+}
+
+// one simulated hour of polling
+void test_cadence() {
+    run(3600000);
+
+    // OT spec: the master sends the status at least once per second
+    const auto statusTimes = requestTimes(OpenThermMessageID::Status);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(3600, statusTimes.size());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(1000, maxGap(statusTimes));
+
+    // flow temperature polled every 10 s
+    const auto flow = requestTimes(OpenThermMessageID::Tboiler);
+    TEST_ASSERT_UINT32_WITHIN(10, 360, flow.size());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(11000, maxGap(flow));
+
+    // the unchanged CH set point is refreshed every 30 s, not more often than every 10 s
+    const auto tset = requestTimes(OpenThermMessageID::TSet);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(119, tset.size());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(360, tset.size());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(31000, maxGap(tset));
+
+    // IDs the boiler doesn't know are disabled, then reprobed one at a time
+    uint32_t unknown[256] {};
+    for (auto &f: responses)
+        if (OpenTherm::getMessageType(f.frame) == OpenThermMessageType::UNKNOWN_DATA_ID)
+            unknown[(uint8_t) OpenTherm::getDataID(f.frame)]++;
+    uint32_t numUnknown = 0;
+    for (int id=0; id<256; id++) {
+        if (unknown[id] == 0)
+            continue;
+        numUnknown++;
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(3, requestTimes((OpenThermMessageID) id).size());
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, numUnknown);
+
+    // every request answered in time
+    TEST_ASSERT_UINT32_WITHIN(1, requests.size(), responses.size());
+    JsonDocument doc = status();
+    TEST_ASSERT_EQUAL_UINT32(0, doc["slave"]["timeouts"].as<uint32_t>());
+    TEST_ASSERT_TRUE(doc["slave"]["connected"].as<bool>());
+    TEST_ASSERT_EQUAL_UINT32(0, doc["scheduler"]["missed"].as<uint32_t>());
+}
+
+// values decoded from the simulated boiler
+void test_values() {
+    run(60000);
+    JsonDocument doc = status();
+    JsonObject slave = doc["slave"];
+
+    // the burner holds the flow temperature in its hysteresis around TSet
+    TEST_ASSERT_TRUE(slave["flow_t"].is<float>());
+    TEST_ASSERT_FLOAT_WITHIN(4, 50, slave["flow_t"].as<float>());
+    TEST_ASSERT_TRUE(slave["rel_mod"].is<float>());
+    TEST_ASSERT_FALSE(slave["status"].isNull());
+    TEST_ASSERT_EQUAL_FLOAT(50, doc["thermostat"]["ch_set_t"].as<float>());
+}
+
+// time from the end of a request to the end of its response
+static void checkLatency(const uint32_t latency) {
+    TEST_ASSERT_GREATER_THAN_UINT32(0, responses.size());
+    size_t r = 0;
+    for (auto &req: requests) {
+        while ((r < responses.size()) && (responses[r].time < req.time))
+            r++;
+        if (r == responses.size())
+            break;
+        TEST_ASSERT_EQUAL(OpenTherm::getDataID(req.frame), OpenTherm::getDataID(responses[r].frame));
+        TEST_ASSERT_UINT32_WITHIN(2, latency + OpenTherm::FRAME_TIME, responses[r].time - req.time);
+    }
+}
+
+void test_latency() {
+    run(10000);
+    checkLatency(20);
+
+    configure(R"({"otMode": 4, "heating": [{"chOn": true, "flow": 50, "flowMax": 60}], "sim": {"latency": 300}})");
+    requests.clear();
+    responses.clear();
+    run(10000);
+    checkLatency(300);
+    TEST_ASSERT_EQUAL_UINT32(0, status()["slave"]["timeouts"].as<uint32_t>());
+
+    configure(CONFIG);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin);
+    RUN_TEST(test_cadence);
+    RUN_TEST(test_values);
+    RUN_TEST(test_latency);
+    return UNITY_END();
+}
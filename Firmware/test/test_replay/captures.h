@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+    Frame logs for the replay test as written by the websocket / TCP log, one
+    frame per line.
+
+    RAM786: repeater between a Honeywell RAM 786 room unit and a boiler without
+    overrides. The room unit reads TrSet (out of spec), the boiler doesn't know
+    the ID. The last request times out.
+
+    OVERRIDE: the same room unit with OVERRIDE_CONFIG, CH1 flow and DHW set point
+    overridden, TrOverride blocked and MaxRelModLevelSetting answered locally.
+*/
+
+static const char RAM786[] = R"(
+T00000300 READ status data 0x300
+Bc000030a READ_ACK status data 0x30a
+T10012d00 WRITE ch_set_t data 0x2d00
+Bd0012d00 WRITE_ACK ch_set_t data 0x2d00
+T00101480 READ room_set_t data 0x1480
+Bf0101480 UKNOWN ID room_set_t data 0x1480
+T101813c0 WRITE room_t data 0x13c0
+Bd01813c0 WRITE_ACK room_t data 0x13c0
+T80190000 READ flow_t data 0x0
+B40192f80 READ_ACK flow_t data 0x2f80
+T801c0000 READ return_t data 0x0
+B401c2640 READ_ACK return_t data 0x2640
+T00110000 READ rel_mod data 0x0
+B40112a00 READ_ACK rel_mod data 0x2a00
+T001b0000 READ outside_t data 0x0
+B401b0680 READ_ACK outside_t data 0x680
+T801a0000 READ dhw_t data 0x0
+B401a3300 READ_ACK dhw_t data 0x3300
+T80380000 READ dhw_set_t data 0x0
+Bc0383200 READ_ACK dhw_set_t data 0x3200
+T900e6400 WRITE max_rel_mod data 0x6400
+B500e6400 WRITE_ACK max_rel_mod data 0x6400
+T00000300 READ status data 0x300
+Bc000030a READ_ACK status data 0x30a
+T80190000 READ flow_t data 0x0
+X80190000 READ flow_t data 0x0
+)";
+
+static const char OVERRIDE_CONFIG[] = R"({
+    "otMode": 2,
+    "heating": [{"chOn": true, "flow": 55, "flowMax": 60, "overrideFlow": true}, {"chOn": false}],
+    "boiler": {"dhwOn": true, "dhwTemperature": 48, "overrideDhw": true},
+    "repeaterRules": [
+        {"id": 9, "action": "block"},
+        {"id": 14, "types": ["WRITE_DATA"], "action": "answer", "dataMask": "0"}
+    ]
+})";
+
+static const char OVERRIDE[] = R"(
+T00000000 READ status data 0x0
+R00000300 READ status data 0x300
+B40000302 READ_ACK status data 0x302
+T10012d00 WRITE ch_set_t data 0x2d00
+R90013700 WRITE ch_set_t data 0x3700
+B50013700 WRITE_ACK ch_set_t data 0x3700
+T90383700 WRITE dhw_set_t data 0x3700
+R10383000 WRITE dhw_set_t data 0x3000
+Bd0383000 WRITE_ACK dhw_set_t data 0x3000
+T80380000 READ dhw_set_t data 0x0
+B40383000 READ_ACK dhw_set_t data 0x3000
+Ae0380000 DATA_INVALID dhw_set_t data 0x0
+S00090000 READ tr_override data 0x0
+S900e6400 WRITE max_rel_mod data 0x6400
+P500e6400 WRITE_ACK max_rel_mod data 0x6400
+T80190000 READ flow_t data 0x0
+Bc0193400 READ_ACK flow_t data 0x3400
+)";
@@ -0,0 +1,210 @@
+#include <unity.h>
+#include <chrono>
+#include <string>
+#include "otcontrol.h"
+#include "otreplay.h"
+#include "sensors.h"
+#include "captures.h"
+
+/*
+    Recorded frame logs replayed through OTControl in repeater mode, as uploaded
+    to POST /replay. Checks the frames OTControl sends instead of the recorded
+    ones and the state it ends up in.
+*/
+
+static const char REPEATER_CONFIG[] = R"({
+    "otMode": 2,
+    "heating": [{"chOn": true, "flow": 50, "flowMax": 60}, {"chOn": false}],
+    "boiler": {"dhwOn": true, "dhwTemperature": 50}
+})";
+
+static void configure(const char *json) {
+    JsonDocument doc;
+    deserializeJson(doc, json);
+    JsonObject config = doc.as<JsonObject>();
+    otcontrol.setConfig(config);
+}
+
+static void setSensorSources(const int source) {
+    JsonDocument doc;
+    doc[F("source")] = source;
+    JsonObject obj = doc.as<JsonObject>();
+    roomSetPoint[0].setConfig(obj);
+    roomTemp[0].setConfig(obj);
+}
+
+// upload in chunks like the web server, replay as fast as possible
+static bool replay(const std::string &log, const size_t chunk = 100) {
+    OTReplay::Upload *up = OTReplay::Upload::create();
+    TEST_ASSERT_NOT_NULL(up);
+    for (size_t i=0; i<log.size(); i+=chunk)
+        up->write((const uint8_t*) log.data() + i, min(chunk, log.size() - i));
+    if (!up->finish() || !otreplay.load(up, 0)) {
+        free(up);
+        return false;
+    }
+
+    for (uint32_t n=0; otreplay.isRunning() && (n < 100000); n++) {
+        stub::setMillis(millis() + 1);
+        otcontrol.loop();
+    }
+    return !otreplay.isRunning();
+}
+
+// replay result with the state of OTControl parsed
+static JsonDocument result() {
+    JsonDocument doc;
+    JsonObject obj = doc.to<JsonObject>();
+    otreplay.getJson(obj);
+    String str;
+    serializeJson(doc, str);
+    JsonDocument res;
+    deserializeJson(res, str);
+    return res;
+}
+
+static uint32_t ruleHits(JsonDocument &doc, const char *dir, const OpenThermMessageID id) {
+    uint32_t hits = 0;
+    for (JsonObject jr: doc[F("state")][F("repeaterRules")][F("rules")].as<JsonArray>())
+        if ( (strcmp(jr[F("dir")] | "", dir) == 0) && (jr[F("id")].as<int>() == (int) id) )
+            hits += jr[F("hits")].as<uint32_t>();
+    return hits;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_begin() {
+    otcontrol.begin();
+    configure(REPEATER_CONFIG);
+    setSensorSources(Sensor::SOURCE_OT);
+    for (int i=0; i<1000; i++) {
+        stub::setMillis(millis() + 1);
+        otcontrol.loop();
+    }
+    TEST_ASSERT_FALSE(otreplay.isRunning());
+}
+
+void test_ram786() {
+    TEST_ASSERT_TRUE(replay(RAM786));
+
+    JsonDocument doc = result();
+    TEST_ASSERT_EQUAL_UINT32(26, doc[F("frames")].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(26, doc[F("fed")].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(25, doc[F("checked")].as<uint32_t>()); // all but the timeout
+    TEST_ASSERT_EQUAL_UINT32(0, doc[F("mismatches")].as<uint32_t>());
+
+    // requests of the room unit, values rounded to 0.1
+    JsonObject thermostat = doc[F("state")][F("thermostat")];
+    TEST_ASSERT_EQUAL_FLOAT(45, thermostat[F("ch_set_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(20.5, thermostat[F("room_set_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(19.8, thermostat[F("room_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(100, thermostat[F("max_rel_mod")].as<float>());
+
+    // responses of the boiler
+    JsonObject slave = doc[F("state")][F("slave")];
+    TEST_ASSERT_EQUAL_FLOAT(47.5, slave[F("flow_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(38.3, slave[F("return_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(42, slave[F("rel_mod")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(6.5, slave[F("outside_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(51, slave[F("dhw_t")].as<float>());
+
+    // TrSet read by the room unit sets the room set point
+    JsonObject hc = doc[F("state")][F("heatercircuit")][0];
+    TEST_ASSERT_EQUAL_FLOAT(20.5, hc[F("roomsetpoint")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(19.8, hc[F("roomtemp")].as<float>());
+
+    // no override configured, the status rule passes the frames unmodified
+    TEST_ASSERT_EQUAL_UINT32(2, ruleHits(doc, "req", OpenThermMessageID::Status));
+    TEST_ASSERT_EQUAL_UINT32(0, ruleHits(doc, "req", OpenThermMessageID::TSet));
+}
+
+void test_override() {
+    configure(OVERRIDE_CONFIG);
+    TEST_ASSERT_TRUE(replay(OVERRIDE));
+
+    JsonDocument doc = result();
+    TEST_ASSERT_EQUAL_UINT32(17, doc[F("frames")].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(12, doc[F("fed")].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(12, doc[F("checked")].as<uint32_t>());
+    TEST_ASSERT_EQUAL_UINT32(0, doc[F("mismatches")].as<uint32_t>());
+
+    // the values as forwarded to the boiler
+    JsonObject thermostat = doc[F("state")][F("thermostat")];
+    TEST_ASSERT_EQUAL_FLOAT(55, thermostat[F("ch_set_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(48, thermostat[F("dhw_set_t")].as<float>());
+    TEST_ASSERT_EQUAL_FLOAT(52, doc[F("state")][F("slave")][F("flow_t")].as<float>());
+
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "req", OpenThermMessageID::Status));
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "req", OpenThermMessageID::TSet));
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "req", OpenThermMessageID::TdhwSet));
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "resp", OpenThermMessageID::TdhwSet));
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "req", OpenThermMessageID::TrOverride));
+    TEST_ASSERT_EQUAL_UINT32(1, ruleHits(doc, "req", OpenThermMessageID::MaxRelModLevelSetting));
+}
+
+// the override log doesn't match a repeater without the overrides
+void test_mismatch() {
+    configure(REPEATER_CONFIG);
+    TEST_ASSERT_TRUE(replay(OVERRIDE));
+
+    JsonDocument doc = result();
+    // Status, TSet, TdhwSet rewritten, TdhwSet response replaced, TrOverride and MaxRelModLevelSetting forwarded
+    TEST_ASSERT_EQUAL_UINT32(6, doc[F("mismatches")].as<uint32_t>());
+    JsonObject mm = doc[F("mismatch")][1];
+    TEST_ASSERT_EQUAL_STRING("T", mm[F("source")].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("10012D00", mm[F("frame")].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("10012D00", mm[F("out")].as<const char*>());
+    TEST_ASSERT_EQUAL_STRING("90013700", mm[F("expected")].as<const char*>());
+}
+
+// lines without a frame and blanks are skipped, the upload is split anywhere
+void test_upload() {
+    const std::string log = std::string("OT log\r\n  ") + RAM786 + "\ngarbage\nT1234\n";
+    for (size_t chunk: {1, 7, 4096}) {
+        OTReplay::Upload *up = OTReplay::Upload::create();
+        up->write((const uint8_t*) log.data(), log.size());
+        TEST_ASSERT_TRUE(up->finish());
+        free(up);
+        TEST_ASSERT_TRUE(replay(log, chunk));
+        TEST_ASSERT_EQUAL_UINT32(26, result()[F("frames")].as<uint32_t>());
+    }
+
+    // nothing to replay
+    OTReplay::Upload *up = OTReplay::Upload::create();
+    up->write((const uint8_t*) "hello\n", 6);
+    TEST_ASSERT_FALSE(up->finish());
+    free(up);
+}
+
+// frames per second through OnRxSlave() / OnRxMaster() on the host
+void test_throughput() {
+    configure(REPEATER_CONFIG);
+    std::string log;
+    while (log.size() + sizeof(RAM786) < OTReplay::MAX_FRAMES * 20)
+        log += RAM786;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    TEST_ASSERT_TRUE(replay(log, 4096));
+    const auto dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    JsonDocument doc = result();
+    TEST_ASSERT_EQUAL_UINT32(0, doc[F("mismatches")].as<uint32_t>());
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%u frames, %.0f frames/s", doc[F("fed")].as<uint32_t>(), doc[F("fed")].as<uint32_t>() / dt);
+    TEST_MESSAGE(msg);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin);
+    RUN_TEST(test_ram786);
+    RUN_TEST(test_override);
+    RUN_TEST(test_mismatch);
+    RUN_TEST(test_upload);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
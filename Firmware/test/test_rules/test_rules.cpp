@@ -0,0 +1,150 @@
+#include <unity.h>
+#include "otrules.h"
+
+static OTRules rules;
+static bool cond[5];
+static bool sourceValid;
+static uint16_t sourceValue;
+
+static unsigned long request(const OpenThermMessageType type, const OpenThermMessageID id, const uint16_t data) {
+    return OpenTherm::buildRequest(type, id, data);
+}
+
+static unsigned long response(const OpenThermMessageType type, const OpenThermMessageID id, const uint16_t data) {
+    return OpenTherm::buildResponse(type, id, data);
+}
+
+void setUp() {
+    memset(cond, 0, sizeof(cond));
+    sourceValid = true;
+    sourceValue = 0;
+    rules.setFunctions(
+        [](const OTRules::RuleCond c) {
+            return cond[c];
+        },
+        [](const OTRules::RuleSource src, const uint16_t data, uint16_t &value) {
+            value = (src == OTRules::SRC_STATUS) ? (data | sourceValue) : sourceValue;
+            return sourceValid;
+        });
+}
+
+void tearDown() {
+}
+
+void test_forward_unchanged() {
+    const unsigned long msg = request(OpenThermMessageType::READ_DATA, OpenThermMessageID::Tboiler, 0);
+    unsigned long m = msg;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_REQUEST, m));
+    TEST_ASSERT_EQUAL_HEX32(msg, m);
+}
+
+void test_flow_override_inactive() {
+    const unsigned long msg = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x2800);
+    unsigned long m = msg;
+    sourceValue = 0x3200;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_REQUEST, m));
+    TEST_ASSERT_EQUAL_HEX32(msg, m);
+}
+
+void test_flow_override() {
+    unsigned long m = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x2800);
+    cond[OTRules::COND_OVERRIDE_CH1] = true;
+    sourceValue = 0x3200;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_REQUEST, m));
+    TEST_ASSERT_EQUAL_HEX32(request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x3200), m);
+    TEST_ASSERT_FALSE(OpenTherm::parity(m));
+}
+
+void test_flow_override_read_not_matched() {
+    const unsigned long msg = request(OpenThermMessageType::READ_DATA, OpenThermMessageID::TSet, 0);
+    unsigned long m = msg;
+    cond[OTRules::COND_OVERRIDE_CH1] = true;
+    sourceValue = 0x3200;
+    rules.apply(OTRules::DIR_REQUEST, m);
+    TEST_ASSERT_EQUAL_HEX32(msg, m);
+}
+
+void test_source_unavailable() {
+    const unsigned long msg = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TsetCH2, 0x2800);
+    unsigned long m = msg;
+    cond[OTRules::COND_OVERRIDE_CH2] = true;
+    sourceValid = false;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_REQUEST, m));
+    TEST_ASSERT_EQUAL_HEX32(msg, m);
+}
+
+void test_status_as_read() {
+    // CH enable of the override is merged, the status is always sent as READ_DATA
+    unsigned long m = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::Status, 0x0200);
+    sourceValue = 0x0100;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_REQUEST, m));
+    TEST_ASSERT_EQUAL_HEX32(request(OpenThermMessageType::READ_DATA, OpenThermMessageID::Status, 0x0300), m);
+}
+
+void test_outside_local() {
+    unsigned long m = response(OpenThermMessageType::DATA_INVALID, OpenThermMessageID::Toutside, 0);
+    cond[OTRules::COND_OUTSIDE_LOCAL] = true;
+    sourceValue = 0xFB00; // -5 degC
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_RESPONSE, m));
+    TEST_ASSERT_EQUAL_HEX32(response(OpenThermMessageType::READ_ACK, OpenThermMessageID::Toutside, 0xFB00), m);
+}
+
+void test_dhw_read_rejected() {
+    unsigned long m = response(OpenThermMessageType::READ_ACK, OpenThermMessageID::TdhwSet, 0x3C00);
+    cond[OTRules::COND_OVERRIDE_DHW] = true;
+    TEST_ASSERT_EQUAL(OTRules::RES_FORWARD, rules.apply(OTRules::DIR_RESPONSE, m));
+    TEST_ASSERT_EQUAL_HEX32(response(OpenThermMessageType::DATA_INVALID, OpenThermMessageID::TdhwSet, 0), m);
+}
+
+void test_direction() {
+    // the TSet rule is for requests only
+    const unsigned long msg = response(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x2800);
+    unsigned long m = msg;
+    cond[OTRules::COND_OVERRIDE_CH1] = true;
+    sourceValue = 0x3200;
+    rules.apply(OTRules::DIR_RESPONSE, m);
+    TEST_ASSERT_EQUAL_HEX32(msg, m);
+}
+
+// the built-in rules keep their slot when the config has too many rules for an ID
+void test_config_full() {
+    JsonDocument doc;
+    deserializeJson(doc, R"([
+        {"id": 1, "mask": "FFFF", "match": "1111", "data": "2222"},
+        {"id": 1, "mask": "FFFF", "match": "1112", "data": "2222"},
+        {"id": 1, "mask": "FFFF", "match": "1113", "data": "2222"},
+        {"id": 1, "mask": "FFFF", "match": "1114", "data": "2222"},
+        {"id": 300, "action": "block"}
+    ])");
+    rules.setConfig(doc.as<JsonArray>());
+    JsonDocument status;
+    JsonObject obj = status.to<JsonObject>();
+    rules.getJson(obj);
+    TEST_ASSERT_EQUAL_UINT32(2, obj["dropped"].as<uint32_t>());
+
+    cond[OTRules::COND_OVERRIDE_CH1] = true;
+    sourceValue = 0x3200;
+    unsigned long m = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x1111);
+    rules.apply(OTRules::DIR_REQUEST, m);
+    TEST_ASSERT_EQUAL_HEX32(request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x2222), m);
+    m = request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x1114);
+    rules.apply(OTRules::DIR_REQUEST, m);
+    TEST_ASSERT_EQUAL_HEX32(request(OpenThermMessageType::WRITE_DATA, OpenThermMessageID::TSet, 0x3200), m);
+
+    rules.setConfig(JsonArray());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_forward_unchanged);
+    RUN_TEST(test_flow_override_inactive);
+    RUN_TEST(test_flow_override);
+    RUN_TEST(test_flow_override_read_not_matched);
+    RUN_TEST(test_source_unavailable);
+    RUN_TEST(test_status_as_read);
+    RUN_TEST(test_outside_local);
+    RUN_TEST(test_dhw_read_rejected);
+    RUN_TEST(test_direction);
+    RUN_TEST(test_config_full);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include <unity.h>
+#include "otscheduler.h"
+
+// periodic job, released period ms after it was sent
+class TestJob: public OTJob {
+public:
+    uint32_t release;
+    uint32_t period;
+    bool active {true};
+    bool hasData {true};
+    unsigned long frame;
+    uint32_t sentAt {0};
+    TestJob(const Priority prio, const uint32_t release, const uint32_t period, const unsigned long frame):
+            OTJob(prio),
+            release(release),
+            period(period),
+            frame(frame) {
+    }
+protected:
+    bool getRelease(const uint32_t, uint32_t &release) override {
+        release = this->release;
+        return active;
+    }
+    bool getRequest(unsigned long &request) override {
+        request = frame;
+        return hasData;
+    }
+    uint32_t getPeriod() const override {
+        return period;
+    }
+    void onSent(const uint32_t now) override {
+        sentAt = now;
+        release = now + period;
+    }
+};
+
+void setUp() {
+    stub::ms = 0;
+    stub::us = 0;
+}
+
+void tearDown() {
+}
+
+void test_nothing_due() {
+    OTScheduler sched;
+    TestJob job(OTJob::PRIO_SENSOR, 1000, 1000, 1);
+    sched.add(&job);
+
+    unsigned long request;
+    stub::ms = 999;
+    TEST_ASSERT_FALSE(sched.next(request));
+    stub::ms = 1000;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(1, request);
+    TEST_ASSERT_EQUAL_UINT32(1000, job.sentAt);
+    TEST_ASSERT_FALSE(sched.next(request));
+}
+
+void test_earliest_deadline_first() {
+    OTScheduler sched;
+    // deadline 0 + 5000 (PRIO_SENSOR) vs. 4000 + 200 (PRIO_STATUS)
+    TestJob sensor(OTJob::PRIO_SENSOR, 0, 10000, 1);
+    TestJob status(OTJob::PRIO_STATUS, 4000, 800, 2);
+    sched.add(&sensor);
+    sched.add(&status);
+
+    unsigned long request;
+    stub::ms = 4500;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(2, request);
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(1, request);
+    TEST_ASSERT_FALSE(sched.next(request));
+}
+
+void test_older_release_first() {
+    OTScheduler sched;
+    // deadline 0 + 5000 (PRIO_SENSOR) vs. 4900 + 1000 (PRIO_CONTROL)
+    TestJob sensor(OTJob::PRIO_SENSOR, 0, 10000, 1);
+    TestJob control(OTJob::PRIO_CONTROL, 4900, 10000, 2);
+    sched.add(&control);
+    sched.add(&sensor);
+
+    unsigned long request;
+    stub::ms = 4900;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(1, request);
+}
+
+void test_same_deadline_by_priority() {
+    OTScheduler sched;
+    // both deadlines at 2000
+    TestJob setpoint(OTJob::PRIO_SETPOINT, 0, 10000, 1);
+    TestJob control(OTJob::PRIO_CONTROL, 1000, 10000, 2);
+    sched.add(&setpoint);
+    sched.add(&control);
+
+    unsigned long request;
+    stub::ms = 1000;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(2, request);
+}
+
+void test_skip_without_data() {
+    OTScheduler sched;
+    TestJob status(OTJob::PRIO_STATUS, 0, 800, 1);
+    TestJob info(OTJob::PRIO_INFO, 0, 10000, 2);
+    status.hasData = false;
+    sched.add(&status);
+    sched.add(&info);
+
+    unsigned long request;
+    stub::ms = 100;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(2, request);
+    TEST_ASSERT_EQUAL_UINT32(0, status.sentAt);
+    TEST_ASSERT_FALSE(sched.next(request));
+}
+
+void test_inactive_job() {
+    OTScheduler sched;
+    TestJob job(OTJob::PRIO_STATUS, 0, 800, 1);
+    job.active = false;
+    sched.add(&job);
+
+    unsigned long request;
+    stub::ms = 100;
+    TEST_ASSERT_FALSE(sched.next(request));
+}
+
+void test_millis_wrap() {
+    OTScheduler sched;
+    // released before the wrap of millis(), the other job after it
+    TestJob before(OTJob::PRIO_INFO, 0xFFFFFF00, 10000, 1);
+    TestJob after(OTJob::PRIO_INFO, 0x100, 10000, 2);
+    sched.add(&after);
+    sched.add(&before);
+
+    unsigned long request;
+    stub::ms = 0x80;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(1, request);
+    TEST_ASSERT_FALSE(sched.next(request));
+    stub::ms = 0x100;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_EQUAL_UINT32(2, request);
+}
+
+void test_add_twice() {
+    OTScheduler sched;
+    TestJob job(OTJob::PRIO_STATUS, 0, 800, 1);
+    sched.add(&job);
+    sched.add(&job);
+
+    unsigned long request;
+    TEST_ASSERT_TRUE(sched.next(request));
+    TEST_ASSERT_FALSE(sched.next(request));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_due);
+    RUN_TEST(test_earliest_deadline_first);
+    RUN_TEST(test_older_release_first);
+    RUN_TEST(test_same_deadline_by_priority);
+    RUN_TEST(test_skip_without_data);
+    RUN_TEST(test_inactive_job);
+    RUN_TEST(test_millis_wrap);
+    RUN_TEST(test_add_twice);
+    return UNITY_END();
+}